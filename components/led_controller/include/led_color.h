@@ -0,0 +1,149 @@
+/**
+ * @file led_color.h
+ * @brief Integer HSV / HSL color conversion and output tables
+ *
+ * All kernels use 8-bit integer math (no float, no division on the
+ * HSV -> RGB path), so effects can convert every pixel of every frame.
+ * Hue runs from 0 to LED_HUE_MAX - 1 (256 steps per 60 degrees),
+ * saturation, value and lightness from 0 to 255. No ESP-IDF dependencies
+ * beyond the types in led_controller.h, so it can be unit-tested on the
+ * host.
+ */
+
+#ifndef LED_COLOR_H
+#define LED_COLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of hue steps in a full circle (6 sectors of 256)
+ */
+#define LED_HUE_MAX         1536
+
+/**
+ * @brief Hue from degrees (0-359)
+ */
+#define LED_HUE_FROM_DEG(deg)   ((uint16_t)(((uint32_t)(deg) * LED_HUE_MAX + 180) / 360 % LED_HUE_MAX))
+
+/**
+ * @brief HSV color
+ */
+typedef struct {
+    uint16_t h;     ///< Hue (0 - LED_HUE_MAX-1)
+    uint8_t s;      ///< Saturation (0-255)
+    uint8_t v;      ///< Value (0-255)
+} led_hsv_t;
+
+/**
+ * @brief HSL color
+ */
+typedef struct {
+    uint16_t h;     ///< Hue (0 - LED_HUE_MAX-1)
+    uint8_t s;      ///< Saturation (0-255)
+    uint8_t l;      ///< Lightness (0-255)
+} led_hsl_t;
+
+/**
+ * @brief Convert HSV to RGB
+ *
+ * @param hsv Color (hue wraps around)
+ * @return RGB color
+ */
+led_rgb_t led_hsv_to_rgb(led_hsv_t hsv);
+
+/**
+ * @brief Convert RGB to HSV
+ *
+ * Greys get hue 0; a round trip is exact to +-1 per channel.
+ *
+ * @param rgb Color
+ * @return HSV color
+ */
+led_hsv_t led_rgb_to_hsv(led_rgb_t rgb);
+
+/**
+ * @brief Convert HSL to RGB
+ *
+ * @param hsl Color (hue wraps around)
+ * @return RGB color
+ */
+led_rgb_t led_hsl_to_rgb(led_hsl_t hsl);
+
+/**
+ * @brief Convert RGB to HSL
+ *
+ * @param rgb Color
+ * @return HSL color
+ */
+led_hsl_t led_rgb_to_hsl(led_rgb_t rgb);
+
+/**
+ * @brief Convert a span of HSV pixels to RGB
+ *
+ * @param in HSV pixels
+ * @param out RGB pixels
+ * @param count Number of pixels
+ */
+void led_hsv_to_rgb_span(const led_hsv_t *in, led_rgb_t *out, size_t count);
+
+/**
+ * @brief Convert a span of RGB pixels to HSV
+ *
+ * @param in RGB pixels
+ * @param out HSV pixels
+ * @param count Number of pixels
+ */
+void led_rgb_to_hsv_span(const led_rgb_t *in, led_hsv_t *out, size_t count);
+
+/**
+ * @brief Fill a span with a hue gradient
+ *
+ * Pixel i gets hue start + i * step (wrapping), e.g. a rainbow when
+ * step * count == LED_HUE_MAX.
+ *
+ * @param out RGB pixels
+ * @param count Number of pixels
+ * @param hue_start Hue of the first pixel
+ * @param hue_step Hue increment per pixel in 1/256 hue steps (Q8)
+ * @param s Saturation
+ * @param v Value
+ */
+void led_hue_gradient(led_rgb_t *out, size_t count, uint16_t hue_start, uint32_t hue_step,
+                      uint8_t s, uint8_t v);
+
+/**
+ * @brief Rotate the hue of a span of RGB pixels
+ *
+ * @param pixels RGB pixels, converted in place
+ * @param count Number of pixels
+ * @param delta Hue rotation (any value, wraps around)
+ */
+void led_hue_rotate_span(led_rgb_t *pixels, size_t count, int32_t delta);
+
+/**
+ * @brief Build a channel output table: intensity, brightness limit and gamma
+ *
+ * lut[v] = round(255 * (v/255 * intensity/255 * max_brightness/255)^2.2),
+ * or the linear product without gamma. The product is gamma-corrected at
+ * 16-bit precision and rounded once, so every entry is within 1 of the
+ * exact value. With gamma, outputs below 0.5 round to 0: at full color,
+ * intensity 14 or less is dark (8-bit output cannot be dimmer than 1/255).
+ *
+ * @param lut Output table
+ * @param intensity Intensity (0-255)
+ * @param max_brightness Brightness limit (0-255)
+ * @param gamma Apply gamma 2.2
+ */
+void led_output_lut(uint8_t lut[256], uint8_t intensity, uint8_t max_brightness, bool gamma);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_COLOR_H
@@ -0,0 +1,163 @@
+/**
+ * @file led_command.h
+ * @brief LED commands and the lock-free queue that carries them to the LED task
+ *
+ * All state changes of the LED controller are posted as commands and
+ * applied by the LED task alone, so the state has a single owner and is
+ * never seen half-written. The queue is a bounded multi-producer /
+ * single-consumer ring: producers claim a slot with one compare-and-swap
+ * and never block, a full queue rejects the command. No ESP-IDF
+ * dependencies beyond the types in led_controller.h, so it can be
+ * unit-tested on the host.
+ */
+
+#ifndef LED_COMMAND_H
+#define LED_COMMAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Queue capacity in commands (power of two)
+ */
+#define LED_COMMAND_QUEUE_LEN   SMARTLOVE_LED_COMMAND_QUEUE_LEN
+
+_Static_assert((LED_COMMAND_QUEUE_LEN & (LED_COMMAND_QUEUE_LEN - 1)) == 0 &&
+               LED_COMMAND_QUEUE_LEN >= 2,
+               "SMARTLOVE_LED_COMMAND_QUEUE_LEN must be a power of two");
+
+/**
+ * @brief Command types
+ */
+typedef enum {
+    LED_CMD_INTENSITY = 0,      ///< Set intensity, 0 turns the LEDs off
+    LED_CMD_COLOR,              ///< Set color and fill the framebuffer
+    LED_CMD_RANGE,              ///< Fill a framebuffer range with a color
+    LED_CMD_COMMIT,             ///< Take over staged pixels and show them
+    LED_CMD_ANIMATION,          ///< Select an animation
+    LED_CMD_FADE,               ///< Fade to a color
+    LED_CMD_ON,                 ///< Turn the LEDs on
+    LED_CMD_OFF,                ///< Turn the LEDs off
+    LED_CMD_TIMELINE_LOAD,      ///< Take over the uploaded timeline and start it
+    LED_CMD_TIMELINE_PLAY,      ///< Play or resume the timeline
+    LED_CMD_TIMELINE_PAUSE,     ///< Pause the timeline
+    LED_CMD_TIMELINE_SEEK,      ///< Move the timeline position
+} led_command_type_t;
+
+/**
+ * @brief Producers of staged pixels, each with its own staging buffers
+ */
+typedef enum {
+    LED_SOURCE_COMMAND = 0,     ///< set_pixels, binary frames, JSON pixels (MQTT task)
+    LED_SOURCE_REALTIME,        ///< write_framebuffer / show_frame (realtime receiver)
+    LED_SOURCE_COUNT
+} led_source_t;
+
+/**
+ * @brief Origin of a command: start time and latency trace of the message
+ * that carried it (all zero for direct API calls)
+ */
+typedef struct {
+    int64_t at_us;          ///< Local time to apply at (esp_timer), 0 = now
+    int64_t rx_us;          ///< Receive time of the message, 0 = not traced
+    uint32_t parse_us;      ///< Receive to parsed
+} led_command_meta_t;
+
+/**
+ * @brief One command (fixed size, copied by value into the queue)
+ */
+typedef struct {
+    led_command_type_t type;
+    led_command_meta_t meta;
+    union {
+        uint8_t intensity;                  ///< LED_CMD_INTENSITY
+        led_rgb_t color;                    ///< LED_CMD_COLOR
+        struct {
+            uint16_t start;
+            uint16_t count;
+            led_rgb_t color;
+        } range;                            ///< LED_CMD_RANGE
+        struct {
+            led_source_t source;            ///< Producer of the staged pixels
+            uint32_t frame;                 ///< Its staged frame to apply (and earlier ones)
+            bool stream_frame;              ///< Count as displayed binary frame
+        } commit;                           ///< LED_CMD_COMMIT
+        led_animation_t animation;          ///< LED_CMD_ANIMATION
+        struct {
+            led_rgb_t target;
+            uint32_t duration_ms;
+            led_easing_t easing;
+        } fade;                             ///< LED_CMD_FADE
+        bool autoplay;                      ///< LED_CMD_TIMELINE_LOAD, false = paused at 0
+        uint32_t position_ms;               ///< LED_CMD_TIMELINE_SEEK
+    };
+} led_command_t;
+
+/**
+ * @brief Queue slot; seq tells producers and the consumer whose turn it is
+ */
+typedef struct {
+    atomic_uint_fast32_t seq;
+    led_command_t cmd;
+} led_command_slot_t;
+
+/**
+ * @brief Command queue
+ */
+typedef struct {
+    led_command_slot_t slots[LED_COMMAND_QUEUE_LEN];
+    atomic_uint_fast32_t tail;      ///< Next slot to claim (producers)
+    uint32_t head;                  ///< Next slot to read (consumer only)
+    atomic_uint_fast32_t dropped;   ///< Commands rejected because the queue was full
+} led_command_queue_t;
+
+/**
+ * @brief Reset a queue to empty
+ *
+ * Must not run concurrently with push or pop.
+ *
+ * @param queue Queue
+ */
+void led_command_queue_init(led_command_queue_t *queue);
+
+/**
+ * @brief Add a command (any task, never blocks)
+ *
+ * @param queue Queue
+ * @param cmd Command, copied
+ * @return true if queued, false if the queue was full
+ */
+bool led_command_push(led_command_queue_t *queue, const led_command_t *cmd);
+
+/**
+ * @brief Take the oldest command (consumer task only)
+ *
+ * @param queue Queue
+ * @param cmd Output command
+ * @return true if a command was taken, false if the queue is empty
+ */
+bool led_command_pop(led_command_queue_t *queue, led_command_t *cmd);
+
+/**
+ * @brief Check that LEDs [start, start + count) lie on the strip
+ *
+ * For untrusted values (JSON): negative or huge values are rejected
+ * without the sum overflowing.
+ *
+ * @param start First LED
+ * @param count Number of LEDs
+ * @return true if the range fits, also for count 0 up to the strip end
+ */
+bool led_command_range_valid(int start, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_COMMAND_H
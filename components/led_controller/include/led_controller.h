@@ -7,6 +7,7 @@
 #define LED_CONTROLLER_H
 
 #include "esp_err.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "smartlove_config.h"
@@ -20,9 +21,29 @@ extern "C" {
 // ============================================================================
 
 #define LED_GPIO_PIN            SMARTLOVE_GPIO_LED_STRIP
-#define LED_STRIP_LENGTH        SMARTLOVE_LED_COUNT
+#define LED_LINE_COUNT          SMARTLOVE_LED_LINE_COUNT
+#define LED_LINE_LENGTH         SMARTLOVE_LED_COUNT
+#define LED_STRIP_LENGTH        (LED_LINE_LENGTH * LED_LINE_COUNT)
 #define LED_MAX_BRIGHTNESS      SMARTLOVE_LED_MAX_BRIGHTNESS
 #define LED_RMT_CHANNEL         SMARTLOVE_LED_RMT_CHANNEL
+#define LED_FRAME_RATE          SMARTLOVE_LED_FRAME_RATE
+#define LED_SCHEDULED_MAX       SMARTLOVE_LED_SCHEDULED_MAX
+#define LED_BLINK_INTERVAL_MS   SMARTLOVE_LED_BLINK_INTERVAL_MS
+
+// ============================================================================
+// Binary Frame Format
+// ============================================================================
+
+/**
+ * @brief Length of the optional binary frame header
+ *
+ * A frame payload is either raw RGB data for LED 0 onwards (length a
+ * multiple of 3) or a header followed by pixel data (length 3n + 4):
+ * [format, reserved, offset high byte, offset low byte].
+ */
+#define LED_FRAME_HEADER_LEN    4
+#define LED_FRAME_FORMAT_RGB    'R'     ///< Header format: RGB byte order
+#define LED_FRAME_FORMAT_GRB    'G'     ///< Header format: GRB byte order
 
 // ============================================================================
 // Types
@@ -43,9 +64,26 @@ typedef struct {
 typedef enum {
     LED_ANIM_NONE = 0,      ///< No animation, static color
     LED_ANIM_BLINK,         ///< Blink animation (0.5s interval)
-    LED_ANIM_FADE           ///< Fade to new color
+    LED_ANIM_FADE,          ///< Fade to new color
+    LED_ANIM_RAINBOW,       ///< Rainbow moving along the strip
+    LED_ANIM_CHASE,         ///< Running light in the current color
+    LED_ANIM_BREATHE,       ///< Slow brightness pulse
+    LED_ANIM_TWINKLE,       ///< Random sparkles in the current color
+    LED_ANIM_TIMELINE,      ///< Uploaded keyframe timeline
+    LED_ANIM_BUILTIN_COUNT  ///< First id for effects from led_effect_register()
 } led_animation_t;
 
+/**
+ * @brief Fade easing curves
+ */
+typedef enum {
+    LED_EASE_LINEAR = 0,    ///< Constant speed
+    LED_EASE_IN,            ///< Quadratic, slow start
+    LED_EASE_OUT,           ///< Quadratic, slow end
+    LED_EASE_IN_OUT,        ///< Quadratic, slow start and end
+    LED_EASE_EXPO           ///< Exponential, perceptually even for brightness
+} led_easing_t;
+
 /**
  * @brief LED Controller state
  */
@@ -56,18 +94,61 @@ typedef struct {
     led_rgb_t fade_target;       ///< Target color for fade
     uint32_t fade_time_ms;       ///< Fade duration in ms
     uint32_t fade_elapsed_ms;    ///< Fade elapsed time
+    led_easing_t fade_easing;    ///< Fade easing curve
     led_animation_t animation;   ///< Current animation
     bool is_on;                  ///< LED strip on/off state
+    uint16_t timeline_keyframes; ///< Keyframes of the loaded timeline
+    uint32_t timeline_position_ms; ///< Timeline position (wrapped when looping)
+    bool timeline_paused;        ///< Timeline is paused
 } led_state_t;
 
+/**
+ * @brief Keyframe timeline, see led_timeline.h
+ */
+typedef struct led_timeline led_timeline_t;
+
+/**
+ * @brief Latency summary per stage, see led_latency.h
+ */
+typedef struct led_latency_stats led_latency_stats_t;
+
+/**
+ * @brief LED output statistics (summed over all lines)
+ */
+typedef struct {
+    uint32_t frames_sent;        ///< Frames sent to the strip
+    uint32_t frames_skipped;     ///< Refreshes skipped because nothing changed
+    uint32_t stream_frames_received;  ///< Binary frames received
+    uint32_t stream_frames_displayed; ///< Binary frames shown on the LEDs
+    uint32_t effect_frames;      ///< Frames rendered by the effect scheduler
+    uint32_t deadlines_missed;   ///< Effect frames that overran their period
+    uint32_t render_us_last;     ///< Render time of the last effect frame
+    uint32_t render_us_max;      ///< Maximum render time
+    uint32_t transmit_us_last;   ///< Output time (gamma + encode + start) of the last frame
+    uint32_t transmit_us_max;    ///< Maximum output time
+    uint32_t commands_dropped;   ///< Commands rejected because the queue was full
+    uint32_t state_writes;       ///< Saved-state flash writes since boot
+    uint32_t state_writes_total; ///< Saved-state flash writes over the device lifetime
+} led_stats_t;
+
 // ============================================================================
 // API Functions
 // ============================================================================
 
+/*
+ * The setters below may be called from any task. They queue a command for
+ * the LED task, which owns the LED state, and return without waiting for
+ * it; ESP_ERR_NO_MEM means the command queue was full and the command was
+ * dropped. Commands are applied in the order they were queued.
+ */
+
 /**
  * @brief Initialize LED controller
  * 
- * Initializes the WS2812B LED strip on the configured GPIO pin
+ * Initializes the WS2812B LED strip on the configured GPIO pin. A state
+ * saved before the last reboot is restored and its first frame started
+ * before this returns, so NVS must be initialized first; it needs no
+ * networking and should run early in boot.
  * 
  * @return ESP_OK on success, error code otherwise
  */
@@ -98,6 +179,81 @@ esp_err_t led_controller_set_intensity(uint8_t intensity);
  */
 esp_err_t led_controller_set_color(uint8_t r, uint8_t g, uint8_t b);
 
+/**
+ * @brief Set a run of individual pixels
+ *
+ * Pixel colors are stored before intensity and gamma, index 0 is the first
+ * LED of line 0 followed by the remaining lines back to back.
+ *
+ * Stages into the same buffer as led_controller_write_frame() and JSON
+ * "pixels", so call it from the task that handles MQTT messages.
+ *
+ * @param start Index of the first LED
+ * @param pixels Pixel colors
+ * @param count Number of pixels
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the run exceeds the strip,
+ *         ESP_ERR_NO_MEM if the LED task is SMARTLOVE_LED_STAGING_FRAMES
+ *         frames behind (the pixels go out with the next commit)
+ */
+esp_err_t led_controller_set_pixels(uint16_t start, const led_rgb_t *pixels, uint16_t count);
+
+/**
+ * @brief Set a run of pixels to one color
+ *
+ * @param start Index of the first LED
+ * @param count Number of pixels
+ * @param r Red component (0-255)
+ * @param g Green component (0-255)
+ * @param b Blue component (0-255)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the run exceeds the strip
+ */
+esp_err_t led_controller_set_range(uint16_t start, uint16_t count, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Write a binary frame (or one chunk of it) into the framebuffer
+ *
+ * See LED_FRAME_HEADER_LEN for the payload format. Large payloads may be
+ * passed in chunks in order; the frame is shown once the last chunk
+ * arrived, unless the LEDs are off or an animation is running. No JSON
+ * parsing and no heap allocation is involved.
+ *
+ * @param data Chunk data
+ * @param len Chunk length in bytes
+ * @param offset Chunk position in the payload
+ * @param total_len Total payload length
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a malformed frame,
+ *         ESP_ERR_INVALID_STATE for chunks of a rejected frame
+ */
+esp_err_t led_controller_write_frame(const uint8_t *data, size_t len, size_t offset,
+                                     size_t total_len);
+
+/**
+ * @brief Write raw RGB bytes into the framebuffer (without showing)
+ *
+ * Byte @p offset is channel offset % 3 of LED offset / 3, so protocol
+ * payloads that split pixels can be copied as they are. The data goes to a
+ * staging buffer of its own; only one task (the realtime receiver) may use
+ * this and led_controller_show_frame().
+ *
+ * @param offset First framebuffer byte
+ * @param data RGB bytes
+ * @param len Number of bytes
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the data exceeds the strip
+ */
+esp_err_t led_controller_write_framebuffer(size_t offset, const uint8_t *data, size_t len);
+
+/**
+ * @brief Show the framebuffer after led_controller_write_framebuffer()
+ *
+ * Enables the LEDs like led_controller_set_color() does.
+ *
+ * @return ESP_OK if the frame will be shown, ESP_ERR_INVALID_STATE if the
+ *         LEDs are off or an animation is running, ESP_ERR_NO_MEM if the
+ *         LED task is SMARTLOVE_LED_STAGING_FRAMES frames behind (the pixels
+ *         go out with the next frame)
+ */
+esp_err_t led_controller_show_frame(void);
+
 /**
  * @brief Set LED animation
  * 
@@ -117,6 +273,59 @@ esp_err_t led_controller_set_animation(led_animation_t animation);
  */
 esp_err_t led_controller_fade_to(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms);
 
+/**
+ * @brief Fade to a new color with an easing curve
+ *
+ * The fade starts from the currently displayed color, also if another
+ * fade is still running.
+ *
+ * @param r Target red
+ * @param g Target green
+ * @param b Target blue
+ * @param duration_ms Fade duration in ms
+ * @param easing Easing curve
+ * @return ESP_OK on success
+ */
+esp_err_t led_controller_fade_to_ex(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms,
+                                    led_easing_t easing);
+
+/**
+ * @brief Upload a keyframe timeline and play it on the LED task
+ *
+ * The timeline is copied, so the caller's buffer can be reused right away.
+ *
+ * @param timeline Timeline (see led_timeline.h)
+ * @param autoplay true to start playing, false to show the first keyframe
+ *                 and wait for led_controller_timeline_play()
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid timeline,
+ *         ESP_ERR_INVALID_STATE while the previous upload is not taken over yet
+ */
+esp_err_t led_controller_load_timeline(const led_timeline_t *timeline, bool autoplay);
+
+/**
+ * @brief Play the loaded timeline, or resume it after a pause
+ *
+ * A timeline without loop that has ended starts again from 0.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t led_controller_timeline_play(void);
+
+/**
+ * @brief Pause the timeline at its current position
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t led_controller_timeline_pause(void);
+
+/**
+ * @brief Move the timeline to a position
+ *
+ * @param position_ms New position
+ * @return ESP_OK on success
+ */
+esp_err_t led_controller_timeline_seek(uint32_t position_ms);
+
 /**
  * @brief Process JSON command
  * 
@@ -128,14 +337,64 @@ esp_err_t led_controller_fade_to(uint8_t r, uint8_t g, uint8_t b, uint32_t durat
  *     "g": 0-255,
  *     "b": 0-255
  *   },
- *   "show": "BLINK"         // Optional: animation code
+ *   "range": {              // Optional: one or an array of segments
+ *     "start": 0, "count": 10, "color": {"r": .., "g": .., "b": ..}
+ *   },
+ *   "pixels": [r, g, b, ...], // Optional: RGB triplets from "start"
+ *   "start": 0,             // Optional: first LED for "pixels"
+ *   "show": "BLINK",        // Optional: animation code
+ *   "fade_ms": 1000,        // Optional: fade duration for "FADE"
+ *   "easing": "ease-in-out", // Optional: fade curve for "FADE"
+ *   "timeline": {           // Optional: upload and play a timeline
+ *     "loop": true, "duration_ms": 4000, "autoplay": true,
+ *     "keyframes": [{"t": 0, "color": {..}, "intensity": 255,
+ *                    "transition": "linear"}, [t, r, g, b, intensity], ...]
+ *   },
+ *   "seek_ms": 1500,        // Optional: timeline position
+ *   "player": "pause",      // Optional: "play", "pause" or "stop"
+ *   "start_at": 1700000000000 // Optional: apply all of the above at this
+ *                           // Unix time in ms (shared clock, see time_sync.h)
  * }
  * 
+ * With "start_at" the LED task holds the commands until that time, and
+ * effects, fades and timelines take it as their start, so devices that
+ * received the message at different times run in phase. A time already
+ * past starts them at once, at the phase they would have reached. Without
+ * a synced clock "start_at" is ignored. "pixels" are staged on arrival and
+ * shown at "start_at".
+ * 
  * @param json_str JSON command string
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t led_controller_process_json(const char *json_str);
 
+/**
+ * @brief Process JSON command received at a known time
+ * 
+ * Like led_controller_process_json(), and the commands are traced from
+ * rx_us to the LEDs for led_controller_get_latency().
+ * 
+ * @param json_str JSON command string
+ * @param rx_us Receive time of the message (esp_timer_get_time()), 0 = now
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_controller_process_json_ex(const char *json_str, int64_t rx_us);
+
+/**
+ * @brief Process a JSON command given by pointer and length
+ * 
+ * Like led_controller_process_json_ex(), for messages that are not
+ * NUL-terminated (e.g. straight from a receive buffer). The message is
+ * parsed in place without heap allocation; it only needs to stay valid
+ * for the duration of the call.
+ * 
+ * @param json JSON command
+ * @param len Length of the command in bytes
+ * @param rx_us Receive time of the message (esp_timer_get_time()), 0 = now
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_controller_process_json_len(const char *json, size_t len, int64_t rx_us);
+
 /**
  * @brief Turn LEDs on
  * 
@@ -146,6 +405,8 @@ esp_err_t led_controller_on(void);
 /**
  * @brief Turn LEDs off
  * 
+ * A running animation is paused and continues with led_controller_on().
+ * 
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t led_controller_off(void);
@@ -153,11 +414,40 @@ esp_err_t led_controller_off(void);
 /**
  * @brief Get current LED state
  * 
+ * Returns a consistent snapshot of the state the LED task last applied
+ * (commands still queued are not included). Never blocks.
+ * 
  * @param state Pointer to state structure to fill
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t led_controller_get_state(led_state_t *state);
 
+/**
+ * @brief Get LED output statistics
+ * 
+ * @param stats Pointer to statistics structure to fill
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_controller_get_stats(led_stats_t *stats);
+
+/**
+ * @brief Get command-to-photon latency per stage
+ * 
+ * Covers JSON commands from led_controller_process_json_ex() (receive to
+ * latched on the strip) since start or the last reset.
+ * 
+ * @param stats Pointer to statistics structure to fill
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_controller_get_latency(led_latency_stats_t *stats);
+
+/**
+ * @brief Clear the latency histograms
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t led_controller_reset_latency(void);
+
 #ifdef __cplusplus
 }
 #endif
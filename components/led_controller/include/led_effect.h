@@ -0,0 +1,121 @@
+/**
+ * @file led_effect.h
+ * @brief LED effect plug-in interface and registry
+ *
+ * An effect renders one frame into a pixel buffer from the frame time; the
+ * LED task calls it at a fixed rate (SMARTLOVE_LED_FRAME_RATE) and takes
+ * care of intensity, gamma and output. Effects keep no timing of their own,
+ * so frame timing is the same for every effect.
+ *
+ * Built-in effects: blink, fade, rainbow, chase, breathe, twinkle, timeline. Further
+ * effects are added with led_effect_register(), without touching the LED
+ * task. Integer HSV/HSL helpers for effects are in led_color.h.
+ */
+
+#ifndef LED_EFFECT_H
+#define LED_EFFECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of registered effects (built-in included)
+ */
+#define LED_EFFECT_MAX          16
+
+/**
+ * @brief One frame to render
+ */
+typedef struct {
+    led_rgb_t *pixels;          ///< Output, keeps the previous frame (zeroed at start)
+    const led_rgb_t *base;      ///< Static content (colors / pixels set by commands)
+    uint16_t count;             ///< Number of pixels
+    led_rgb_t color;            ///< Base color; effects may update it to the shown color
+    int64_t time_us;            ///< Frame time (esp_timer clock)
+    uint32_t elapsed_ms;        ///< Time since the effect started
+    uint32_t frame;             ///< Frames rendered since the effect started
+    void *arg;                  ///< Effect argument (led_effect_t::arg)
+} led_effect_frame_t;
+
+/**
+ * @brief Effect descriptor
+ */
+typedef struct {
+    const char *name;           ///< Name used by the JSON "show" field
+
+    /**
+     * @brief Render one frame
+     *
+     * @return true to continue, false when the effect is finished; its last
+     *         frame then becomes the static content
+     */
+    bool (*render)(led_effect_frame_t *frame);
+
+    void *arg;                  ///< Passed to render() in led_effect_frame_t::arg
+} led_effect_t;
+
+/**
+ * @brief Register an effect under a new animation id
+ *
+ * @param effect Effect descriptor (must stay valid)
+ * @param id Animation id to use with led_controller_set_animation()
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the registry is full,
+ *         ESP_ERR_INVALID_STATE if the name is taken
+ */
+esp_err_t led_effect_register(const led_effect_t *effect, led_animation_t *id);
+
+/**
+ * @brief Register or replace the effect of a fixed animation id
+ *
+ * Used for built-in ids whose effect needs state owned elsewhere (the
+ * controller registers its fade this way), or to replace a built-in.
+ *
+ * @param id Animation id (not LED_ANIM_NONE)
+ * @param effect Effect descriptor (must stay valid)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid id
+ */
+esp_err_t led_effect_register_as(led_animation_t id, const led_effect_t *effect);
+
+/**
+ * @brief Get the effect of an animation id
+ *
+ * @param id Animation id
+ * @return Effect, NULL for LED_ANIM_NONE and unknown ids
+ */
+const led_effect_t *led_effect_get(led_animation_t id);
+
+/**
+ * @brief Look up an effect by name (case-insensitive)
+ *
+ * @param name Effect name
+ * @param id Animation id of the effect
+ * @return true if found
+ */
+bool led_effect_find(const char *name, led_animation_t *id);
+
+/**
+ * @brief Fade renderer, arg is the led_fade_t to play
+ *
+ * Fills all pixels with the fade color and reports it in frame->color.
+ */
+bool led_effect_fade_render(led_effect_frame_t *frame);
+
+/**
+ * @brief Timeline renderer, arg is the led_timeline_player_t to play
+ *
+ * Fills all pixels with the timeline color and reports it in frame->color.
+ * An empty timeline keeps the static content.
+ */
+bool led_effect_timeline_render(led_effect_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_EFFECT_H
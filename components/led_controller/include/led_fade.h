@@ -0,0 +1,96 @@
+/**
+ * @file led_fade.h
+ * @brief Fixed-point color fade with easing curves
+ *
+ * The fade position is derived from elapsed time, not from counted steps,
+ * so a late frame never stretches the fade. All math is integer (Q16) and
+ * constant time per sample; no ESP-IDF dependencies beyond the types in
+ * led_controller.h, so it can be unit-tested on the host.
+ */
+
+#ifndef LED_FADE_H
+#define LED_FADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 1.0 in the Q16 fixed-point format used for fade progress
+ */
+#define LED_FADE_ONE (1UL << 16)
+
+/**
+ * @brief Fade state
+ */
+typedef struct {
+    led_rgb_t from;          ///< Color at start
+    led_rgb_t to;            ///< Color at end
+    int64_t start_us;        ///< Start time (esp_timer time base)
+    uint64_t duration_us;    ///< Duration, 0 = jump to target (ms * 1000 does not fit 32 bits)
+    led_easing_t easing;     ///< Easing curve
+} led_fade_t;
+
+/**
+ * @brief Apply an easing curve
+ *
+ * @param easing Easing curve
+ * @param t Linear progress, 0..LED_FADE_ONE
+ * @return Eased progress, 0..LED_FADE_ONE
+ */
+uint32_t led_ease(led_easing_t easing, uint32_t t);
+
+/**
+ * @brief Start a fade
+ *
+ * @param fade Fade state to initialize
+ * @param from Start color
+ * @param to Target color
+ * @param duration_ms Duration in ms
+ * @param easing Easing curve
+ * @param now_us Current time in us
+ */
+void led_fade_start(led_fade_t *fade, led_rgb_t from, led_rgb_t to,
+                    uint32_t duration_ms, led_easing_t easing, int64_t now_us);
+
+/**
+ * @brief Get the fade color at a point in time
+ *
+ * @param fade Fade state
+ * @param now_us Current time in us
+ * @param out Color at now_us
+ * @return true once the fade has reached its target
+ */
+bool led_fade_sample(const led_fade_t *fade, int64_t now_us, led_rgb_t *out);
+
+/**
+ * @brief Mix two colors
+ *
+ * @param from Color at k = 0
+ * @param to Color at k = LED_FADE_ONE
+ * @param k Eased progress, 0..LED_FADE_ONE
+ * @return Mixed color
+ */
+led_rgb_t led_fade_mix(led_rgb_t from, led_rgb_t to, uint32_t k);
+
+/**
+ * @brief Look up an easing curve by name
+ *
+ * Accepts "linear", "ease-in", "ease-out", "ease-in-out" and "exp"
+ * (case-insensitive).
+ *
+ * @param name Easing name
+ * @param easing Output easing
+ * @return true if the name is known
+ */
+bool led_easing_from_name(const char *name, led_easing_t *easing);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_FADE_H
@@ -0,0 +1,161 @@
+/**
+ * @file led_json.h
+ * @brief Allocation-free JSON tokenizer for LED commands
+ *
+ * One pass over the message fills a caller-provided token array; values
+ * are then read straight from the message text through the tokens, so a
+ * command is decoded without touching the heap and without copying the
+ * message. Tokens are stored in document order with the index of the
+ * next sibling, so objects and arrays are walked without searching.
+ * No ESP-IDF dependencies, so it can be unit-tested on the host.
+ */
+
+#ifndef LED_JSON_H
+#define LED_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum message length (token offsets are 16 bit)
+ */
+#define LED_JSON_MAX_LEN    (UINT16_MAX - 1)
+
+/**
+ * @brief Maximum nesting of objects and arrays
+ */
+#define LED_JSON_MAX_DEPTH  8
+
+/**
+ * @brief Value types (LED_JSON_NONE for a missing value)
+ */
+typedef enum {
+    LED_JSON_NONE = 0,
+    LED_JSON_OBJECT,
+    LED_JSON_ARRAY,
+    LED_JSON_STRING,
+    LED_JSON_NUMBER,
+    LED_JSON_TRUE,
+    LED_JSON_FALSE,
+    LED_JSON_NULL,
+} led_json_type_t;
+
+/**
+ * @brief One token: a value, or an object key (a string)
+ */
+typedef struct {
+    uint8_t type;       ///< led_json_type_t
+    uint16_t size;      ///< Members of an object, elements of an array
+    uint16_t start;     ///< First byte (after the quote for strings)
+    uint16_t end;       ///< One past the last byte (before the quote for strings)
+    uint16_t next;      ///< Index of the token after this value and its children
+} led_json_token_t;
+
+/**
+ * @brief Tokenized document
+ *
+ * Values are referred to by token index; the root is 0 and -1 stands for
+ * a missing value, which every accessor accepts.
+ */
+typedef struct {
+    const char *json;
+    const led_json_token_t *tokens;
+    uint16_t count;         ///< Tokens used
+    const char *error;      ///< Reason if parsing failed
+    size_t error_pos;       ///< Byte offset of the error
+} led_json_t;
+
+/**
+ * @brief Tokenize a message
+ *
+ * Parses the first JSON value of the message and ignores anything after
+ * it, like cJSON_Parse(). The message need not be NUL-terminated and must
+ * outlive the document.
+ *
+ * @param doc Output document
+ * @param json Message
+ * @param len Message length (at most LED_JSON_MAX_LEN)
+ * @param tokens Token array
+ * @param max_tokens Size of the token array
+ * @return true on success, false on a syntax error or if the message
+ *         needs more tokens or nesting than available (see doc->error)
+ */
+bool led_json_parse(led_json_t *doc, const char *json, size_t len,
+                    led_json_token_t *tokens, uint16_t max_tokens);
+
+/**
+ * @brief Type of a value (LED_JSON_NONE for -1)
+ */
+led_json_type_t led_json_type(const led_json_t *doc, int value);
+
+/**
+ * @brief Members of an object or elements of an array (0 otherwise)
+ */
+int led_json_size(const led_json_t *doc, int value);
+
+/**
+ * @brief First element of an array, -1 if empty or not an array
+ */
+int led_json_first(const led_json_t *doc, int array);
+
+/**
+ * @brief Element following an array element
+ */
+int led_json_next(const led_json_t *doc, int value);
+
+/**
+ * @brief Look up several object members in one pass
+ *
+ * Keys are compared case-insensitively and the first member of a name
+ * wins, like cJSON_GetObjectItem().
+ *
+ * @param doc Document
+ * @param object Object (anything else finds no members)
+ * @param keys Member names
+ * @param key_count Number of names
+ * @param values Output: value of each name, -1 if missing
+ */
+void led_json_get_members(const led_json_t *doc, int object, const char *const *keys,
+                          int key_count, int *values);
+
+/**
+ * @brief Look up one object member, -1 if missing
+ */
+int led_json_find(const led_json_t *doc, int object, const char *key);
+
+/**
+ * @brief Read a number
+ *
+ * @return false if the value is not a number
+ */
+bool led_json_get_number(const led_json_t *doc, int value, double *out);
+
+/**
+ * @brief Read a number as int (fraction truncated, saturated like cJSON's valueint)
+ *
+ * @return false if the value is not a number
+ */
+bool led_json_get_int(const led_json_t *doc, int value, int *out);
+
+/**
+ * @brief Copy a string with escapes resolved, NUL-terminated
+ *
+ * @return false if the value is not a string or does not fit
+ */
+bool led_json_get_string(const led_json_t *doc, int value, char *buf, size_t size);
+
+/**
+ * @brief Check for true
+ */
+bool led_json_is_true(const led_json_t *doc, int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_JSON_H
@@ -0,0 +1,99 @@
+/**
+ * @file led_latency.h
+ * @brief Command-to-photon latency histograms
+ *
+ * A command is traced from the receipt of its message to the moment the
+ * LED strip has latched the frame it changed, split into stages. Each
+ * stage is kept in a log-linear histogram (4 buckets per power of two,
+ * resolution 25 %, up to 33 s), so p50/p99 cost no memory per sample. No
+ * ESP-IDF dependencies, so it can be unit-tested on the host.
+ */
+
+#ifndef LED_LATENCY_H
+#define LED_LATENCY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stages of the command-to-photon path
+ */
+typedef enum {
+    LED_LATENCY_PARSE = 0,      ///< Message received to JSON parsed
+    LED_LATENCY_APPLY,          ///< Parsed to applied by the LED task
+    LED_LATENCY_ENCODE,         ///< Applied to frame encoded and started
+    LED_LATENCY_OUTPUT,         ///< Started to sent and latched (RMT done)
+    LED_LATENCY_TOTAL,          ///< Message received to sent and latched
+    LED_LATENCY_STAGE_COUNT
+} led_latency_stage_t;
+
+#define LED_LATENCY_BUCKETS     96
+
+/**
+ * @brief Histogram of one stage
+ */
+typedef struct {
+    uint32_t buckets[LED_LATENCY_BUCKETS];
+    uint32_t samples;
+    uint32_t max_us;
+} led_latency_hist_t;
+
+/**
+ * @brief Summary of one stage
+ */
+typedef struct {
+    uint32_t samples;
+    uint32_t p50_us;            ///< Median (bucket upper bound)
+    uint32_t p99_us;            ///< 99th percentile (bucket upper bound)
+    uint32_t max_us;
+} led_latency_summary_t;
+
+/**
+ * @brief Summary of all stages
+ */
+typedef struct led_latency_stats {
+    led_latency_summary_t stages[LED_LATENCY_STAGE_COUNT];
+    uint32_t traces_unchanged;  ///< Traced commands that changed no LED (no output stage)
+} led_latency_stats_t;
+
+/**
+ * @brief Add a sample
+ *
+ * @param hist Histogram
+ * @param us Latency in us
+ */
+void led_latency_record(led_latency_hist_t *hist, uint32_t us);
+
+/**
+ * @brief Get a percentile
+ *
+ * @param hist Histogram
+ * @param percent Percentile (1-100)
+ * @return Upper bound of the bucket holding it (at most max_us), 0 without samples
+ */
+uint32_t led_latency_percentile(const led_latency_hist_t *hist, uint32_t percent);
+
+/**
+ * @brief Summarize a histogram
+ *
+ * @param hist Histogram
+ * @param out Samples, p50, p99 and maximum
+ */
+void led_latency_summarize(const led_latency_hist_t *hist, led_latency_summary_t *out);
+
+/**
+ * @brief Get the name of a stage, e.g. "parse"
+ *
+ * @param stage Stage
+ * @return Name
+ */
+const char *led_latency_stage_name(led_latency_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_LATENCY_H
@@ -0,0 +1,84 @@
+/**
+ * @file led_persist.h
+ * @brief Persisted LED state (NVS) with a debounced, coalescing writer
+ *
+ * The LED task hands over its state after every change; a low-priority
+ * writer task collects the changes for SMARTLOVE_LED_PERSIST_WINDOW_MS
+ * and then writes the latest state once, and only if it differs from what
+ * is already in flash. Handing over never blocks, so flash writes (which
+ * stall for milliseconds while a page is erased) stay off the LED path.
+ */
+
+#ifndef LED_PERSIST_H
+#define LED_PERSIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Persisted part of the LED state
+ */
+typedef struct {
+    bool is_on;
+    uint8_t intensity;
+    led_rgb_t color;
+    led_animation_t animation;  ///< Built-in animation, never FADE or TIMELINE
+} led_persist_state_t;
+
+/**
+ * @brief Writer statistics
+ */
+typedef struct {
+    uint32_t writes;            ///< Writes since boot
+    uint32_t writes_total;      ///< Writes over the lifetime of the NVS entry
+    uint32_t skipped;           ///< Windows that ended with the state already saved
+    uint32_t errors;            ///< Failed writes
+} led_persist_stats_t;
+
+/**
+ * @brief Read the saved state (NVS must be initialized)
+ *
+ * @param state Output state
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if nothing (valid) is saved, or an NVS error
+ */
+esp_err_t led_persist_load(led_persist_state_t *state);
+
+/**
+ * @brief Start the writer task
+ *
+ * @return ESP_OK on success, ESP_FAIL if the task could not be created
+ */
+esp_err_t led_persist_start(void);
+
+/**
+ * @brief Write a pending state now and stop the writer task
+ */
+void led_persist_stop(void);
+
+/**
+ * @brief Hand over the current state (any task, never blocks)
+ *
+ * Cheap when nothing changed, so it can be called for every frame.
+ *
+ * @param state State to save with the next write
+ */
+void led_persist_request(const led_persist_state_t *state);
+
+/**
+ * @brief Get writer statistics
+ *
+ * @param stats Output statistics
+ */
+void led_persist_get_stats(led_persist_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_PERSIST_H
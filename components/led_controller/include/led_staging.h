@@ -0,0 +1,107 @@
+/**
+ * @file led_staging.h
+ * @brief Lock-free hand-over of pixel frames from one producer to the LED task
+ *
+ * A producer (MQTT task, realtime receiver) draws into its own frame and
+ * publishes it as a whole; the LED task applies published frames in order,
+ * each when the LED_CMD_COMMIT queued with it comes up, so pixels never
+ * overtake or fall behind the commands queued around them. Frames live in
+ * a ring of LED_STAGING_FRAMES slots: neither side ever waits, and the LED
+ * task never reads a frame the producer is drawing. Each frame records
+ * exactly which LEDs were drawn; only those are copied to the framebuffer.
+ * No ESP-IDF dependencies beyond the types in led_controller.h, so it can
+ * be unit-tested on the host.
+ */
+
+#ifndef LED_STAGING_H
+#define LED_STAGING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LEDs per frame (the strip; host tests may set a longer one)
+ */
+#ifndef LED_STAGING_LENGTH
+#define LED_STAGING_LENGTH      LED_STRIP_LENGTH
+#endif
+
+/**
+ * @brief Frame slots per producer: one being drawn, the rest published
+ */
+#define LED_STAGING_FRAMES      SMARTLOVE_LED_STAGING_FRAMES
+
+_Static_assert(LED_STAGING_FRAMES >= 2, "SMARTLOVE_LED_STAGING_FRAMES must be at least 2");
+
+#define LED_STAGING_WORDS       ((LED_STAGING_LENGTH + 31) / 32)
+
+/**
+ * @brief One frame: the producer's image and the LEDs drawn into it
+ */
+typedef struct {
+    led_rgb_t pixels[LED_STAGING_LENGTH];
+    uint32_t drawn[LED_STAGING_WORDS];      ///< Bit per LED to copy
+} led_staging_frame_t;
+
+/**
+ * @brief Staging frames of one producer
+ *
+ * Frames are numbered from 1; frame n uses slot n % LED_STAGING_FRAMES.
+ */
+typedef struct {
+    led_staging_frame_t frames[LED_STAGING_FRAMES];
+    atomic_uint_fast32_t published;     ///< Last published frame (producer)
+    atomic_uint_fast32_t applied;       ///< Last applied frame (LED task)
+    bool drawn;                         ///< Producer: LEDs drawn since the last publish
+} led_staging_t;
+
+/**
+ * @brief Initialize empty staging frames (all LEDs black, nothing drawn)
+ */
+void led_staging_init(led_staging_t *staging);
+
+/**
+ * @brief Frame the producer draws into (producer only)
+ *
+ * Holds the producer's complete image; valid until the next successful
+ * led_staging_publish().
+ */
+led_rgb_t *led_staging_buffer(led_staging_t *staging);
+
+/**
+ * @brief Record LEDs [low, high) as drawn (producer only)
+ */
+void led_staging_mark(led_staging_t *staging, uint32_t low, uint32_t high);
+
+/**
+ * @brief Hand the drawn frame to the LED task (producer only, never blocks)
+ *
+ * @param staging Staging frames
+ * @param frame Output: frame number to pass to led_staging_apply(); the
+ *              last published one if nothing was drawn
+ * @return true on success, false if all other slots still wait for the
+ *         LED task (the drawn LEDs stay in the frame for the next publish)
+ */
+bool led_staging_publish(led_staging_t *staging, uint32_t *frame);
+
+/**
+ * @brief Copy the drawn LEDs of all frames up to @p frame, in order (LED task only)
+ *
+ * @param staging Staging frames
+ * @param frame Frame number from led_staging_publish()
+ * @param framebuffer Destination, LED_STAGING_LENGTH pixels
+ * @return Number of frames applied (0 if they were applied before)
+ */
+uint32_t led_staging_apply(led_staging_t *staging, uint32_t frame, led_rgb_t *framebuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_STAGING_H
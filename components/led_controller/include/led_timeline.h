@@ -0,0 +1,140 @@
+/**
+ * @file led_timeline.h
+ * @brief Keyframe timeline and its player
+ *
+ * A timeline is a list of keyframes (time, color, intensity, transition)
+ * that is uploaded once and then played by the LED task, so a scene needs
+ * no further commands and its timing does not depend on the network. The
+ * position is derived from the clock like a fade, with pause and seek on
+ * top. No ESP-IDF dependencies beyond the types in led_controller.h, so it
+ * can be unit-tested on the host.
+ */
+
+#ifndef LED_TIMELINE_H
+#define LED_TIMELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of keyframes in a timeline
+ */
+#define LED_TIMELINE_MAX_KEYFRAMES  SMARTLOVE_LED_TIMELINE_MAX_KEYFRAMES
+
+/**
+ * @brief One keyframe
+ */
+typedef struct {
+    uint32_t time_ms;        ///< Position in the timeline
+    led_rgb_t color;         ///< Color at this keyframe
+    uint8_t intensity;       ///< Level applied to the color (255 = as is)
+    bool step;               ///< Jump to this keyframe instead of fading to it
+    led_easing_t easing;     ///< Curve of the fade from the previous keyframe
+} led_keyframe_t;
+
+/**
+ * @brief Timeline
+ */
+typedef struct led_timeline {
+    led_keyframe_t keyframes[LED_TIMELINE_MAX_KEYFRAMES];
+    uint16_t count;          ///< Number of keyframes, ascending in time
+    uint32_t duration_ms;    ///< Length, at least the last keyframe time
+    bool loop;               ///< Restart at 0 after duration_ms
+} led_timeline_t;
+
+/**
+ * @brief Playback position clock
+ */
+typedef struct {
+    int64_t origin_us;       ///< Time of position 0 while playing
+    uint32_t paused_ms;      ///< Position while paused
+    uint32_t loop_ms;        ///< Period the position wraps at (0 = no wrap)
+    bool paused;
+} led_timeline_clock_t;
+
+/**
+ * @brief Timeline player
+ */
+typedef struct {
+    led_timeline_t timeline;
+    led_timeline_clock_t clock;
+} led_timeline_player_t;
+
+/**
+ * @brief Check that a timeline can be played
+ *
+ * @param timeline Timeline
+ * @return true if it has keyframes in ascending order within its duration
+ */
+bool led_timeline_is_valid(const led_timeline_t *timeline);
+
+/**
+ * @brief Get the color at a position
+ *
+ * Before the first keyframe its color is held, after the last one the
+ * last color is held until duration_ms. Looping timelines wrap the
+ * position.
+ *
+ * @param timeline Timeline (valid)
+ * @param position_ms Position
+ * @param out Color at position_ms, intensity applied
+ * @return true once a timeline without loop has reached its end
+ */
+bool led_timeline_sample(const led_timeline_t *timeline, uint32_t position_ms, led_rgb_t *out);
+
+/**
+ * @brief Start playing a timeline from position 0
+ *
+ * @param clock Clock
+ * @param timeline Timeline to play (sets the loop period)
+ * @param now_us Current time in us
+ */
+void led_timeline_play(led_timeline_clock_t *clock, const led_timeline_t *timeline, int64_t now_us);
+
+/**
+ * @brief Freeze the position
+ *
+ * @param clock Clock
+ * @param now_us Current time in us
+ */
+void led_timeline_pause(led_timeline_clock_t *clock, int64_t now_us);
+
+/**
+ * @brief Continue from the frozen position
+ *
+ * @param clock Clock
+ * @param now_us Current time in us
+ */
+void led_timeline_resume(led_timeline_clock_t *clock, int64_t now_us);
+
+/**
+ * @brief Jump to a position (keeps playing or paused)
+ *
+ * @param clock Clock
+ * @param position_ms New position
+ * @param now_us Current time in us
+ */
+void led_timeline_seek(led_timeline_clock_t *clock, uint32_t position_ms, int64_t now_us);
+
+/**
+ * @brief Get the current position
+ *
+ * Looping timelines wrap the 64-bit elapsed time at their duration, so
+ * they keep running indefinitely; others saturate at UINT32_MAX.
+ *
+ * @param clock Clock
+ * @param now_us Current time in us
+ * @return Position in ms
+ */
+uint32_t led_timeline_position(const led_timeline_clock_t *clock, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_TIMELINE_H
@@ -0,0 +1,92 @@
+/**
+ * @file ws2812_backend.h
+ * @brief Output backend interface for the WS2812 strip driver
+ *
+ * The strip core (pixel buffers, double buffering, completion) is shared;
+ * a backend only gets finished frames in wire order and reports when each
+ * one has been latched. The RMT peripheral is the default backend on the
+ * ESP32, the capture backend records frames for tests and benchmarks.
+ */
+
+#ifndef WS2812_BACKEND_H
+#define WS2812_BACKEND_H
+
+#include "esp_err.h"
+#include "ws2812_rmt.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Per-strip configuration handed to a backend
+ */
+typedef struct {
+    uint8_t gpio_num;     ///< Data GPIO
+    uint8_t channel;      ///< Output channel (RMT channel)
+    uint16_t led_count;   ///< Number of LEDs
+    const ws2812_pixel_format_t *format;  ///< Pixel format (channels per LED, timing)
+    uint32_t *encode;     ///< Caller-provided encode buffer, NULL = allocate
+    size_t encode_words;  ///< Size of encode in words
+} ws2812_backend_config_t;
+
+/**
+ * @brief Backend operations
+ *
+ * prepare() may do the expensive work (encoding), start() should be cheap
+ * so that several strips can be started together. Once a started frame is
+ * latched the backend calls ws2812_backend_frame_done(), from any task
+ * context (possibly before start() returns). Optional hooks may be NULL.
+ */
+struct ws2812_backend {
+    const char *name;
+
+    /** Create backend state for a strip */
+    esp_err_t (*attach)(ws2812_handle_t strip, const ws2812_backend_config_t *config, void **ctx);
+    /** Release backend state (no frame in flight) */
+    void (*detach)(void *ctx);
+    /**
+     * Prepare a frame of len bytes; frame stays valid until done. Only bytes
+     * [dirty_start, dirty_start + dirty_len) differ from the previous frame.
+     */
+    esp_err_t (*prepare)(void *ctx, const uint8_t *frame, size_t len,
+                         size_t dirty_start, size_t dirty_len);
+    /** Start sending the prepared frame */
+    esp_err_t (*start)(void *ctx, const uint8_t *frame, size_t len);
+    /** Optional: channels used per strip of led_count LEDs of bytes_per_led (default 1) */
+    uint8_t (*channel_stride)(uint16_t led_count, uint8_t bytes_per_led);
+    /** Optional: bracket the start() calls of a parallel refresh */
+    void (*group_begin)(void *const *ctxs, size_t count);
+    void (*group_end)(void *const *ctxs, size_t count);
+    /** Optional: heap bytes owned by the backend state */
+    size_t (*memory_usage)(void *ctx);
+};
+
+/**
+ * @brief RMT peripheral backend (ESP32 targets only)
+ */
+extern const ws2812_backend_t ws2812_rmt_backend;
+
+/**
+ * @brief Report that the frame in flight has been sent and latched
+ *
+ * @param strip Strip the frame belonged to
+ */
+void ws2812_backend_frame_done(ws2812_handle_t strip);
+
+/**
+ * @brief Get the backend state of a strip
+ *
+ * @param strip LED strip handle
+ * @param backend Expected backend
+ * @return Backend context, or NULL if the strip uses another backend
+ */
+void *ws2812_get_backend_context(ws2812_handle_t strip, const ws2812_backend_t *backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS2812_BACKEND_H
@@ -0,0 +1,101 @@
+/**
+ * @file ws2812_capture.h
+ * @brief WS2812 capture backend for tests and benchmarks
+ *
+ * Instead of driving a GPIO, the capture backend encodes every frame into
+ * the same RMT waveform the hardware would send, records it with a
+ * timestamp and completes it immediately. Recorded waveforms can be
+ * decoded back to wire-order bytes for assertions. It builds for the
+ * ESP32 and for the IDF linux target, where it is the default backend.
+ */
+
+#ifndef WS2812_CAPTURE_H
+#define WS2812_CAPTURE_H
+
+#include "esp_err.h"
+#include "ws2812_rmt.h"
+#include "ws2812_backend.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of most recent frames kept per strip
+ */
+#define WS2812_CAPTURE_HISTORY 4
+
+/**
+ * @brief One recorded frame
+ */
+typedef struct {
+    uint32_t sequence;          ///< Frame number on this strip, starting at 1
+    int64_t timestamp_us;       ///< Monotonic time the frame was started
+    uint32_t duration_us;       ///< Waveform length incl. reset/latch
+    const uint32_t *symbols;    ///< Waveform, one RMT symbol per bit
+    size_t symbol_count;        ///< Number of symbols (bytes * 8)
+    const ws2812_pixel_format_t *format;  ///< Pixel format of the strip
+} ws2812_capture_frame_t;
+
+/**
+ * @brief Capture backend
+ */
+extern const ws2812_backend_t ws2812_capture_backend;
+
+/**
+ * @brief Get the number of frames sent on a capture strip
+ *
+ * @param strip Strip created with the capture backend
+ * @return Frames sent so far (0 for other backends)
+ */
+uint32_t ws2812_capture_get_frame_count(ws2812_handle_t strip);
+
+/**
+ * @brief Get a recorded frame
+ *
+ * The frame stays valid until WS2812_CAPTURE_HISTORY more frames are sent.
+ *
+ * @param strip Strip created with the capture backend
+ * @param age 0 = latest frame, 1 = the one before, ...
+ * @param frame Output frame description
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if no such frame is recorded
+ */
+esp_err_t ws2812_capture_get_frame(ws2812_handle_t strip, uint32_t age, ws2812_capture_frame_t *frame);
+
+/**
+ * @brief Decode a waveform back to wire-order bytes
+ *
+ * Every symbol must be a high pulse followed by a low pulse whose high time
+ * is within the WS2812 tolerance of T0H or T1H.
+ *
+ * @param symbols Waveform
+ * @param symbol_count Number of symbols (multiple of 8)
+ * @param bytes Output buffer
+ * @param len Size of the output buffer, must hold symbol_count / 8 bytes
+ * @return ESP_OK, ESP_ERR_INVALID_RESPONSE on a malformed symbol
+ */
+esp_err_t ws2812_capture_decode(const uint32_t *symbols, size_t symbol_count, uint8_t *bytes, size_t len);
+
+/**
+ * @brief Decode one pixel of a recorded frame in the strip's pixel format
+ *
+ * The waveform is checked against the timing of the format.
+ *
+ * @param frame Recorded frame
+ * @param index LED index
+ * @param r Red output
+ * @param g Green output
+ * @param b Blue output
+ * @param w White output, may be NULL (0 for formats without white)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_RESPONSE
+ */
+esp_err_t ws2812_capture_get_pixel(const ws2812_capture_frame_t *frame, uint16_t index,
+                                   uint8_t *r, uint8_t *g, uint8_t *b, uint8_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS2812_CAPTURE_H
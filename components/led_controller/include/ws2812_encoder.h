@@ -0,0 +1,93 @@
+/**
+ * @file ws2812_encoder.h
+ * @brief Table-driven WS2812 bit encoder
+ *
+ * Converts pixel bytes into RMT symbols (one 32-bit symbol per bit, same
+ * layout as rmt_item32_t) using lookup tables built once from the bit
+ * timings. Has no ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef WS2812_ENCODER_H
+#define WS2812_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ws2812_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * RMT clocking:
+ * APB clock = 80MHz
+ * Choose clk_div = 2 -> RMT tick = 80MHz/2 = 40MHz -> 25ns per tick
+ */
+#define WS2812_RMT_CLK_DIV 2
+#define WS2812_TICK_NS (1000000000ULL / (80000000ULL / WS2812_RMT_CLK_DIV))
+
+/**
+ * @brief Number of symbols produced per encoded byte
+ */
+#define WS2812_SYMBOLS_PER_BYTE 8
+
+/**
+ * @brief Build an RMT symbol (rmt_item32_t layout)
+ *
+ * duration0 = bits 0..14, level0 = bit 15, duration1 = bits 16..30, level1 = bit 31
+ */
+#define WS2812_SYMBOL(level0, duration0, level1, duration1) \
+    ((uint32_t)((duration0) & 0x7FFF) | ((uint32_t)((level0) & 1) << 15) | \
+     ((uint32_t)((duration1) & 0x7FFF) << 16) | ((uint32_t)((level1) & 1) << 31))
+
+/**
+ * @brief Precomputed encoder tables
+ */
+typedef struct {
+    uint32_t bit[2];           ///< Symbol for a 0 bit and a 1 bit
+    uint32_t nibble[16][4];    ///< Symbols for each 4-bit value, MSB first
+} ws2812_encoder_t;
+
+/**
+ * @brief Build the encoder tables from bit timings (in RMT ticks)
+ *
+ * @param enc Encoder to initialize
+ * @param t0h High time of a 0 bit
+ * @param t0l Low time of a 0 bit
+ * @param t1h High time of a 1 bit
+ * @param t1l Low time of a 1 bit
+ */
+void ws2812_encoder_init(ws2812_encoder_t *enc, uint16_t t0h, uint16_t t0l,
+                         uint16_t t1h, uint16_t t1l);
+
+/**
+ * @brief Build the encoder tables for the WS2812 timings at the RMT tick
+ *
+ * @param enc Encoder to initialize
+ */
+void ws2812_encoder_init_default(ws2812_encoder_t *enc);
+
+/**
+ * @brief Build the encoder tables for an LED timing at the RMT tick
+ *
+ * @param enc Encoder to initialize
+ * @param timing Bit timing in nanoseconds
+ */
+void ws2812_encoder_init_timing(ws2812_encoder_t *enc, const ws2812_timing_t *timing);
+
+/**
+ * @brief Encode bytes into RMT symbols
+ *
+ * @param enc Initialized encoder
+ * @param src Pixel bytes in wire order
+ * @param len Number of bytes
+ * @param dst Output, must hold len * WS2812_SYMBOLS_PER_BYTE symbols
+ */
+void ws2812_encode(const ws2812_encoder_t *enc, const uint8_t *src, size_t len,
+                   uint32_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS2812_ENCODER_H
@@ -0,0 +1,147 @@
+/**
+ * @file ws2812_format.h
+ * @brief Pixel formats of WS2812-style LEDs and their pixel packers
+ *
+ * A format describes what a strip expects on the wire: how many channels
+ * per LED, in which order, and the bit timing. The strip converts RGB
+ * input to wire order through a packer; there is one packer per channel
+ * order, each generated from the same inline loop with the order as a
+ * compile-time constant, so the inner loops do not branch on the format.
+ * No ESP-IDF dependencies, so it can be unit-tested on the host.
+ */
+
+#ifndef WS2812_FORMAT_H
+#define WS2812_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum channels per LED
+ */
+#define WS2812_MAX_CHANNELS_PER_LED 4
+
+/**
+ * @brief Bit timing of an LED type
+ */
+typedef struct {
+    uint16_t t0h_ns;        ///< High time of a 0 bit
+    uint16_t t0l_ns;        ///< Low time of a 0 bit
+    uint16_t t1h_ns;        ///< High time of a 1 bit
+    uint16_t t1l_ns;        ///< Low time of a 1 bit
+    uint16_t reset_us;      ///< Low time that latches the frame
+} ws2812_timing_t;
+
+/**
+ * @brief Channel order on the wire
+ */
+typedef enum {
+    WS2812_ORDER_GRB = 0,   ///< WS2812B
+    WS2812_ORDER_RGB,       ///< WS2811 and RGB-ordered fixtures
+    WS2812_ORDER_BRG,
+    WS2812_ORDER_GRBW,      ///< SK6812 RGBW
+    WS2812_ORDER_RGBW,
+    WS2812_ORDER_COUNT
+} ws2812_order_t;
+
+/**
+ * @brief Pixel format
+ */
+typedef struct {
+    ws2812_order_t order;   ///< Channel order
+    uint8_t channels;       ///< Bytes per LED, 3 or 4 (must match order)
+    ws2812_timing_t timing; ///< Bit timing
+} ws2812_pixel_format_t;
+
+/**
+ * WS2812 timings in nanoseconds (typical)
+ * WS2812 (800kHz):
+ *  - T0H ~ 350ns, T0L ~ 800ns
+ *  - T1H ~ 700ns, T1L ~ 600ns
+ * Reset/Latch: > 50us (we use 80us)
+ */
+#define WS2812_T0H_NS   350
+#define WS2812_T0L_NS   800
+#define WS2812_T1H_NS   700
+#define WS2812_T1L_NS   600
+#define WS2812_RESET_US 80
+
+/**
+ * @brief WS2812B timing (typical values)
+ */
+#define WS2812_TIMING_WS2812B { .t0h_ns = WS2812_T0H_NS, .t0l_ns = WS2812_T0L_NS, \
+                                .t1h_ns = WS2812_T1H_NS, .t1l_ns = WS2812_T1L_NS, \
+                                .reset_us = WS2812_RESET_US }
+
+/**
+ * @brief SK6812 timing (typical values)
+ */
+#define WS2812_TIMING_SK6812  { .t0h_ns = 300, .t0l_ns = 900, .t1h_ns = 600, .t1l_ns = 600, .reset_us = 80 }
+
+/**
+ * @brief Predefined formats
+ */
+extern const ws2812_pixel_format_t ws2812_format_ws2812b;      ///< GRB, WS2812B timing (default)
+extern const ws2812_pixel_format_t ws2812_format_ws2812_rgb;   ///< RGB, WS2812B timing
+extern const ws2812_pixel_format_t ws2812_format_sk6812_rgbw;  ///< GRBW, SK6812 timing
+
+/**
+ * @brief Channels of an order (3 or 4), 0 for an invalid order
+ */
+uint8_t ws2812_order_channels(ws2812_order_t order);
+
+/**
+ * @brief Check that a format can be driven
+ *
+ * @param format Format
+ * @return true if order and channel count are valid and match
+ */
+bool ws2812_format_is_valid(const ws2812_pixel_format_t *format);
+
+/**
+ * @brief Wire position of each color in an LED (R, G, B, W)
+ *
+ * @param order Channel order (valid)
+ * @param offsets Output: byte offset of R, G, B and W, 0xFF for no W
+ */
+void ws2812_order_offsets(ws2812_order_t order, uint8_t offsets[WS2812_MAX_CHANNELS_PER_LED]);
+
+/**
+ * @brief Pixel packer of one channel order
+ *
+ * RGB input on formats with a white channel is split into white (the
+ * common part, min(r, g, b)) and the remaining color, so whites use the
+ * white LED. Each function reports the range of LEDs it changed as
+ * [first, last]; it returns false and leaves them untouched if nothing
+ * changed.
+ */
+typedef struct {
+    uint8_t channels;
+
+    /** Write count RGB pixels (3 bytes each), mapped through lut if not NULL */
+    bool (*pack)(uint8_t *dst, const uint8_t *rgb, uint16_t count, const uint8_t *lut,
+                 uint16_t *first, uint16_t *last);
+    /** Set count LEDs to one RGB color */
+    bool (*fill)(uint8_t *dst, uint16_t count, uint8_t r, uint8_t g, uint8_t b,
+                 uint16_t *first, uint16_t *last);
+    /** Set one LED to explicit channels (w is ignored without a white channel) */
+    bool (*set)(uint8_t *dst, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+} ws2812_packer_t;
+
+/**
+ * @brief Get the packer of a channel order
+ *
+ * @param order Channel order
+ * @return Packer, NULL for an invalid order
+ */
+const ws2812_packer_t *ws2812_get_packer(ws2812_order_t order);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS2812_FORMAT_H
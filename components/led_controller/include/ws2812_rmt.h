@@ -1,32 +1,193 @@
 /**
  * @file ws2812_rmt.h
  * @brief WS2812B LED Driver using RMT peripheral (IDF 4.x compatible)
+ * 
+ * The strip API is backend independent; the RMT peripheral is the default
+ * backend on the ESP32 (see ws2812_backend.h).
  */
 
 #ifndef WS2812_RMT_H
 #define WS2812_RMT_H
 
 #include "esp_err.h"
+#include "smartlove_config.h"
+#include "ws2812_format.h"
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Maximum number of strips driven in parallel (ESP32 RMT channels)
+ */
+#define WS2812_MAX_CHANNELS 8
+
 /**
  * @brief WS2812 LED strip handle
  */
 typedef struct ws2812_strip_t* ws2812_handle_t;
 
+/**
+ * @brief Pixel buffer bytes of a strip (draw and transmit buffer, channels bytes per LED each)
+ */
+#define WS2812_PIXEL_BYTES(led_count, channels)       ((size_t)(led_count) * (channels) * 2)
+
+/**
+ * @brief RMT encode buffer words of a strip (one per bit, 0 in streaming mode)
+ */
+#define WS2812_RMT_ENCODE_WORDS(led_count, channels) \
+    ((led_count) >= SMARTLOVE_LED_RMT_STREAM_MIN_LEDS ? 0 : (size_t)(led_count) * (channels) * 8)
+
+/**
+ * @brief Size of the strip state (checked against the real struct at build time)
+ */
+#define WS2812_STRIP_STORAGE_SIZE           (48 * sizeof(void *))
+
+/**
+ * @brief Storage for the state of a statically allocated strip (opaque)
+ */
+typedef union {
+    uint8_t bytes[WS2812_STRIP_STORAGE_SIZE];
+    void *align_ptr;
+    uint64_t align_u64;
+} ws2812_strip_storage_t;
+
+/**
+ * @brief Caller-provided memory of one strip, see ws2812_init_static()
+ */
+typedef struct {
+    ws2812_strip_storage_t *strip;  ///< Strip state
+    uint8_t *pixels;                ///< WS2812_PIXEL_BYTES(led_count, channels) bytes
+    uint32_t *encode;               ///< Encode buffer in internal RAM, NULL if none needed
+    size_t encode_words;            ///< Size of encode in words
+} ws2812_static_mem_t;
+
+/**
+ * @brief Frame counters of a strip
+ */
+typedef struct {
+    uint32_t frames_sent;     ///< Frames the backend started sending
+    uint32_t frames_skipped;  ///< Refreshes skipped because nothing changed
+} ws2812_stats_t;
+
+/**
+ * @brief Output backend (see ws2812_backend.h)
+ */
+typedef struct ws2812_backend ws2812_backend_t;
+
+/**
+ * @brief Frame completion callback
+ * 
+ * Called from the esp_timer task once a frame has been sent and latched,
+ * before the strip accepts the next frame. Keep it short, e.g. notify a
+ * task.
+ * 
+ * @param strip LED strip handle
+ * @param arg User argument given at registration
+ */
+typedef void (*ws2812_done_cb_t)(ws2812_handle_t strip, void *arg);
+
 /**
  * @brief Initialize WS2812 LED strip
  * 
+ * All memory needed by ws2812_refresh() (pixel buffer and RMT encode buffer)
+ * is allocated here, so a strip that initializes successfully never runs out
+ * of memory while refreshing. Strips of SMARTLOVE_LED_RMT_STREAM_MIN_LEDS or
+ * more are encoded on the fly (streaming mode) and need no encode buffer.
+ * 
+ * The pixel format sets the bytes per LED, their order on the wire and the
+ * bit timing; pixels are always set as RGB and converted when written.
+ * 
  * @param gpio_num GPIO pin number
  * @param led_count Number of LEDs
  * @param rmt_channel RMT channel to use
+ * @param format Pixel format, NULL for WS2812B (GRB)
  * @return Handle to LED strip or NULL on error
  */
-ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel);
+ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel,
+                            const ws2812_pixel_format_t *format);
+
+/**
+ * @brief Initialize WS2812 LED strip on a specific output backend
+ * 
+ * @param backend Backend, e.g. &ws2812_rmt_backend or &ws2812_capture_backend
+ * @param gpio_num GPIO pin number
+ * @param led_count Number of LEDs
+ * @param channel Backend channel (RMT channel)
+ * @param format Pixel format, NULL for WS2812B (GRB)
+ * @return Handle to LED strip or NULL on error
+ */
+ws2812_handle_t ws2812_init_with_backend(const ws2812_backend_t *backend, uint8_t gpio_num,
+                                         uint16_t led_count, uint8_t channel,
+                                         const ws2812_pixel_format_t *format);
+
+/**
+ * @brief Initialize a WS2812 LED strip in caller-provided memory
+ * 
+ * Like ws2812_init(), but the strip state, pixel buffers and RMT encode
+ * buffer live in @p mem (typically static arrays sized from the LED count
+ * at compile time), so the strip allocates no heap of its own and its
+ * footprint is fixed at link time. The RMT backend needs
+ * WS2812_RMT_ENCODE_WORDS(led_count, channels) encode words; the memory must
+ * stay valid until ws2812_deinit().
+ * 
+ * @param gpio_num GPIO pin number
+ * @param led_count Number of LEDs
+ * @param rmt_channel RMT channel to use
+ * @param format Pixel format, NULL for WS2812B (GRB)
+ * @param mem Strip memory
+ * @return Handle to LED strip or NULL on error (e.g. memory too small)
+ */
+ws2812_handle_t ws2812_init_static(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel,
+                                   const ws2812_pixel_format_t *format,
+                                   const ws2812_static_mem_t *mem);
+
+/**
+ * @brief Select the backend used by ws2812_init() and ws2812_init_multi()
+ * 
+ * Defaults to the RMT backend (capture backend on the linux target).
+ * Must be called before the strips are created.
+ * 
+ * @param backend Backend to use
+ */
+void ws2812_set_default_backend(const ws2812_backend_t *backend);
+
+/**
+ * @brief Initialize several equally long strips on consecutive RMT channels
+ * 
+ * Channels are assigned from first_channel upwards; RMT strips in streaming
+ * mode use two RMT memory blocks and therefore every other channel. On failure
+ * all strips already created are released again.
+ * 
+ * @param gpio_nums Data GPIO of each strip
+ * @param count Number of strips (1..WS2812_MAX_CHANNELS)
+ * @param led_count Number of LEDs per strip
+ * @param first_channel First RMT channel to use
+ * @param format Pixel format of all strips, NULL for WS2812B (GRB)
+ * @param strips Output array of count handles
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ws2812_init_multi(const uint8_t *gpio_nums, size_t count, uint16_t led_count,
+                            uint8_t first_channel, const ws2812_pixel_format_t *format,
+                            ws2812_handle_t *strips);
+
+/**
+ * @brief ws2812_init_multi() in caller-provided memory (see ws2812_init_static())
+ * 
+ * @param gpio_nums Data GPIO of each strip
+ * @param count Number of strips (1..WS2812_MAX_CHANNELS)
+ * @param led_count Number of LEDs per strip
+ * @param first_channel First RMT channel to use
+ * @param format Pixel format of all strips, NULL for WS2812B (GRB)
+ * @param mems Memory of each strip
+ * @param strips Output array of count handles
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ws2812_init_multi_static(const uint8_t *gpio_nums, size_t count, uint16_t led_count,
+                                   uint8_t first_channel, const ws2812_pixel_format_t *format,
+                                   const ws2812_static_mem_t *mems, ws2812_handle_t *strips);
 
 /**
  * @brief Deinitialize WS2812 LED strip
@@ -36,7 +197,22 @@ ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_ch
 void ws2812_deinit(ws2812_handle_t strip);
 
 /**
- * @brief Set pixel color (GRB order for WS2812)
+ * @brief Get the heap memory owned by a strip
+ * 
+ * This is the worst-case heap usage of the strip: ws2812_refresh() itself
+ * performs no allocation. Caller-provided memory (ws2812_init_static())
+ * is not counted.
+ * 
+ * @param strip LED strip handle
+ * @return Bytes allocated at init time (0 for a NULL handle)
+ */
+size_t ws2812_get_memory_usage(ws2812_handle_t strip);
+
+/**
+ * @brief Set pixel color (converted to the strip's pixel format)
+ * 
+ * On formats with a white channel the common part of r, g and b is shown
+ * by the white LED.
  * 
  * @param strip LED strip handle
  * @param index LED index (0-based)
@@ -48,13 +224,129 @@ void ws2812_deinit(ws2812_handle_t strip);
 esp_err_t ws2812_set_pixel(ws2812_handle_t strip, uint16_t index, uint8_t r, uint8_t g, uint8_t b);
 
 /**
- * @brief Refresh LED strip (send data)
+ * @brief Set pixel channels explicitly, including white
+ * 
+ * @param strip LED strip handle
+ * @param index LED index (0-based)
+ * @param r Red component (0-255)
+ * @param g Green component (0-255)
+ * @param b Blue component (0-255)
+ * @param w White component (0-255, ignored on formats without white)
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_set_pixel_rgbw(ws2812_handle_t strip, uint16_t index,
+                                uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+/**
+ * @brief Set a run of pixels from an RGB buffer (without sending)
+ *
+ * Copies @p count RGB triplets into the strip in one pass, converting to
+ * the strip's pixel format and optionally mapping every channel through @p lut (e.g. brightness
+ * and gamma). Only pixels that actually change are marked dirty.
+ *
+ * @param strip LED strip handle
+ * @param start Index of the first LED to write
+ * @param rgb Source pixels, 3 bytes (r, g, b) per LED
+ * @param count Number of LEDs
+ * @param lut 256-entry channel table, NULL to copy values unchanged
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the run exceeds the strip
+ */
+esp_err_t ws2812_set_pixels(ws2812_handle_t strip, uint16_t start, const uint8_t *rgb,
+                            uint16_t count, const uint8_t *lut);
+
+/**
+ * @brief Set all pixels to one color (without sending)
+ * 
+ * @param strip LED strip handle
+ * @param r Red component (0-255)
+ * @param g Green component (0-255)
+ * @param b Blue component (0-255)
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_fill(ws2812_handle_t strip, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Refresh LED strip (send data) and wait until it is latched
  * 
  * @param strip LED strip handle
  * @return ESP_OK on success
  */
 esp_err_t ws2812_refresh(ws2812_handle_t strip);
 
+/**
+ * @brief Start sending the current frame without waiting for it
+ * 
+ * The pixel buffer is double buffered: the frame is handed to the RMT
+ * hardware and the caller can immediately set pixels for the next frame
+ * (starting from a copy of the frame just sent). Only waits if the previous
+ * frame is still being sent. Completion is signalled through the callback
+ * registered with ws2812_register_done_callback(). A frame that fails to
+ * start stays pending and goes out with the next refresh.
+ * 
+ * @param strip LED strip handle
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the previous frame hung
+ */
+esp_err_t ws2812_refresh_async(ws2812_handle_t strip);
+
+/**
+ * @brief Send the current frame of several strips in parallel
+ * 
+ * All frames are prepared (encoded) first and the RMT channels are then
+ * started together, so N strips of L LEDs take about as long as one strip
+ * of L LEDs. Uses hardware start synchronisation where the chip has it.
+ * If a strip fails, the frames not started stay pending for the next refresh.
+ * 
+ * @param strips Strip handles, each on its own RMT channel
+ * @param count Number of strips (1..WS2812_MAX_CHANNELS)
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_refresh_multi_async(const ws2812_handle_t *strips, size_t count);
+
+/**
+ * @brief Send several strips in parallel and wait until all are latched
+ * 
+ * @param strips Strip handles, each on its own RMT channel
+ * @param count Number of strips (1..WS2812_MAX_CHANNELS)
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_refresh_multi(const ws2812_handle_t *strips, size_t count);
+
+/**
+ * @brief Wait until the frame in flight (if any) is sent and latched
+ * 
+ * @param strip LED strip handle
+ * @param timeout_ms Maximum time to wait
+ * @return ESP_OK when idle, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t ws2812_wait_done(ws2812_handle_t strip, uint32_t timeout_ms);
+
+/**
+ * @brief Force the next refresh to send the whole frame
+ * 
+ * @param strip LED strip handle
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_mark_dirty(ws2812_handle_t strip);
+
+/**
+ * @brief Get the sent/skipped frame counters
+ * 
+ * @param strip LED strip handle
+ * @param stats Output counters
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_get_stats(ws2812_handle_t strip, ws2812_stats_t *stats);
+
+/**
+ * @brief Register a frame completion callback
+ * 
+ * @param strip LED strip handle
+ * @param callback Callback, or NULL to unregister
+ * @param arg User argument passed to the callback
+ * @return ESP_OK on success
+ */
+esp_err_t ws2812_register_done_callback(ws2812_handle_t strip, ws2812_done_cb_t callback, void *arg);
+
 /**
  * @brief Clear all LEDs (set to black)
  * 
@@ -0,0 +1,217 @@
+/**
+ * @file led_color.c
+ * @brief Integer HSV / HSL color conversion and output tables
+ */
+
+#include "led_color.h"
+
+/**
+ * @brief round(x / 255) for 0 <= x <= 255 * 255 without a division
+ */
+static inline uint32_t div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/**
+ * @brief round(x / (255 * 256)) for 0 <= x <= 255 * 255 * 256
+ *
+ * Multiply by ceil(2^48 / 65280) and shift: exact over the whole range
+ * (a 32-bit factor such as 257 / 2^24 misrounds 32513 inputs near .5).
+ */
+static inline uint32_t div65280(uint32_t x)
+{
+    return (uint32_t)(((uint64_t)(x + 32640) * 4311810306u) >> 48);
+}
+
+/**
+ * @brief Gamma 2.2 at 16 bit: round(65535 * (k / 256)^2.2), k = 0..256
+ */
+static const uint16_t s_gamma16[257] = {
+        0,     0,     2,     4,     7,    11,    17,    24,    32,    41,    52,    64,
+       78,    93,   110,   128,   147,   168,   191,   215,   240,   267,   296,   327,
+      359,   392,   428,   465,   504,   544,   586,   630,   676,   723,   772,   823,
+      875,   930,   986,  1044,  1104,  1165,  1229,  1294,  1361,  1430,  1501,  1574,
+     1648,  1725,  1803,  1884,  1966,  2050,  2136,  2224,  2314,  2406,  2500,  2595,
+     2693,  2793,  2895,  2998,  3104,  3212,  3322,  3433,  3547,  3663,  3781,  3900,
+     4022,  4146,  4272,  4400,  4530,  4663,  4797,  4933,  5072,  5212,  5355,  5499,
+     5646,  5795,  5946,  6099,  6255,  6412,  6572,  6733,  6897,  7063,  7231,  7402,
+     7574,  7749,  7926,  8105,  8286,  8469,  8655,  8843,  9033,  9225,  9419,  9616,
+     9815, 10016, 10219, 10425, 10632, 10842, 11054, 11269, 11486, 11705, 11926, 12149,
+    12375, 12603, 12833, 13066, 13301, 13538, 13777, 14019, 14263, 14509, 14758, 15009,
+    15262, 15517, 15775, 16035, 16298, 16563, 16830, 17099, 17371, 17645, 17922, 18201,
+    18482, 18765, 19051, 19339, 19630, 19923, 20218, 20516, 20816, 21119, 21424, 21731,
+    22040, 22352, 22667, 22984, 23303, 23624, 23949, 24275, 24604, 24935, 25269, 25605,
+    25943, 26284, 26628, 26973, 27322, 27672, 28026, 28381, 28739, 29100, 29462, 29828,
+    30196, 30566, 30939, 31314, 31692, 32072, 32454, 32840, 33227, 33617, 34010, 34405,
+    34802, 35202, 35605, 36010, 36417, 36827, 37240, 37655, 38072, 38493, 38915, 39340,
+    39768, 40198, 40631, 41066, 41503, 41944, 42387, 42832, 43280, 43730, 44183, 44639,
+    45097, 45557, 46020, 46486, 46954, 47425, 47899, 48374, 48853, 49334, 49818, 50304,
+    50793, 51284, 51778, 52275, 52774, 53276, 53780, 54287, 54796, 55308, 55823, 56341,
+    56860, 57383, 57908, 58436, 58966, 59499, 60035, 60573, 61114, 61657, 62203, 62752,
+    63303, 63857, 64414, 64973, 65535
+};
+
+/**
+ * @brief Hue of an RGB color from its maximum channel and chroma
+ */
+static uint16_t rgb_hue(led_rgb_t rgb, uint8_t max, uint8_t delta)
+{
+    if (delta == 0) {
+        return 0;
+    }
+
+    int32_t h;
+    if (max == rgb.r) {
+        h = ((int32_t)rgb.g - rgb.b) * 256 / delta;
+    } else if (max == rgb.g) {
+        h = 512 + ((int32_t)rgb.b - rgb.r) * 256 / delta;
+    } else {
+        h = 1024 + ((int32_t)rgb.r - rgb.g) * 256 / delta;
+    }
+    if (h < 0) {
+        h += LED_HUE_MAX;
+    }
+    return (uint16_t)(h % LED_HUE_MAX);
+}
+
+led_rgb_t led_hsv_to_rgb(led_hsv_t hsv)
+{
+    uint16_t h = hsv.h % LED_HUE_MAX;
+    uint8_t sector = (uint8_t)(h >> 8);
+    uint32_t f = h & 0xFF;
+    uint32_t v = hsv.v;
+    uint32_t s = hsv.s;
+
+    // Bottom, falling and rising channel of the sector (f / 256 into it)
+    uint8_t p = (uint8_t)(v - div255(v * s));
+    uint8_t q = (uint8_t)(v - div65280(v * s * f));
+    uint8_t t = (uint8_t)(v - div65280(v * s * (256 - f)));
+
+    switch (sector) {
+        case 0:  return (led_rgb_t){ .r = (uint8_t)v, .g = t, .b = p };
+        case 1:  return (led_rgb_t){ .r = q, .g = (uint8_t)v, .b = p };
+        case 2:  return (led_rgb_t){ .r = p, .g = (uint8_t)v, .b = t };
+        case 3:  return (led_rgb_t){ .r = p, .g = q, .b = (uint8_t)v };
+        case 4:  return (led_rgb_t){ .r = t, .g = p, .b = (uint8_t)v };
+        default: return (led_rgb_t){ .r = (uint8_t)v, .g = p, .b = q };
+    }
+}
+
+led_hsv_t led_rgb_to_hsv(led_rgb_t rgb)
+{
+    uint8_t max = rgb.r > rgb.g ? rgb.r : rgb.g;
+    max = rgb.b > max ? rgb.b : max;
+    uint8_t min = rgb.r < rgb.g ? rgb.r : rgb.g;
+    min = rgb.b < min ? rgb.b : min;
+    uint8_t delta = (uint8_t)(max - min);
+
+    led_hsv_t hsv = {
+        .h = rgb_hue(rgb, max, delta),
+        .s = max == 0 ? 0 : (uint8_t)(((uint32_t)delta * 255 + max / 2) / max),
+        .v = max,
+    };
+    return hsv;
+}
+
+led_rgb_t led_hsl_to_rgb(led_hsl_t hsl)
+{
+    // Through HSV: v = l + s * min(l, 1 - l), s_v = 2 * (1 - l / v)
+    uint32_t l = hsl.l;
+    uint32_t span = l < 128 ? l : 255 - l;
+    uint32_t v = l + div255(hsl.s * span);
+    uint32_t s = v == 0 ? 0 : (2 * (v - l) * 255 + v / 2) / v;
+
+    led_hsv_t hsv = { .h = hsl.h, .s = (uint8_t)(s > 255 ? 255 : s), .v = (uint8_t)v };
+    return led_hsv_to_rgb(hsv);
+}
+
+led_hsl_t led_rgb_to_hsl(led_rgb_t rgb)
+{
+    uint8_t max = rgb.r > rgb.g ? rgb.r : rgb.g;
+    max = rgb.b > max ? rgb.b : max;
+    uint8_t min = rgb.r < rgb.g ? rgb.r : rgb.g;
+    min = rgb.b < min ? rgb.b : min;
+    uint8_t delta = (uint8_t)(max - min);
+    uint32_t sum = (uint32_t)max + min;
+
+    // s = delta / (1 - |2l - 1|)
+    uint32_t denom = sum <= 255 ? sum : 510 - sum;
+    led_hsl_t hsl = {
+        .h = rgb_hue(rgb, max, delta),
+        .s = denom == 0 ? 0 : (uint8_t)(((uint32_t)delta * 255 + denom / 2) / denom),
+        .l = (uint8_t)((sum + 1) / 2),
+    };
+    return hsl;
+}
+
+void led_hsv_to_rgb_span(const led_hsv_t *in, led_rgb_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = led_hsv_to_rgb(in[i]);
+    }
+}
+
+void led_rgb_to_hsv_span(const led_rgb_t *in, led_hsv_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = led_rgb_to_hsv(in[i]);
+    }
+}
+
+void led_hue_gradient(led_rgb_t *out, size_t count, uint16_t hue_start, uint32_t hue_step,
+                      uint8_t s, uint8_t v)
+{
+    // Hue in Q8 so fractional steps spread a circle over any length
+    uint32_t hue = (uint32_t)(hue_start % LED_HUE_MAX) << 8;
+    const uint32_t circle = (uint32_t)LED_HUE_MAX << 8;
+    hue_step %= circle;
+
+    for (size_t i = 0; i < count; i++) {
+        led_hsv_t hsv = { .h = (uint16_t)(hue >> 8), .s = s, .v = v };
+        out[i] = led_hsv_to_rgb(hsv);
+        hue += hue_step;
+        if (hue >= circle) {
+            hue -= circle;
+        }
+    }
+}
+
+void led_hue_rotate_span(led_rgb_t *pixels, size_t count, int32_t delta)
+{
+    int32_t shift = delta % LED_HUE_MAX;
+    if (shift < 0) {
+        shift += LED_HUE_MAX;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        led_hsv_t hsv = led_rgb_to_hsv(pixels[i]);
+        hsv.h = (uint16_t)((hsv.h + shift) % LED_HUE_MAX);
+        pixels[i] = led_hsv_to_rgb(hsv);
+    }
+}
+
+void led_output_lut(uint8_t lut[256], uint8_t intensity, uint8_t max_brightness, bool gamma)
+{
+    const uint64_t full = 255u * 255u * 255u;
+    const uint32_t scale = (uint32_t)intensity * max_brightness;
+
+    for (uint32_t v = 0; v < 256; v++) {
+        uint32_t product = v * scale;   // Linear output in 1/255^3
+
+        if (!gamma) {
+            lut[v] = (uint8_t)((product + (255 * 255) / 2) / (255 * 255));
+            continue;
+        }
+
+        // Position in the gamma table in 1/256 steps, interpolated
+        uint32_t pos = (uint32_t)(((uint64_t)product * 65536 + full / 2) / full);
+        uint32_t k = pos >> 8;
+        uint32_t y = s_gamma16[k];
+        if (k < 256) {
+            y += ((uint32_t)(s_gamma16[k + 1] - y) * (pos & 0xFF) + 128) >> 8;
+        }
+        lut[v] = (uint8_t)((y * 255 + 32767) / 65535);
+    }
+}
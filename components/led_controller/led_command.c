@@ -0,0 +1,73 @@
+/**
+ * @file led_command.c
+ * @brief Lock-free multi-producer / single-consumer LED command queue
+ *
+ * Bounded ring with a sequence number per slot: a slot is free for the
+ * producer at position p when seq == p and ready for the consumer when
+ * seq == p + 1. Producers race only on the tail (one CAS); the consumer
+ * owns the head.
+ */
+
+#include "led_command.h"
+
+void led_command_queue_init(led_command_queue_t *queue)
+{
+    for (uint32_t i = 0; i < LED_COMMAND_QUEUE_LEN; i++) {
+        atomic_init(&queue->slots[i].seq, i);
+    }
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->dropped, 0);
+    queue->head = 0;
+}
+
+bool led_command_push(led_command_queue_t *queue, const led_command_t *cmd)
+{
+    uint32_t pos = (uint32_t)atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;) {
+        led_command_slot_t *slot = &queue->slots[pos & (LED_COMMAND_QUEUE_LEN - 1)];
+        uint32_t seq = (uint32_t)atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            // Slot is free: claim it, or retry from the tail another producer moved
+            uint_fast32_t expected = pos;
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &expected, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                slot->cmd = *cmd;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            pos = (uint32_t)expected;
+        } else if (diff < 0) {
+            // The consumer has not freed this slot yet: full
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = (uint32_t)atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+bool led_command_pop(led_command_queue_t *queue, led_command_t *cmd)
+{
+    uint32_t pos = queue->head;
+    led_command_slot_t *slot = &queue->slots[pos & (LED_COMMAND_QUEUE_LEN - 1)];
+
+    if ((uint32_t)atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+        // Empty, or the producer of this slot is still writing it
+        return false;
+    }
+
+    *cmd = slot->cmd;
+    atomic_store_explicit(&slot->seq, pos + LED_COMMAND_QUEUE_LEN, memory_order_release);
+    queue->head = pos + 1;
+    return true;
+}
+
+bool led_command_range_valid(int start, int count)
+{
+    return start >= 0 && count >= 0 && start <= LED_STRIP_LENGTH &&
+           count <= LED_STRIP_LENGTH - start;
+}
@@ -4,20 +4,33 @@
  */
 
 #include "led_controller.h"
+#include "led_color.h"
+#include "led_command.h"
+#include "led_staging.h"
+#include "led_effect.h"
+#include "led_fade.h"
+#include "led_json.h"
+#include "led_latency.h"
+#include "led_persist.h"
+#include "led_timeline.h"
 #include "ws2812_rmt.h"
+#include "time_sync.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "cJSON.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <stdatomic.h>
 #include <string.h>
 
-// Forward declarations for static functions
-static void start_animation_task(void);
-static void stop_animation_task(void);
-
 static const char *TAG = "led_controller";
 
-// LED Controller State - initialized with config defaults
+#define LED_TASK_STACK_SIZE     3072
+#define LED_TASK_PRIORITY       5
+
+// LED Controller State - initialized with config defaults. Owned by the LED
+// task once it runs; other tasks post commands and read s_snapshots.
 static led_state_t s_led_state = {
     .is_on = SMARTLOVE_LED_DEFAULT_ON,
     .intensity = SMARTLOVE_LED_DEFAULT_BRIGHTNESS,
@@ -38,11 +51,252 @@ static led_state_t s_led_state = {
     },
     .fade_time_ms = 0,
     .fade_elapsed_ms = 0,
+    .fade_easing = LED_EASE_LINEAR,
     .animation = SMARTLOVE_LED_DEFAULT_ANIMATION
 };
 
-static ws2812_handle_t s_led_strip = NULL;
-static TaskHandle_t s_animation_task_handle = NULL;
+_Static_assert(LED_LINE_COUNT >= 1 && LED_LINE_COUNT <= WS2812_MAX_CHANNELS,
+               "SMARTLOVE_LED_LINE_COUNT must be 1-8");
+
+static ws2812_handle_t s_led_strips[LED_LINE_COUNT] = {0};
+
+#if SMARTLOVE_LED_PIXEL_FORMAT == 0
+#define LED_PIXEL_FORMAT    (&ws2812_format_ws2812b)
+#define LED_PIXEL_CHANNELS  3
+#elif SMARTLOVE_LED_PIXEL_FORMAT == 1
+#define LED_PIXEL_FORMAT    (&ws2812_format_ws2812_rgb)
+#define LED_PIXEL_CHANNELS  3
+#elif SMARTLOVE_LED_PIXEL_FORMAT == 2
+#define LED_PIXEL_FORMAT    (&ws2812_format_sk6812_rgbw)
+#define LED_PIXEL_CHANNELS  4
+#else
+#error "SMARTLOVE_LED_PIXEL_FORMAT must be 0, 1 or 2"
+#endif
+
+#if SMARTLOVE_LED_STATIC_ALLOC
+// Strip and task memory sized at compile time (no heap, fixed at link time)
+#define LED_ENCODE_WORDS                                                   \
+    (WS2812_RMT_ENCODE_WORDS(LED_LINE_LENGTH, LED_PIXEL_CHANNELS) > 0 ?    \
+     WS2812_RMT_ENCODE_WORDS(LED_LINE_LENGTH, LED_PIXEL_CHANNELS) : 1)
+
+static ws2812_strip_storage_t s_strip_storage[LED_LINE_COUNT];
+static uint8_t s_strip_pixels[LED_LINE_COUNT][WS2812_PIXEL_BYTES(LED_LINE_LENGTH, LED_PIXEL_CHANNELS)];
+static uint32_t s_strip_encode[LED_LINE_COUNT][LED_ENCODE_WORDS];
+static StaticTask_t s_led_task_tcb;
+static StackType_t s_led_task_stack[LED_TASK_STACK_SIZE];
+#endif
+
+static led_fade_t s_fade;
+
+/**
+ * @brief Fade effect, plays s_fade
+ */
+static const led_effect_t s_fade_effect = {
+    .name = "fade",
+    .render = led_effect_fade_render,
+    .arg = &s_fade,
+};
+
+static led_timeline_player_t s_timeline_player;
+
+/**
+ * @brief Timeline effect, plays s_timeline_player
+ */
+static const led_effect_t s_timeline_effect = {
+    .name = "timeline",
+    .render = led_effect_timeline_render,
+    .arg = &s_timeline_player,
+};
+
+/**
+ * @brief Uploaded timeline, taken over by LED_CMD_TIMELINE_LOAD
+ *
+ * Too large for a command, so it is handed over through this buffer. The
+ * flag is set by the uploader and cleared by the LED task after copying,
+ * so an upload never overwrites one that was not taken over yet.
+ */
+static led_timeline_t s_timeline_upload;
+static atomic_flag s_timeline_upload_busy = ATOMIC_FLAG_INIT;
+
+/**
+ * @brief Fields of a JSON command, looked up in one pass over the message
+ */
+typedef enum {
+    JSON_FIELD_START_AT,
+    JSON_FIELD_INTENSITY,
+    JSON_FIELD_COLOR,
+    JSON_FIELD_RANGE,
+    JSON_FIELD_PIXELS,
+    JSON_FIELD_START,
+    JSON_FIELD_SHOW,
+    JSON_FIELD_FADE_MS,
+    JSON_FIELD_EASING,
+    JSON_FIELD_TIMELINE,
+    JSON_FIELD_SEEK_MS,
+    JSON_FIELD_PLAYER,
+    JSON_FIELD_COUNT
+} json_field_t;
+
+static const char *const s_json_fields[JSON_FIELD_COUNT] = {
+    [JSON_FIELD_START_AT] = "start_at",
+    [JSON_FIELD_INTENSITY] = "intensity",
+    [JSON_FIELD_COLOR] = "color",
+    [JSON_FIELD_RANGE] = "range",
+    [JSON_FIELD_PIXELS] = "pixels",
+    [JSON_FIELD_START] = "start",
+    [JSON_FIELD_SHOW] = "show",
+    [JSON_FIELD_FADE_MS] = "fade_ms",
+    [JSON_FIELD_EASING] = "easing",
+    [JSON_FIELD_TIMELINE] = "timeline",
+    [JSON_FIELD_SEEK_MS] = "seek_ms",
+    [JSON_FIELD_PLAYER] = "player",
+};
+
+/**
+ * @brief Longest effect, easing or player name read from a command
+ */
+#define JSON_NAME_MAX 32
+
+/**
+ * @brief Token pool of the JSON parser, shared by all callers
+ *
+ * Too large for the MQTT task stack, so commands are parsed one at a time
+ * into this static pool.
+ */
+static led_json_token_t s_json_tokens[SMARTLOVE_LED_JSON_MAX_TOKENS];
+static SemaphoreHandle_t s_json_lock = NULL;
+static StaticSemaphore_t s_json_lock_buf;
+
+_Static_assert(sizeof(led_rgb_t) == 3, "led_rgb_t must be packed RGB");
+
+/**
+ * @brief Pixel colors before intensity and gamma, all lines back to back
+ */
+static led_rgb_t s_framebuffer[LED_STRIP_LENGTH];
+
+/**
+ * @brief Effect output, rendered from s_framebuffer by the running effect
+ */
+static led_rgb_t s_effect_pixels[LED_STRIP_LENGTH];
+static int64_t s_effect_start_us = 0;
+static uint32_t s_effect_frame = 0;
+static int64_t s_frame_deadline_us = 0;
+
+/**
+ * @brief Effect scheduler timing
+ */
+static struct {
+    uint32_t frames;
+    uint32_t deadlines_missed;
+    uint32_t render_us_last;
+    uint32_t render_us_max;
+    uint32_t transmit_us_last;
+    uint32_t transmit_us_max;
+} s_sched_stats;
+
+/**
+ * @brief Binary frame in progress (frames may arrive in several chunks)
+ */
+typedef struct {
+    bool active;          // Header accepted, waiting for more chunks
+    bool grb;             // Payload is in GRB byte order
+    uint8_t header_len;   // 0 or LED_FRAME_HEADER_LEN
+    uint32_t dst_start;   // First framebuffer byte of the payload
+} led_frame_rx_t;
+
+// Written by the frame producer (MQTT task) only
+static led_frame_rx_t s_frame_rx;
+static uint32_t s_frames_received = 0;
+static uint32_t s_frames_displayed = 0;
+
+/**
+ * @brief Commands for the LED task, which applies them to s_led_state
+ */
+static led_command_queue_t s_commands;
+
+/**
+ * @brief Commands with a future start time, parked by the LED task in
+ * ascending meta.at_us order until they are due
+ *
+ * s_schedule_timer wakes the LED task at the earliest start time, so the
+ * start does not depend on the frame period or the tick rate.
+ */
+static led_command_t s_scheduled[LED_SCHEDULED_MAX];
+static uint8_t s_scheduled_count = 0;
+static esp_timer_handle_t s_schedule_timer = NULL;
+
+/**
+ * @brief Pixels written by other tasks, taken over by LED_CMD_COMMIT
+ *
+ * One set of frames per producer, so the MQTT task and the realtime
+ * receiver never write the same buffer and the LED task only copies frames
+ * that are complete, each at the position of its commit.
+ */
+static led_staging_t s_staging[LED_SOURCE_COUNT];
+_Static_assert(LED_STAGING_LENGTH == LED_STRIP_LENGTH, "Staging frames cover the strip");
+
+/**
+ * @brief State published by the LED task for led_controller_get_state()
+ */
+typedef struct {
+    led_state_t state;
+    int64_t fade_start_us;
+    led_timeline_clock_t timeline_clock;
+    uint16_t timeline_count;
+    uint32_t timeline_duration_ms;
+    bool timeline_loop;
+} led_snapshot_t;
+
+/**
+ * @brief Two-slot seqlock: odd while slot ((seq >> 1) + 1) & 1 is written,
+ * slot (seq >> 1) & 1 holds the latest complete snapshot
+ */
+static led_snapshot_t s_snapshots[2];
+static atomic_uint_fast32_t s_snapshot_seq = 0;
+
+/**
+ * @brief Latency trace of one command, from its message to the LEDs
+ *
+ * One trace is followed at a time: the first traced command the LED task
+ * applies while no trace is in flight. The LED task stamps apply and
+ * encode; the strip done callback (esp_timer task) stamps the output and
+ * records the stages. Everything below is guarded by s_latency_lock.
+ */
+typedef enum {
+    TRACE_IDLE = 0,
+    TRACE_APPLIED,      // Applied, waiting for the next frame
+    TRACE_SENT,         // Frame started, waiting for the done callback
+} led_trace_state_t;
+
+typedef struct {
+    led_trace_state_t state;
+    int64_t rx_us;
+    uint32_t parse_us;
+    int64_t applied_us;
+    int64_t encoded_us;
+    ws2812_handle_t strip;      // Strip whose done callback ends the trace
+    uint32_t frame;             // Its frame number carrying the change
+} led_trace_t;
+
+static led_trace_t s_trace;
+static struct {
+    ws2812_handle_t strip;
+    uint32_t frame;
+    int64_t done_us;
+} s_last_done;                  // Done callback that found no trace in flight
+static led_latency_hist_t s_latency[LED_LATENCY_STAGE_COUNT];
+static uint32_t s_traces_unchanged = 0;
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Color channel output table: brightness and gamma in one lookup
+ *
+ * Rebuilt only when the intensity changes.
+ */
+static uint8_t s_output_lut[256];
+static int s_output_lut_intensity = -1;
+static TaskHandle_t s_led_task_handle = NULL;
+static volatile bool s_led_task_exit = false;
 static bool s_initialized = false;
 
 // ============================================================================
@@ -50,410 +304,1978 @@ static bool s_initialized = false;
 // ============================================================================
 
 /**
- * @brief Apply current color and intensity to all LEDs
+ * @brief Rebuild the output table for an intensity (no-op if unchanged)
  */
-static void apply_leds(void)
+static void update_output_lut(uint8_t intensity)
 {
-    if (!s_initialized || s_led_strip == NULL) {
-        return;
-    }
-
-    if (!s_led_state.is_on) {
-        // Turn off all LEDs
-        ws2812_clear(s_led_strip);
+    if (s_output_lut_intensity == intensity) {
         return;
     }
 
-    // Calculate scaled RGB values based on intensity
-    uint8_t r = (s_led_state.color.r * s_led_state.intensity) / 255;
-    uint8_t g = (s_led_state.color.g * s_led_state.intensity) / 255;
-    uint8_t b = (s_led_state.color.b * s_led_state.intensity) / 255;
+    led_output_lut(s_output_lut, intensity, LED_MAX_BRIGHTNESS, SMARTLOVE_LED_GAMMA_ENABLED);
+    s_output_lut_intensity = intensity;
+}
 
-    // Set all LEDs to the same color
-    for (int i = 0; i < LED_STRIP_LENGTH; i++) {
-        ws2812_set_pixel(s_led_strip, i, r, g, b);
+/**
+ * @brief Record the stages of a finished trace (s_latency_lock held)
+ *
+ * @param done_us Time the frame was latched, 0 if no LED changed
+ */
+static void record_trace(int64_t done_us)
+{
+    const led_trace_t *t = &s_trace;
+    int64_t parsed_us = t->rx_us + t->parse_us;
+
+    led_latency_record(&s_latency[LED_LATENCY_PARSE], t->parse_us);
+    led_latency_record(&s_latency[LED_LATENCY_APPLY], (uint32_t)(t->applied_us - parsed_us));
+    led_latency_record(&s_latency[LED_LATENCY_ENCODE], (uint32_t)(t->encoded_us - t->applied_us));
+    if (done_us != 0) {
+        led_latency_record(&s_latency[LED_LATENCY_OUTPUT], (uint32_t)(done_us - t->encoded_us));
+        led_latency_record(&s_latency[LED_LATENCY_TOTAL], (uint32_t)(done_us - t->rx_us));
+    } else {
+        s_traces_unchanged++;
     }
-
-    // Refresh the strip
-    ws2812_refresh(s_led_strip);
+    s_trace.state = TRACE_IDLE;
 }
 
 /**
- * @brief Animation task for LED effects
+ * @brief Start following a traced command (LED task)
  */
-static void animation_task(void *pvParameters)
+static void trace_applied(const led_command_meta_t *meta)
 {
-    bool blink_state = false;
-    
-    ESP_LOGI(TAG, "Animation task started");
-
-    TickType_t last_wake = xTaskGetTickCount();
-    while (1) {
-        if (s_led_state.animation == LED_ANIM_BLINK) {
-            blink_state = !blink_state;
-            if (blink_state) {
-                bool was_on = s_led_state.is_on;
-                s_led_state.is_on = true;
-                apply_leds();
-                s_led_state.is_on = was_on;
-            } else {
-                ws2812_clear(s_led_strip);
-            }
-            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(500));
-        } else if (s_led_state.animation == LED_ANIM_FADE) {
-            // Fade logic
-            uint32_t step_ms = 20;
-            if (s_led_state.fade_time_ms == 0) {
-                s_led_state.color = s_led_state.fade_target;
-                s_led_state.animation = LED_ANIM_NONE;
-                apply_leds();
-                continue;
-            }
-            if (s_led_state.fade_elapsed_ms >= s_led_state.fade_time_ms) {
-                s_led_state.color = s_led_state.fade_target;
-                s_led_state.animation = LED_ANIM_NONE;
-                apply_leds();
-                continue;
-            }
-            float t = (float)s_led_state.fade_elapsed_ms / (float)s_led_state.fade_time_ms;
-            uint8_t r = (uint8_t)((1.0f - t) * s_led_state.fade_start.r + t * s_led_state.fade_target.r);
-            uint8_t g = (uint8_t)((1.0f - t) * s_led_state.fade_start.g + t * s_led_state.fade_target.g);
-            uint8_t b = (uint8_t)((1.0f - t) * s_led_state.fade_start.b + t * s_led_state.fade_target.b);
-            led_rgb_t prev = s_led_state.color;
-            s_led_state.color.r = r;
-            s_led_state.color.g = g;
-            s_led_state.color.b = b;
-            apply_leds();
-            s_led_state.color = prev; // keep original for next step
-            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(step_ms));
-            s_led_state.fade_elapsed_ms += step_ms;
-        } else {
-            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(100));
-        }
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_latency_lock);
+    if (s_trace.state == TRACE_IDLE) {
+        s_trace.rx_us = meta->rx_us;
+        s_trace.parse_us = meta->parse_us;
+        s_trace.applied_us = now_us;
+        s_trace.state = TRACE_APPLIED;
     }
+    portEXIT_CRITICAL(&s_latency_lock);
 }
 
-esp_err_t led_controller_fade_to(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms)
+/**
+ * @brief Frame latched on a strip (esp_timer task)
+ *
+ * The strip is only released after this returns, so the strip's frame
+ * counter still names the frame that just finished.
+ */
+static void strip_done_cb(ws2812_handle_t strip, void *arg)
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
+    int64_t now_us = esp_timer_get_time();
+    ws2812_stats_t stats;
+    ws2812_get_stats(strip, &stats);
+
+    portENTER_CRITICAL(&s_latency_lock);
+    if (s_trace.state == TRACE_SENT && s_trace.strip == strip &&
+        s_trace.frame == stats.frames_sent) {
+        record_trace(now_us);
+    } else {
+        // May be the traced frame finishing before refresh_strips() saw it start
+        s_last_done.strip = strip;
+        s_last_done.frame = stats.frames_sent;
+        s_last_done.done_us = now_us;
     }
-    s_led_state.fade_start = s_led_state.color;
-    s_led_state.fade_target.r = r;
-    s_led_state.fade_target.g = g;
-    s_led_state.fade_target.b = b;
-    s_led_state.fade_time_ms = duration_ms;
-    s_led_state.fade_elapsed_ms = 0;
-    s_led_state.animation = LED_ANIM_FADE;
-    start_animation_task();
-    ESP_LOGI(TAG, "Fade to RGB(%d,%d,%d) in %d ms", r, g, b, duration_ms);
-    return ESP_OK;
+    portEXIT_CRITICAL(&s_latency_lock);
 }
 
-static void start_animation_task(void)
+/**
+ * @brief Hand the frame of all lines to the RMT hardware
+ *
+ * Drawing the next frame can start while this one is still being sent.
+ * A traced command waiting for output is followed to its frame here.
+ */
+static void refresh_strips(void)
 {
-    if (s_animation_task_handle != NULL) {
-        return; // Task already running
+    portENTER_CRITICAL(&s_latency_lock);
+    bool traced = s_trace.state == TRACE_APPLIED;
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    if (!traced) {
+        ws2812_refresh_multi_async(s_led_strips, LED_LINE_COUNT);
+        return;
+    }
+
+    uint32_t sent_before[LED_LINE_COUNT];
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_stats_t stats;
+        ws2812_get_stats(s_led_strips[line], &stats);
+        sent_before[line] = stats.frames_sent;
     }
 
-    BaseType_t ret = xTaskCreate(
-        animation_task,
-        "led_anim",
-        2048,
-        NULL,
-        5,
-        &s_animation_task_handle
-    );
+    ws2812_refresh_multi_async(s_led_strips, LED_LINE_COUNT);
+    int64_t encoded_us = esp_timer_get_time();
+
+    // The lines start together: the first one that sent ends the trace
+    ws2812_handle_t strip = NULL;
+    uint32_t frame = 0;
+    for (int line = 0; line < LED_LINE_COUNT && strip == NULL; line++) {
+        ws2812_stats_t stats;
+        ws2812_get_stats(s_led_strips[line], &stats);
+        if (stats.frames_sent != sent_before[line]) {
+            strip = s_led_strips[line];
+            frame = stats.frames_sent;
+        }
+    }
 
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create animation task");
-        s_animation_task_handle = NULL;
+    portENTER_CRITICAL(&s_latency_lock);
+    s_trace.encoded_us = encoded_us;
+    if (strip == NULL) {
+        // No LED changed, nothing to wait for
+        record_trace(0);
+    } else if (s_last_done.strip == strip && s_last_done.frame == frame) {
+        record_trace(s_last_done.done_us);
     } else {
-        ESP_LOGI(TAG, "Animation task created");
+        s_trace.strip = strip;
+        s_trace.frame = frame;
+        s_trace.state = TRACE_SENT;
     }
+    portEXIT_CRITICAL(&s_latency_lock);
 }
 
-static void stop_animation_task(void)
+/**
+ * @brief Send one color to all lines in parallel
+ */
+static void fill_leds(uint8_t r, uint8_t g, uint8_t b)
 {
-    if (s_animation_task_handle != NULL) {
-        vTaskDelete(s_animation_task_handle);
-        s_animation_task_handle = NULL;
-        ESP_LOGI(TAG, "Animation task stopped");
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_fill(s_led_strips[line], r, g, b);
     }
-}
 
-// ============================================================================
-// Public Functions
-// ============================================================================
+    refresh_strips();
+}
 
-esp_err_t led_controller_init(void)
+/**
+ * @brief Turn all LEDs off
+ */
+static void clear_leds(void)
 {
-    if (s_initialized) {
-        ESP_LOGW(TAG, "LED controller already initialized");
-        return ESP_OK;
-    }
-
-    ESP_LOGI(TAG, "Initializing LED controller (GPIO %d, %d LEDs)", 
-             LED_GPIO_PIN, LED_STRIP_LENGTH);
+    fill_leds(0, 0, 0);
+}
 
-    // Initialize WS2812 strip with RMT
-    s_led_strip = ws2812_init(LED_GPIO_PIN, LED_STRIP_LENGTH, 0);
-    if (s_led_strip == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize WS2812 strip");
-        return ESP_FAIL;
+/**
+ * @brief Fill a framebuffer range with one color
+ */
+static void fill_framebuffer(uint16_t start, uint16_t count, const led_rgb_t *color)
+{
+    for (uint16_t i = start; i < start + count; i++) {
+        s_framebuffer[i] = *color;
     }
-
-    // Clear LEDs initially
-    ws2812_clear(s_led_strip);
-
-    s_initialized = true;
-    ESP_LOGI(TAG, "LED controller initialized successfully");
-    
-    return ESP_OK;
 }
 
-esp_err_t led_controller_deinit(void)
+/**
+ * @brief Send pixels with the current intensity to all lines
+ */
+static void show_pixels(const led_rgb_t *pixels)
 {
     if (!s_initialized) {
-        return ESP_OK;
+        return;
     }
 
-    ESP_LOGI(TAG, "Deinitializing LED controller");
-
-    // Stop animation if running
-    stop_animation_task();
-
-    // Clear and free LED strip
-    if (s_led_strip != NULL) {
-        ws2812_clear(s_led_strip);
-        ws2812_deinit(s_led_strip);
-        s_led_strip = NULL;
+    // Intensity + gamma are applied by table lookup while copying
+    update_output_lut(s_led_state.intensity);
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_set_pixels(s_led_strips[line], 0,
+                          (const uint8_t *)&pixels[line * LED_LINE_LENGTH],
+                          LED_LINE_LENGTH, s_output_lut);
     }
 
-    s_initialized = false;
-    return ESP_OK;
+    refresh_strips();
 }
 
-esp_err_t led_controller_set_intensity(uint8_t intensity)
+/**
+ * @brief Apply pixels and intensity to all LEDs (dark while off)
+ */
+static void apply_pixels(const led_rgb_t *pixels)
 {
     if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    s_led_state.intensity = intensity;
-    
-    // Auto ON/OFF based on intensity
-    if (intensity == 0) {
-        s_led_state.is_on = false;
-        ESP_LOGI(TAG, "Intensity set to 0 - LEDs OFF");
-    } else {
-        s_led_state.is_on = true;
-        ESP_LOGI(TAG, "Intensity set to %d - LEDs ON", intensity);
+        return;
     }
 
-    // Apply changes if no animation
-    if (s_led_state.animation == LED_ANIM_NONE) {
-        apply_leds();
+    if (!s_led_state.is_on) {
+        // Turn off all LEDs
+        clear_leds();
+        return;
     }
 
-    return ESP_OK;
+    show_pixels(pixels);
 }
 
-esp_err_t led_controller_set_color(uint8_t r, uint8_t g, uint8_t b)
+/**
+ * @brief Apply the framebuffer and intensity to all LEDs
+ */
+static void apply_leds(void)
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    s_led_state.color.r = r;
-    s_led_state.color.g = g;
-    s_led_state.color.b = b;
+    apply_pixels(s_framebuffer);
+}
 
-    ESP_LOGI(TAG, "Color set to RGB(%d, %d, %d)", r, g, b);
+/**
+ * @brief Restart the effect clock for a newly selected effect
+ */
+static void start_effect(int64_t start_us)
+{
+    memset(s_effect_pixels, 0, sizeof(s_effect_pixels));
+    s_effect_frame = 0;
+    s_effect_start_us = start_us;
+}
 
-    // Auto-enable LEDs when color is set (if intensity > 0)
-    if (s_led_state.intensity > 0 && !s_led_state.is_on) {
-        s_led_state.is_on = true;
-        ESP_LOGI(TAG, "LEDs auto-enabled");
+/**
+ * @brief Render and send one effect frame
+ *
+ * @return true if the frame missed its deadline
+ */
+static bool run_effect_frame(const led_effect_t *effect, int64_t period_us)
+{
+    int64_t start_us = esp_timer_get_time();
+    if (s_frame_deadline_us == 0) {
+        s_frame_deadline_us = start_us + period_us;
     }
 
-    // Apply changes if LEDs are on and no animation
-    if (s_led_state.is_on && s_led_state.animation == LED_ANIM_NONE) {
+    led_effect_frame_t frame = {
+        .pixels = s_effect_pixels,
+        .base = s_framebuffer,
+        .count = LED_STRIP_LENGTH,
+        .color = s_led_state.color,
+        .time_us = start_us,
+        .elapsed_ms = (uint32_t)((start_us - s_effect_start_us) / 1000),
+        .frame = s_effect_frame++,
+        .arg = effect->arg,
+    };
+    bool running = effect->render(&frame);
+    s_led_state.color = frame.color;
+
+    int64_t rendered_us = esp_timer_get_time();
+
+    if (running) {
+        apply_pixels(s_effect_pixels);
+    } else {
+        // The last frame becomes the static content
+        memcpy(s_framebuffer, s_effect_pixels, sizeof(s_framebuffer));
+        s_led_state.animation = LED_ANIM_NONE;
         apply_leds();
     }
 
-    return ESP_OK;
-}
+    int64_t done_us = esp_timer_get_time();
 
-esp_err_t led_controller_set_animation(led_animation_t animation)
-{
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
+    uint32_t render_us = (uint32_t)(rendered_us - start_us);
+    uint32_t transmit_us = (uint32_t)(done_us - rendered_us);
+    s_sched_stats.frames++;
+    s_sched_stats.render_us_last = render_us;
+    s_sched_stats.transmit_us_last = transmit_us;
+    if (render_us > s_sched_stats.render_us_max) {
+        s_sched_stats.render_us_max = render_us;
     }
-
-    s_led_state.animation = animation;
-
-    if (animation == LED_ANIM_NONE) {
-        // Stop animation task
-        stop_animation_task();
-        
-        // Restore static color if LEDs are on
-        if (s_led_state.is_on) {
-            apply_leds();
-        }
-        
-        ESP_LOGI(TAG, "Animation stopped");
-    } else {
-        // Start animation task if not running
-        start_animation_task();
-        ESP_LOGI(TAG, "Animation set to: %d", animation);
+    if (transmit_us > s_sched_stats.transmit_us_max) {
+        s_sched_stats.transmit_us_max = transmit_us;
     }
 
-    return ESP_OK;
+    if (done_us > s_frame_deadline_us) {
+        s_sched_stats.deadlines_missed++;
+        s_frame_deadline_us = done_us + period_us;
+        return true;
+    }
+    s_frame_deadline_us += period_us;
+    return false;
 }
 
-esp_err_t led_controller_on(void)
+/**
+ * @brief Wake the LED task to show changed state
+ */
+static void request_refresh(void)
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
+    if (s_led_task_handle != NULL) {
+        xTaskNotifyGive(s_led_task_handle);
     }
+}
 
-    s_led_state.is_on = true;
-    ESP_LOGI(TAG, "LEDs turned ON");
+/**
+ * @brief Origin of a command, NULL = now and not traced
+ */
+static inline led_command_meta_t command_meta(const led_command_meta_t *meta)
+{
+    return meta != NULL ? *meta : (led_command_meta_t){ 0 };
+}
 
-    // Apply changes if no animation is running
-    if (s_led_state.animation == LED_ANIM_NONE) {
-        apply_leds();
+/**
+ * @brief Queue a command for the LED task without waking it
+ */
+static esp_err_t queue_command(const led_command_t *cmd)
+{
+    if (!led_command_push(&s_commands, cmd)) {
+        ESP_LOGW(TAG, "Command queue full, command %d dropped", cmd->type);
+        return ESP_ERR_NO_MEM;
     }
-
     return ESP_OK;
 }
 
-esp_err_t led_controller_off(void)
+/**
+ * @brief Queue a command and wake the LED task
+ */
+static esp_err_t post_command(const led_command_t *cmd)
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    s_led_state.is_on = false;
-    ESP_LOGI(TAG, "LEDs turned OFF");
+    esp_err_t ret = queue_command(cmd);
+    request_refresh();
+    return ret;
+}
 
-    // Stop animation and clear LEDs
-    stop_animation_task();
-    ws2812_clear(s_led_strip);
+/**
+ * @brief Hand the restorable part of s_led_state to the persist writer (LED task)
+ *
+ * A fade is saved with its target. Timelines are not saved, so while one
+ * plays the state before it stays saved.
+ */
+static void persist_state(void)
+{
+#if SMARTLOVE_LED_PERSIST_ENABLED
+    led_persist_state_t state = {
+        .is_on = s_led_state.is_on,
+        .intensity = s_led_state.intensity,
+        .color = s_led_state.color,
+        .animation = s_led_state.animation,
+    };
+
+    if (state.animation == LED_ANIM_TIMELINE) {
+        return;
+    }
+    if (state.animation == LED_ANIM_FADE) {
+        state.color = s_led_state.fade_target;
+        state.animation = LED_ANIM_NONE;
+    } else if (state.animation >= LED_ANIM_BUILTIN_COUNT) {
+        // Registered effects may get other ids in the next firmware
+        state.animation = LED_ANIM_NONE;
+    }
+    led_persist_request(&state);
+#endif
+}
 
-    return ESP_OK;
+/**
+ * @brief Publish s_led_state for led_controller_get_state() (LED task)
+ *
+ * Also hands it to the persist writer, which ignores unchanged states.
+ */
+static void publish_state(void)
+{
+    uint_fast32_t seq = atomic_load_explicit(&s_snapshot_seq, memory_order_relaxed);
+    led_snapshot_t *slot = &s_snapshots[((seq >> 1) + 1) & 1];
+
+    atomic_store_explicit(&s_snapshot_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->state = s_led_state;
+    slot->fade_start_us = s_fade.start_us;
+    slot->timeline_clock = s_timeline_player.clock;
+    slot->timeline_count = s_timeline_player.timeline.count;
+    slot->timeline_duration_ms = s_timeline_player.timeline.duration_ms;
+    slot->timeline_loop = s_timeline_player.timeline.loop;
+    atomic_store_explicit(&s_snapshot_seq, seq + 2, memory_order_release);
+
+    persist_state();
 }
 
-esp_err_t led_controller_get_state(led_state_t *state)
+/**
+ * @brief Read the latest published state (any task, never blocks)
+ */
+static void read_snapshot(led_snapshot_t *out)
 {
-    if (state == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    for (;;) {
+        uint_fast32_t seq = atomic_load_explicit(&s_snapshot_seq, memory_order_acquire);
+        *out = s_snapshots[(seq >> 1) & 1];
+        atomic_thread_fence(memory_order_acquire);
+
+        // The slot is only rewritten once the LED task starts the
+        // publication after the next one
+        uint_fast32_t now = atomic_load_explicit(&s_snapshot_seq, memory_order_relaxed);
+        if (now - (seq & ~(uint_fast32_t)1) <= 2) {
+            return;
+        }
     }
-    *state = s_led_state;
-    return ESP_OK;
 }
 
-esp_err_t led_controller_process_json(const char *json_str)
+/**
+ * @brief Turn the LEDs on after new content, if the intensity allows
+ */
+static void auto_enable(void)
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "LED controller not initialized");
-        return ESP_ERR_INVALID_STATE;
+    if (s_led_state.intensity > 0 && !s_led_state.is_on) {
+        s_led_state.is_on = true;
+        ESP_LOGI(TAG, "LEDs auto-enabled");
     }
+}
 
-    if (json_str == NULL) {
-        ESP_LOGE(TAG, "NULL JSON string");
-        return ESP_ERR_INVALID_ARG;
-    }
+/**
+ * @brief Apply one command to s_led_state (LED task)
+ *
+ * Effects, fades and timelines started by a scheduled command take its
+ * start time as their origin, so devices applying the same command a few
+ * ms apart still run in phase.
+ */
+static void apply_command(const led_command_t *cmd)
+{
+    const int64_t start_us = cmd->meta.at_us != 0 ? cmd->meta.at_us : esp_timer_get_time();
 
-    // Parse JSON
-    cJSON *root = cJSON_Parse(json_str);
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
-        return ESP_ERR_INVALID_ARG;
+    // Scheduled commands wait on purpose; their latency says nothing
+    if (cmd->meta.rx_us != 0 && cmd->meta.at_us == 0) {
+        trace_applied(&cmd->meta);
     }
 
-    bool success = true;
-
-    // Parse "intensity" (0-255)
-    cJSON *intensity_item = cJSON_GetObjectItem(root, "intensity");
-    if (intensity_item != NULL && cJSON_IsNumber(intensity_item)) {
-        int intensity = intensity_item->valueint;
+    switch (cmd->type) {
+        case LED_CMD_INTENSITY:
+            s_led_state.intensity = cmd->intensity;
+            // Auto ON/OFF based on intensity
+            s_led_state.is_on = cmd->intensity > 0;
+            break;
+
+        case LED_CMD_COLOR:
+            s_led_state.color = cmd->color;
+            fill_framebuffer(0, LED_STRIP_LENGTH, &s_led_state.color);
+            auto_enable();
+            break;
+
+        case LED_CMD_RANGE:
+            fill_framebuffer(cmd->range.start, cmd->range.count, &cmd->range.color);
+            auto_enable();
+            break;
+
+        case LED_CMD_COMMIT:
+            led_staging_apply(&s_staging[cmd->commit.source], cmd->commit.frame, s_framebuffer);
+            auto_enable();
+            if (cmd->commit.stream_frame && s_led_state.is_on &&
+                s_led_state.animation == LED_ANIM_NONE) {
+                s_frames_displayed++;
+            }
+            break;
+
+        case LED_CMD_ANIMATION:
+            if (cmd->animation != LED_ANIM_NONE && cmd->animation != s_led_state.animation) {
+                start_effect(start_us);
+                if (cmd->animation == LED_ANIM_TIMELINE) {
+                    led_timeline_play(&s_timeline_player.clock, &s_timeline_player.timeline,
+                                      start_us);
+                }
+            }
+            s_led_state.animation = cmd->animation;
+            break;
+
+        case LED_CMD_FADE:
+            s_led_state.fade_start = s_led_state.color;
+            s_led_state.fade_target = cmd->fade.target;
+            s_led_state.fade_time_ms = cmd->fade.duration_ms;
+            s_led_state.fade_elapsed_ms = 0;
+            s_led_state.fade_easing = cmd->fade.easing;
+            led_fade_start(&s_fade, s_led_state.fade_start, s_led_state.fade_target,
+                           cmd->fade.duration_ms, cmd->fade.easing, start_us);
+            start_effect(start_us);
+            s_led_state.animation = LED_ANIM_FADE;
+            break;
+
+        case LED_CMD_ON:
+            // Resumes a paused animation as well
+            s_led_state.is_on = true;
+            break;
+
+        case LED_CMD_OFF:
+            // Clears the LEDs and pauses a running animation
+            s_led_state.is_on = false;
+            break;
+
+        case LED_CMD_TIMELINE_LOAD:
+            s_timeline_player.timeline = s_timeline_upload;
+            atomic_flag_clear(&s_timeline_upload_busy);
+            led_timeline_play(&s_timeline_player.clock, &s_timeline_player.timeline, start_us);
+            if (!cmd->autoplay) {
+                led_timeline_pause(&s_timeline_player.clock, start_us);
+            }
+            start_effect(start_us);
+            s_led_state.animation = LED_ANIM_TIMELINE;
+            break;
+
+        case LED_CMD_TIMELINE_PLAY: {
+            const led_timeline_t *timeline = &s_timeline_player.timeline;
+            if (!timeline->loop &&
+                led_timeline_position(&s_timeline_player.clock, start_us) >= timeline->duration_ms) {
+                // Ended: play again from the start
+                led_timeline_play(&s_timeline_player.clock, timeline, start_us);
+            } else {
+                led_timeline_resume(&s_timeline_player.clock, start_us);
+            }
+            if (s_led_state.animation != LED_ANIM_TIMELINE) {
+                start_effect(start_us);
+                s_led_state.animation = LED_ANIM_TIMELINE;
+            }
+            break;
+        }
+
+        case LED_CMD_TIMELINE_PAUSE:
+            led_timeline_pause(&s_timeline_player.clock, start_us);
+            break;
+
+        case LED_CMD_TIMELINE_SEEK:
+            led_timeline_seek(&s_timeline_player.clock, cmd->position_ms, start_us);
+            break;
+    }
+}
+
+/**
+ * @brief Park a command until its start time (LED task)
+ *
+ * Commands with the same start time keep their queue order.
+ */
+static void schedule_command(const led_command_t *cmd)
+{
+    if (s_scheduled_count >= LED_SCHEDULED_MAX) {
+        atomic_fetch_add_explicit(&s_commands.dropped, 1, memory_order_relaxed);
+        ESP_LOGW(TAG, "Too many scheduled commands, command %d dropped", cmd->type);
+        return;
+    }
+
+    uint8_t i = s_scheduled_count;
+    while (i > 0 && s_scheduled[i - 1].meta.at_us > cmd->meta.at_us) {
+        s_scheduled[i] = s_scheduled[i - 1];
+        i--;
+    }
+    s_scheduled[i] = *cmd;
+    s_scheduled_count++;
+}
+
+/**
+ * @brief Wake the LED task when a scheduled command is due
+ */
+static void schedule_timer_cb(void *arg)
+{
+    request_refresh();
+}
+
+/**
+ * @brief Apply due scheduled commands, then all queued ones (LED task)
+ */
+static void process_commands(void)
+{
+    led_command_t cmd;
+    bool changed = false;
+    int64_t now_us = esp_timer_get_time();
+
+    uint8_t due = 0;
+    while (due < s_scheduled_count && s_scheduled[due].meta.at_us <= now_us) {
+        apply_command(&s_scheduled[due]);
+        due++;
+    }
+    if (due > 0) {
+        memmove(&s_scheduled[0], &s_scheduled[due],
+                (s_scheduled_count - due) * sizeof(led_command_t));
+        s_scheduled_count -= due;
+        changed = true;
+    }
+
+    while (led_command_pop(&s_commands, &cmd)) {
+        if (cmd.meta.at_us > now_us) {
+            schedule_command(&cmd);
+            continue;
+        }
+        apply_command(&cmd);
+        changed = true;
+    }
+
+    if (s_scheduled_count > 0) {
+        // Re-arm for the earliest start time (stop fails if it already fired)
+        esp_timer_stop(s_schedule_timer);
+        esp_timer_start_once(s_schedule_timer, (uint64_t)(s_scheduled[0].meta.at_us - now_us));
+    }
+
+    if (changed) {
+        publish_state();
+    }
+}
+
+/**
+ * @brief Restore the saved state over the config defaults (init)
+ *
+ * @return true if a saved state was restored
+ */
+static bool restore_state(void)
+{
+#if SMARTLOVE_LED_PERSIST_ENABLED
+    led_persist_state_t saved;
+    esp_err_t err = led_persist_load(&saved);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NOT_FOUND) {
+            ESP_LOGW(TAG, "Failed to read saved LED state: %s", esp_err_to_name(err));
+        }
+        return false;
+    }
+
+    s_led_state.is_on = saved.is_on;
+    s_led_state.intensity = saved.intensity;
+    s_led_state.color = saved.color;
+    s_led_state.fade_start = saved.color;
+    s_led_state.fade_target = saved.color;
+    s_led_state.animation = saved.animation;
+    if (saved.animation != LED_ANIM_NONE) {
+        start_effect(esp_timer_get_time());
+    }
+    ESP_LOGI(TAG, "Restored LED state: %s, intensity %d, RGB(%d,%d,%d), animation %d",
+             saved.is_on ? "on" : "off", saved.intensity,
+             saved.color.r, saved.color.g, saved.color.b, saved.animation);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief LED task: the only owner of the LED state and output
+ *
+ * Sleeps on its task notification while the content is static and wakes
+ * only for commands (post_command()) or effect frame deadlines. It runs
+ * for the lifetime of the controller and is never deleted mid-frame.
+ */
+static void led_task(void *pvParameters)
+{
+    TickType_t period = pdMS_TO_TICKS(1000 / LED_FRAME_RATE);
+    if (period == 0) {
+        period = 1;
+    }
+    const int64_t period_us = (int64_t)period * portTICK_PERIOD_MS * 1000;
+
+    ESP_LOGI(TAG, "LED task started (%d ms frame period)", (int)(period * portTICK_PERIOD_MS));
+
+    // Nothing to show before the first command or a restored state (init
+    // leaves the LEDs dark)
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    TickType_t next_wake = xTaskGetTickCount();
+    while (!s_led_task_exit) {
+        process_commands();
+
+        const led_effect_t *effect = s_led_state.is_on ? led_effect_get(s_led_state.animation) : NULL;
+
+        if (effect == NULL) {
+            // Static content: show it once, then sleep until the next command
+            apply_leds();
+            s_frame_deadline_us = 0;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            next_wake = xTaskGetTickCount();
+            continue;
+        }
+
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next_wake - now) > 0) {
+            // Wait for the frame deadline; a command wakes us early to
+            // apply it
+            ulTaskNotifyTake(pdTRUE, next_wake - now);
+            continue;
+        }
+
+        bool missed = run_effect_frame(effect, period_us);
+        // Effects update the shown color, and a finished effect ends the animation
+        publish_state();
+        if (missed) {
+            // Overran: continue from now instead of rendering the missed
+            // frames back to back
+            next_wake = xTaskGetTickCount() + period;
+        } else {
+            next_wake += period;
+        }
+    }
+
+    ESP_LOGI(TAG, "LED task stopped");
+    s_led_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t led_controller_fade_to(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms)
+{
+    return led_controller_fade_to_ex(r, g, b, duration_ms, LED_EASE_LINEAR);
+}
+
+/**
+ * @brief Fade to a color (meta: start time and trace, NULL = now)
+ */
+static esp_err_t fade_to_at(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms,
+                            led_easing_t easing, const led_command_meta_t *meta)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    led_command_t cmd = {
+        .type = LED_CMD_FADE,
+        .meta = command_meta(meta),
+        .fade = {
+            .target = { .r = r, .g = g, .b = b },
+            .duration_ms = duration_ms,
+            .easing = easing,
+        },
+    };
+    ESP_LOGI(TAG, "Fade to RGB(%d,%d,%d) in %d ms (easing %d)", r, g, b, duration_ms, easing);
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_fade_to_ex(uint8_t r, uint8_t g, uint8_t b, uint32_t duration_ms,
+                                    led_easing_t easing)
+{
+    return fade_to_at(r, g, b, duration_ms, easing, NULL);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+esp_err_t led_controller_init(void)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "LED controller already initialized");
+        return ESP_OK;
+    }
+
+    led_effect_register_as(LED_ANIM_FADE, &s_fade_effect);
+    led_effect_register_as(LED_ANIM_TIMELINE, &s_timeline_effect);
+    if (s_json_lock == NULL) {
+        s_json_lock = xSemaphoreCreateMutexStatic(&s_json_lock_buf);
+    }
+
+    ESP_LOGI(TAG, "Initializing LED controller (GPIO %d, %d LEDs, %d line(s))", 
+             LED_GPIO_PIN, LED_STRIP_LENGTH, LED_LINE_COUNT);
+
+    // Initialize WS2812 strips with RMT, one channel per line
+    static const uint8_t line_gpios[LED_LINE_COUNT] = SMARTLOVE_GPIO_LED_LINES;
+#if SMARTLOVE_LED_STATIC_ALLOC
+    ws2812_static_mem_t strip_mem[LED_LINE_COUNT];
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        strip_mem[line] = (ws2812_static_mem_t) {
+            .strip = &s_strip_storage[line],
+            .pixels = s_strip_pixels[line],
+            .encode = s_strip_encode[line],
+            .encode_words = LED_ENCODE_WORDS,
+        };
+    }
+    esp_err_t ret = ws2812_init_multi_static(line_gpios, LED_LINE_COUNT, LED_LINE_LENGTH,
+                                             LED_RMT_CHANNEL, LED_PIXEL_FORMAT, strip_mem,
+                                             s_led_strips);
+#else
+    esp_err_t ret = ws2812_init_multi(line_gpios, LED_LINE_COUNT, LED_LINE_LENGTH,
+                                      LED_RMT_CHANNEL, LED_PIXEL_FORMAT, s_led_strips);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize WS2812 strip");
+        return ESP_FAIL;
+    }
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_register_done_callback(s_led_strips[line], strip_done_cb, NULL);
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = schedule_timer_cb,
+        .name = "led_schedule",
+    };
+    ret = esp_timer_create(&timer_args, &s_schedule_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create schedule timer");
+        for (int line = 0; line < LED_LINE_COUNT; line++) {
+            ws2812_deinit(s_led_strips[line]);
+            s_led_strips[line] = NULL;
+        }
+        return ret;
+    }
+
+    bool restored = restore_state();
+    fill_framebuffer(0, LED_STRIP_LENGTH, &s_led_state.color);
+    led_command_queue_init(&s_commands);
+    s_scheduled_count = 0;
+    for (int source = 0; source < LED_SOURCE_COUNT; source++) {
+        led_staging_init(&s_staging[source]);
+    }
+    publish_state();
+    s_initialized = true;
+
+    // Show a restored scene before returning (the task does not run yet),
+    // so it is lit before networking comes up; otherwise stay dark until
+    // the first command
+    if (restored) {
+        apply_leds();
+    } else {
+        clear_leds();
+    }
+
+    s_led_task_exit = false;
+#if SMARTLOVE_LED_STATIC_ALLOC
+    s_led_task_handle = xTaskCreateStatic(led_task, "led_task", LED_TASK_STACK_SIZE, NULL,
+                                          LED_TASK_PRIORITY, s_led_task_stack, &s_led_task_tcb);
+    if (s_led_task_handle == NULL) {
+#else
+    if (xTaskCreate(led_task, "led_task", LED_TASK_STACK_SIZE, NULL,
+                    LED_TASK_PRIORITY, &s_led_task_handle) != pdPASS) {
+#endif
+        ESP_LOGE(TAG, "Failed to create LED task");
+        s_led_task_handle = NULL;
+        s_initialized = false;
+        esp_timer_delete(s_schedule_timer);
+        s_schedule_timer = NULL;
+        for (int line = 0; line < LED_LINE_COUNT; line++) {
+            ws2812_deinit(s_led_strips[line]);
+            s_led_strips[line] = NULL;
+        }
+        return ESP_FAIL;
+    }
+
+#if SMARTLOVE_LED_PERSIST_ENABLED
+    // Without the writer the state is only not saved; the LEDs still work
+    led_persist_start();
+#endif
+    if (restored && s_led_state.animation != LED_ANIM_NONE) {
+        // Continue the restored animation
+        request_refresh();
+    }
+
+    ESP_LOGI(TAG, "LED controller initialized successfully");
+    
+    return ESP_OK;
+}
+
+esp_err_t led_controller_deinit(void)
+{
+    if (!s_initialized) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Deinitializing LED controller");
+
+    // Let the LED task finish its current frame and exit
+    s_led_task_exit = true;
+    request_refresh();
+    for (int i = 0; s_led_task_handle != NULL && i < 100; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (s_led_task_handle != NULL) {
+        ESP_LOGE(TAG, "LED task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+#if SMARTLOVE_LED_STATIC_ALLOC
+    // The idle task still has to release the deleted task before another
+    // init can reuse its static stack and TCB
+    vTaskDelay(pdMS_TO_TICKS(20));
+#endif
+
+    esp_timer_stop(s_schedule_timer);
+    esp_timer_delete(s_schedule_timer);
+    s_schedule_timer = NULL;
+
+#if SMARTLOVE_LED_PERSIST_ENABLED
+    // Save the last change now instead of at the end of its window
+    led_persist_stop();
+#endif
+
+    // Clear and free LED strips (deinit waits for the frame in flight)
+    clear_leds();
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_deinit(s_led_strips[line]);
+        s_led_strips[line] = NULL;
+    }
+
+    s_initialized = false;
+    return ESP_OK;
+}
+
+/**
+ * @brief Set the intensity (meta: start time and trace, NULL = now)
+ */
+static esp_err_t set_intensity_at(uint8_t intensity, const led_command_meta_t *meta)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Auto ON/OFF based on intensity
+    if (intensity == 0) {
+        ESP_LOGI(TAG, "Intensity set to 0 - LEDs OFF");
+    } else {
+        ESP_LOGI(TAG, "Intensity set to %d - LEDs ON", intensity);
+    }
+
+    led_command_t cmd = {
+        .type = LED_CMD_INTENSITY,
+        .meta = command_meta(meta),
+        .intensity = intensity,
+    };
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_set_intensity(uint8_t intensity)
+{
+    return set_intensity_at(intensity, NULL);
+}
+
+/**
+ * @brief Set the color (meta: start time and trace, NULL = now)
+ */
+static esp_err_t set_color_at(uint8_t r, uint8_t g, uint8_t b, const led_command_meta_t *meta)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "Color set to RGB(%d, %d, %d)", r, g, b);
+
+    // Also auto-enables the LEDs (if intensity > 0)
+    led_command_t cmd = {
+        .type = LED_CMD_COLOR,
+        .meta = command_meta(meta),
+        .color = { .r = r, .g = g, .b = b },
+    };
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_set_color(uint8_t r, uint8_t g, uint8_t b)
+{
+    return set_color_at(r, g, b, NULL);
+}
+
+/**
+ * @brief Show the pixels staged by a producer, enabling the LEDs like
+ * set_color does (producer task; meta: start time and trace, NULL = now)
+ */
+static esp_err_t commit_framebuffer(led_source_t source, bool stream_frame,
+                                    const led_command_meta_t *meta)
+{
+    uint32_t frame;
+    if (!led_staging_publish(&s_staging[source], &frame)) {
+        ESP_LOGW(TAG, "All %d staging frames waiting, commit dropped", LED_STAGING_FRAMES);
+        request_refresh();
+        return ESP_ERR_NO_MEM;
+    }
+
+    led_command_t cmd = {
+        .type = LED_CMD_COMMIT,
+        .meta = command_meta(meta),
+        .commit = { .source = source, .frame = frame, .stream_frame = stream_frame },
+    };
+    return post_command(&cmd);
+}
+
+/**
+ * @brief Queue a framebuffer range fill, shown by the next commit
+ * (meta: start time and trace, NULL = now)
+ */
+static esp_err_t queue_range(uint16_t start, uint16_t count, const led_rgb_t *color,
+                             const led_command_meta_t *meta)
+{
+    led_command_t cmd = {
+        .type = LED_CMD_RANGE,
+        .meta = command_meta(meta),
+        .range = { .start = start, .count = count, .color = *color },
+    };
+    return queue_command(&cmd);
+}
+
+esp_err_t led_controller_set_pixels(uint16_t start, const led_rgb_t *pixels, uint16_t count)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((pixels == NULL && count > 0) || (uint32_t)start + count > LED_STRIP_LENGTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_staging_t *staging = &s_staging[LED_SOURCE_COMMAND];
+    memcpy(&led_staging_buffer(staging)[start], pixels, (size_t)count * sizeof(led_rgb_t));
+    led_staging_mark(staging, start, (uint32_t)start + count);
+    return commit_framebuffer(LED_SOURCE_COMMAND, false, NULL);
+}
+
+esp_err_t led_controller_set_range(uint16_t start, uint16_t count, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((uint32_t)start + count > LED_STRIP_LENGTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_rgb_t color = { .r = r, .g = g, .b = b };
+    esp_err_t ret = queue_range(start, count, &color, NULL);
+    request_refresh();
+    return ret;
+}
+
+esp_err_t led_controller_write_framebuffer(size_t offset, const uint8_t *data, size_t len)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((data == NULL && len > 0) || offset + len > LED_STRIP_LENGTH * sizeof(led_rgb_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+
+    led_staging_t *staging = &s_staging[LED_SOURCE_REALTIME];
+    memcpy((uint8_t *)led_staging_buffer(staging) + offset, data, len);
+    led_staging_mark(staging, offset / 3, (offset + len + 2) / 3);
+    return ESP_OK;
+}
+
+/**
+ * @brief Tell from the published state whether a commit will be shown
+ */
+static bool commit_will_show(void)
+{
+    led_snapshot_t snap;
+    read_snapshot(&snap);
+    return (snap.state.is_on || snap.state.intensity > 0) &&
+           snap.state.animation == LED_ANIM_NONE;
+}
+
+esp_err_t led_controller_show_frame(void)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = commit_framebuffer(LED_SOURCE_REALTIME, false, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return commit_will_show() ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+/**
+ * @brief Start a binary frame from its first chunk
+ */
+static esp_err_t begin_frame(const uint8_t *data, size_t len, size_t total_len)
+{
+    s_frame_rx.active = false;
+    s_frames_received++;
+
+    if (total_len % 3 == 0) {
+        // Raw RGB from LED 0
+        s_frame_rx.grb = false;
+        s_frame_rx.header_len = 0;
+        s_frame_rx.dst_start = 0;
+    } else if (total_len % 3 == LED_FRAME_HEADER_LEN % 3 && len >= LED_FRAME_HEADER_LEN &&
+               (data[0] == LED_FRAME_FORMAT_RGB || data[0] == LED_FRAME_FORMAT_GRB)) {
+        s_frame_rx.grb = data[0] == LED_FRAME_FORMAT_GRB;
+        s_frame_rx.header_len = LED_FRAME_HEADER_LEN;
+        s_frame_rx.dst_start = (((uint32_t)data[2] << 8) | data[3]) * 3;
+    } else {
+        ESP_LOGW(TAG, "Invalid frame header (%u bytes)", (unsigned int)total_len);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_frame_rx.dst_start + (total_len - s_frame_rx.header_len) >
+        LED_STRIP_LENGTH * sizeof(led_rgb_t)) {
+        ESP_LOGW(TAG, "Frame exceeds strip (%u bytes at LED %u)",
+                 (unsigned int)total_len, (unsigned int)(s_frame_rx.dst_start / 3));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_frame_rx.active = true;
+    return ESP_OK;
+}
+
+esp_err_t led_controller_write_frame(const uint8_t *data, size_t len, size_t offset,
+                                     size_t total_len)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((data == NULL && len > 0) || offset + len > total_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (offset == 0) {
+        esp_err_t ret = begin_frame(data, len, total_len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    } else if (!s_frame_rx.active) {
+        // Rest of a rejected frame
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bool last_chunk = offset + len == total_len;
+
+    // Skip the header, the rest maps 1:1 onto framebuffer bytes
+    size_t skip = offset < s_frame_rx.header_len ? s_frame_rx.header_len - offset : 0;
+    uint32_t pos = offset + skip - s_frame_rx.header_len;
+    data += skip;
+    len -= skip;
+
+    led_staging_t *staging = &s_staging[LED_SOURCE_COMMAND];
+    uint8_t *fb = (uint8_t *)led_staging_buffer(staging) + s_frame_rx.dst_start;
+    if (!s_frame_rx.grb) {
+        memcpy(fb + pos, data, len);
+    } else {
+        // Chunks may split a pixel, so track the channel per byte
+        static const uint8_t grb_to_rgb[3] = { 1, 0, 2 };
+        uint32_t channel = pos % 3;
+        uint8_t *pixel = fb + pos - channel;
+        for (size_t i = 0; i < len; i++) {
+            pixel[grb_to_rgb[channel]] = data[i];
+            if (++channel == 3) {
+                channel = 0;
+                pixel += 3;
+            }
+        }
+    }
+    if (len > 0) {
+        uint32_t first = s_frame_rx.dst_start + pos;
+        led_staging_mark(staging, first / 3, (first + len + 2) / 3);
+    }
+
+    if (last_chunk) {
+        // The LED task counts the frame as displayed if it is shown
+        s_frame_rx.active = false;
+        commit_framebuffer(LED_SOURCE_COMMAND, true, NULL);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Select an animation (meta: start time and trace, NULL = now)
+ */
+static esp_err_t set_animation_at(led_animation_t animation, const led_command_meta_t *meta)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (animation != LED_ANIM_NONE && led_effect_get(animation) == NULL) {
+        ESP_LOGW(TAG, "Unknown animation: %d", animation);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (animation == LED_ANIM_NONE) {
+        ESP_LOGI(TAG, "Animation stopped");
+    } else {
+        ESP_LOGI(TAG, "Animation set to: %d", animation);
+    }
+
+    // The LED task restores the static content or starts rendering
+    led_command_t cmd = {
+        .type = LED_CMD_ANIMATION,
+        .meta = command_meta(meta),
+        .animation = animation,
+    };
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_set_animation(led_animation_t animation)
+{
+    return set_animation_at(animation, NULL);
+}
+
+esp_err_t led_controller_on(void)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "LEDs turned ON");
+
+    // Resumes a paused animation as well
+    led_command_t cmd = { .type = LED_CMD_ON };
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_off(void)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "LEDs turned OFF");
+
+    // The LED task clears the LEDs and pauses a running animation
+    led_command_t cmd = { .type = LED_CMD_OFF };
+    return post_command(&cmd);
+}
+
+/**
+ * @brief Hand s_timeline_upload to the LED task (upload flag held)
+ */
+static esp_err_t post_timeline(bool autoplay, const led_command_meta_t *meta)
+{
+    if (!led_timeline_is_valid(&s_timeline_upload)) {
+        atomic_flag_clear(&s_timeline_upload_busy);
+        ESP_LOGW(TAG, "Invalid timeline (%u keyframes)", s_timeline_upload.count);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_command_t cmd = {
+        .type = LED_CMD_TIMELINE_LOAD,
+        .meta = command_meta(meta),
+        .autoplay = autoplay,
+    };
+    esp_err_t ret = post_command(&cmd);
+    if (ret != ESP_OK) {
+        atomic_flag_clear(&s_timeline_upload_busy);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Timeline loaded: %u keyframes, %u ms%s", s_timeline_upload.count,
+             (unsigned int)s_timeline_upload.duration_ms, s_timeline_upload.loop ? ", loop" : "");
+    return ESP_OK;
+}
+
+esp_err_t led_controller_load_timeline(const led_timeline_t *timeline, bool autoplay)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (timeline == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (atomic_flag_test_and_set(&s_timeline_upload_busy)) {
+        ESP_LOGW(TAG, "Previous timeline upload still pending");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_timeline_upload = *timeline;
+    return post_timeline(autoplay, NULL);
+}
+
+/**
+ * @brief Queue a timeline play, pause or seek (meta: start time and trace, NULL = now)
+ */
+static esp_err_t timeline_command_at(led_command_type_t type, uint32_t position_ms,
+                                     const led_command_meta_t *meta)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    led_command_t cmd = { .type = type, .meta = command_meta(meta), .position_ms = position_ms };
+    return post_command(&cmd);
+}
+
+esp_err_t led_controller_timeline_play(void)
+{
+    return timeline_command_at(LED_CMD_TIMELINE_PLAY, 0, NULL);
+}
+
+esp_err_t led_controller_timeline_pause(void)
+{
+    return timeline_command_at(LED_CMD_TIMELINE_PAUSE, 0, NULL);
+}
+
+esp_err_t led_controller_timeline_seek(uint32_t position_ms)
+{
+    return timeline_command_at(LED_CMD_TIMELINE_SEEK, position_ms, NULL);
+}
+
+esp_err_t led_controller_get_state(led_state_t *state)
+{
+    if (state == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized) {
+        *state = s_led_state;
+        return ESP_OK;
+    }
+
+    // Consistent copy of what the LED task last applied; commands still
+    // in the queue are not included
+    led_snapshot_t snap;
+    read_snapshot(&snap);
+    *state = snap.state;
+
+    // Fade progress is derived from the fade clock
+    if (state->fade_time_ms > 0) {
+        int64_t elapsed_ms = (esp_timer_get_time() - snap.fade_start_us) / 1000;
+        if (elapsed_ms > state->fade_time_ms || state->animation != LED_ANIM_FADE) {
+            elapsed_ms = state->fade_time_ms;
+        }
+        state->fade_elapsed_ms = (uint32_t)(elapsed_ms < 0 ? 0 : elapsed_ms);
+    }
+
+    // Timeline position likewise
+    state->timeline_keyframes = snap.timeline_count;
+    state->timeline_paused = snap.timeline_clock.paused;
+    state->timeline_position_ms = 0;
+    if (snap.timeline_count > 0) {
+        // Looping timelines come back wrapped
+        uint32_t position_ms = led_timeline_position(&snap.timeline_clock, esp_timer_get_time());
+        if (!snap.timeline_loop && position_ms > snap.timeline_duration_ms) {
+            position_ms = snap.timeline_duration_ms;
+        }
+        state->timeline_position_ms = position_ms;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_controller_get_stats(led_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (int line = 0; line < LED_LINE_COUNT; line++) {
+        ws2812_stats_t line_stats;
+        if (ws2812_get_stats(s_led_strips[line], &line_stats) == ESP_OK) {
+            stats->frames_sent += line_stats.frames_sent;
+            stats->frames_skipped += line_stats.frames_skipped;
+        }
+    }
+    stats->stream_frames_received = s_frames_received;
+    stats->stream_frames_displayed = s_frames_displayed;
+    stats->effect_frames = s_sched_stats.frames;
+    stats->deadlines_missed = s_sched_stats.deadlines_missed;
+    stats->render_us_last = s_sched_stats.render_us_last;
+    stats->render_us_max = s_sched_stats.render_us_max;
+    stats->transmit_us_last = s_sched_stats.transmit_us_last;
+    stats->transmit_us_max = s_sched_stats.transmit_us_max;
+    stats->commands_dropped = (uint32_t)atomic_load(&s_commands.dropped);
+
+    led_persist_stats_t persist_stats;
+    led_persist_get_stats(&persist_stats);
+    stats->state_writes = persist_stats.writes;
+    stats->state_writes_total = persist_stats.writes_total;
+    return ESP_OK;
+}
+
+esp_err_t led_controller_get_latency(led_latency_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_latency_lock);
+    for (int stage = 0; stage < LED_LATENCY_STAGE_COUNT; stage++) {
+        led_latency_summarize(&s_latency[stage], &stats->stages[stage]);
+    }
+    stats->traces_unchanged = s_traces_unchanged;
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ESP_OK;
+}
+
+esp_err_t led_controller_reset_latency(void)
+{
+    portENTER_CRITICAL(&s_latency_lock);
+    memset(s_latency, 0, sizeof(s_latency));
+    s_traces_unchanged = 0;
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Members of a color object
+ */
+enum {
+    JSON_COLOR_HSV,
+    JSON_COLOR_HSL,
+    JSON_COLOR_R,
+    JSON_COLOR_G,
+    JSON_COLOR_B,
+    JSON_COLOR_KEYS
+};
+
+static const char *const s_json_color_keys[JSON_COLOR_KEYS] = {
+    [JSON_COLOR_HSV] = "hsv",
+    [JSON_COLOR_HSL] = "hsl",
+    [JSON_COLOR_R] = "r",
+    [JSON_COLOR_G] = "g",
+    [JSON_COLOR_B] = "b",
+};
+
+/**
+ * @brief Read {"h": 0-360, "s": 0-100, "v"/"l": 0-100} or [h, s, v/l]
+ *
+ * @param doc Command document
+ * @param item "hsv" or "hsl" value
+ * @param hsl true for HSL, false for HSV
+ * @param color Output RGB color
+ */
+static bool json_get_hsx(const led_json_t *doc, int item, bool hsl, led_rgb_t *color)
+{
+    static const char *const hsv_keys[3] = { "h", "s", "v" };
+    static const char *const hsl_keys[3] = { "h", "s", "l" };
+    int values[3];
+
+    if (led_json_type(doc, item) == LED_JSON_ARRAY && led_json_size(doc, item) == 3) {
+        values[0] = led_json_first(doc, item);
+        values[1] = led_json_next(doc, values[0]);
+        values[2] = led_json_next(doc, values[1]);
+    } else if (led_json_type(doc, item) == LED_JSON_OBJECT) {
+        led_json_get_members(doc, item, hsl ? hsl_keys : hsv_keys, 3, values);
+    } else {
+        return false;
+    }
+
+    double h;
+    double s;
+    double x;
+    if (!led_json_get_number(doc, values[0], &h) || !led_json_get_number(doc, values[1], &s) ||
+        !led_json_get_number(doc, values[2], &x)) {
+        return false;
+    }
+    if (h < 0 || h > 360 || s < 0 || s > 100 || x < 0 || x > 100) {
+        return false;
+    }
+
+    uint16_t hue = (uint16_t)((uint32_t)(h * LED_HUE_MAX / 360 + 0.5) % LED_HUE_MAX);
+    uint8_t sat = (uint8_t)(s * 255 / 100 + 0.5);
+    uint8_t level = (uint8_t)(x * 255 / 100 + 0.5);
+    if (hsl) {
+        *color = led_hsl_to_rgb((led_hsl_t){ .h = hue, .s = sat, .l = level });
+    } else {
+        *color = led_hsv_to_rgb((led_hsv_t){ .h = hue, .s = sat, .v = level });
+    }
+    return true;
+}
+
+/**
+ * @brief Check if color members are given as "hsv" or "hsl"
+ */
+static bool json_has_hsx(const int *members)
+{
+    return members[JSON_COLOR_HSV] >= 0 || members[JSON_COLOR_HSL] >= 0;
+}
+
+/**
+ * @brief Read the r, g and b members as given (not range checked)
+ */
+static bool json_get_rgb_values(const led_json_t *doc, const int *members, int rgb[3])
+{
+    return led_json_get_int(doc, members[JSON_COLOR_R], &rgb[0]) &&
+           led_json_get_int(doc, members[JSON_COLOR_G], &rgb[1]) &&
+           led_json_get_int(doc, members[JSON_COLOR_B], &rgb[2]);
+}
+
+/**
+ * @brief Color from the members of a color object: "hsv", "hsl", or r, g
+ * and b all 0-255
+ */
+static bool json_color_from_members(const led_json_t *doc, const int *members, led_rgb_t *color)
+{
+    if (members[JSON_COLOR_HSV] >= 0) {
+        return json_get_hsx(doc, members[JSON_COLOR_HSV], false, color);
+    }
+    if (members[JSON_COLOR_HSL] >= 0) {
+        return json_get_hsx(doc, members[JSON_COLOR_HSL], true, color);
+    }
+
+    int rgb[3];
+    if (!json_get_rgb_values(doc, members, rgb)) {
+        return false;
+    }
+    if (rgb[0] < 0 || rgb[0] > 255 || rgb[1] < 0 || rgb[1] > 255 || rgb[2] < 0 || rgb[2] > 255) {
+        return false;
+    }
+
+    color->r = (uint8_t)rgb[0];
+    color->g = (uint8_t)rgb[1];
+    color->b = (uint8_t)rgb[2];
+    return true;
+}
+
+/**
+ * @brief Read a {"r", "g", "b"} object with all channels 0-255, or a
+ * {"hsv": ..} / {"hsl": ..} object
+ */
+static bool json_get_rgb(const led_json_t *doc, int item, led_rgb_t *color)
+{
+    if (led_json_type(doc, item) != LED_JSON_OBJECT) {
+        return false;
+    }
+
+    int members[JSON_COLOR_KEYS];
+    led_json_get_members(doc, item, s_json_color_keys, JSON_COLOR_KEYS, members);
+    return json_color_from_members(doc, members, color);
+}
+
+/**
+ * @brief Queue one {"start", "count", "color"} segment for the framebuffer
+ */
+static bool json_apply_range(const led_json_t *doc, int item, const led_command_meta_t *meta)
+{
+    static const char *const keys[3] = { "start", "count", "color" };
+    int values[3];
+    int start;
+    int count;
+    led_rgb_t color;
+
+    led_json_get_members(doc, item, keys, 3, values);
+    if (!led_json_get_int(doc, values[0], &start) || !led_json_get_int(doc, values[1], &count) ||
+        !json_get_rgb(doc, values[2], &color)) {
+        ESP_LOGW(TAG, "Invalid range: needs start, count and color");
+        return false;
+    }
+
+    if (!led_command_range_valid(start, count)) {
+        ESP_LOGW(TAG, "Range %d+%d outside strip (%d LEDs)", start, count, LED_STRIP_LENGTH);
+        return false;
+    }
+
+    return queue_range((uint16_t)start, (uint16_t)count, &color, meta) == ESP_OK;
+}
+
+/**
+ * @brief Stage a flat [r, g, b, ...] array from start
+ */
+static bool json_apply_pixels(const led_json_t *doc, int array, int start)
+{
+    int values = led_json_size(doc, array);
+    if (values % 3 != 0 || !led_command_range_valid(start, values / 3)) {
+        ESP_LOGW(TAG, "Invalid pixels: %d values from LED %d", values, start);
+        return false;
+    }
+
+    // Validate first so a bad value leaves the staged pixels untouched
+    int item = led_json_first(doc, array);
+    for (int i = 0; i < values; i++, item = led_json_next(doc, item)) {
+        int value;
+        if (!led_json_get_int(doc, item, &value) || value < 0 || value > 255) {
+            ESP_LOGW(TAG, "Invalid pixel value");
+            return false;
+        }
+    }
+
+    led_staging_t *staging = &s_staging[LED_SOURCE_COMMAND];
+    uint8_t *dst = (uint8_t *)&led_staging_buffer(staging)[start];
+    item = led_json_first(doc, array);
+    for (int i = 0; i < values; i++, item = led_json_next(doc, item)) {
+        int value;
+        led_json_get_int(doc, item, &value);
+        *dst++ = (uint8_t)value;
+    }
+    led_staging_mark(staging, start, start + values / 3);
+    return true;
+}
+
+/**
+ * @brief Read a keyframe transition: "step" or an easing name
+ */
+static bool json_get_transition(const led_json_t *doc, int item, led_keyframe_t *keyframe)
+{
+    keyframe->step = false;
+    keyframe->easing = LED_EASE_LINEAR;
+    if (item < 0) {
+        return true;
+    }
+
+    char name[JSON_NAME_MAX];
+    if (!led_json_get_string(doc, item, name, sizeof(name))) {
+        return false;
+    }
+    if (strcasecmp(name, "step") == 0) {
+        keyframe->step = true;
+        return true;
+    }
+    return led_easing_from_name(name, &keyframe->easing);
+}
+
+/**
+ * @brief Read a keyframe channel or intensity value (0-255)
+ */
+static bool json_get_byte(const led_json_t *doc, int item, uint8_t *value)
+{
+    int v;
+    if (!led_json_get_int(doc, item, &v) || v < 0 || v > 255) {
+        return false;
+    }
+    *value = (uint8_t)v;
+    return true;
+}
+
+/**
+ * @brief Read a time in ms (finite, 0 to UINT32_MAX, fraction truncated)
+ */
+static bool json_get_ms(const led_json_t *doc, int item, uint32_t *ms)
+{
+    double value;
+    if (!led_json_get_number(doc, item, &value) || !isfinite(value) || value < 0 ||
+        value > (double)UINT32_MAX) {
+        return false;
+    }
+    *ms = (uint32_t)value;
+    return true;
+}
+
+/**
+ * @brief Read one keyframe
+ *
+ * Either {"t", "color", "intensity", "transition"} or the compact
+ * [t, r, g, b, intensity, transition] (intensity and transition optional).
+ */
+static bool json_get_keyframe(const led_json_t *doc, int item, led_keyframe_t *keyframe)
+{
+    int time_item;
+    int intensity_item;
+    int transition_item;
+
+    if (led_json_type(doc, item) == LED_JSON_ARRAY) {
+        int size = led_json_size(doc, item);
+        if (size < 4 || size > 6) {
+            return false;
+        }
+        int values[6] = { -1, -1, -1, -1, -1, -1 };
+        values[0] = led_json_first(doc, item);
+        for (int i = 1; i < size; i++) {
+            values[i] = led_json_next(doc, values[i - 1]);
+        }
+        if (!json_get_byte(doc, values[1], &keyframe->color.r) ||
+            !json_get_byte(doc, values[2], &keyframe->color.g) ||
+            !json_get_byte(doc, values[3], &keyframe->color.b)) {
+            return false;
+        }
+        time_item = values[0];
+        intensity_item = values[4];
+        transition_item = values[5];
+    } else if (led_json_type(doc, item) == LED_JSON_OBJECT) {
+        static const char *const keys[4] = { "t", "color", "intensity", "transition" };
+        int values[4];
+        led_json_get_members(doc, item, keys, 4, values);
+        if (!json_get_rgb(doc, values[1], &keyframe->color)) {
+            return false;
+        }
+        time_item = values[0];
+        intensity_item = values[2];
+        transition_item = values[3];
+    } else {
+        return false;
+    }
+
+    if (!json_get_ms(doc, time_item, &keyframe->time_ms)) {
+        return false;
+    }
+
+    keyframe->intensity = 255;
+    if (intensity_item >= 0 && !json_get_byte(doc, intensity_item, &keyframe->intensity)) {
+        return false;
+    }
+    return json_get_transition(doc, transition_item, keyframe);
+}
+
+/**
+ * @brief Parse a "timeline" object and hand it to the LED task
+ */
+static bool json_load_timeline(const led_json_t *doc, int item, const led_command_meta_t *meta)
+{
+    static const char *const keys[4] = { "keyframes", "loop", "duration_ms", "autoplay" };
+    int values[4];
+    led_json_get_members(doc, item, keys, 4, values);
+
+    int keyframes = values[0];
+    int count = led_json_size(doc, keyframes);
+    if (led_json_type(doc, keyframes) != LED_JSON_ARRAY || count < 1 ||
+        count > LED_TIMELINE_MAX_KEYFRAMES) {
+        ESP_LOGW(TAG, "Invalid timeline: needs 1-%d keyframes", LED_TIMELINE_MAX_KEYFRAMES);
+        return false;
+    }
+
+    // Parsed straight into the upload buffer, no copy on the stack
+    if (atomic_flag_test_and_set(&s_timeline_upload_busy)) {
+        ESP_LOGW(TAG, "Previous timeline upload still pending");
+        return false;
+    }
+
+    led_timeline_t *timeline = &s_timeline_upload;
+    timeline->count = 0;
+    int keyframe = led_json_first(doc, keyframes);
+    for (int i = 0; i < count; i++, keyframe = led_json_next(doc, keyframe)) {
+        if (!json_get_keyframe(doc, keyframe, &timeline->keyframes[timeline->count])) {
+            ESP_LOGW(TAG, "Invalid keyframe %u", timeline->count);
+            atomic_flag_clear(&s_timeline_upload_busy);
+            return false;
+        }
+        timeline->count++;
+    }
+
+    timeline->loop = led_json_is_true(doc, values[1]);
+
+    timeline->duration_ms = timeline->keyframes[timeline->count - 1].time_ms;
+    if (led_json_type(doc, values[2]) == LED_JSON_NUMBER) {
+        uint32_t duration_ms;
+        if (!json_get_ms(doc, values[2], &duration_ms)) {
+            ESP_LOGW(TAG, "Invalid timeline duration_ms (must be 0-%u)", (unsigned int)UINT32_MAX);
+            atomic_flag_clear(&s_timeline_upload_busy);
+            return false;
+        }
+        if (duration_ms > timeline->duration_ms) {
+            timeline->duration_ms = duration_ms;
+        }
+    }
+
+    bool autoplay = values[3] < 0 || led_json_is_true(doc, values[3]);
+
+    return post_timeline(autoplay, meta) == ESP_OK;
+}
+
+/**
+ * @brief Apply a tokenized command (tokens locked by the caller)
+ */
+static bool json_apply_command(const led_json_t *doc, led_command_meta_t *message)
+{
+    const led_command_meta_t *meta = message;
+    bool success = true;
+
+    // All command fields in one pass over the root object
+    int fields[JSON_FIELD_COUNT];
+    led_json_get_members(doc, 0, s_json_fields, JSON_FIELD_COUNT, fields);
+
+    // Parse "start_at" (Unix ms on the shared clock): everything below is
+    // applied at that time instead of on arrival
+    double start_at;
+    if (led_json_get_number(doc, fields[JSON_FIELD_START_AT], &start_at)) {
+        int64_t now_ms = time_sync_now_ms();
+        if (now_ms != 0 && (!isfinite(start_at) ||
+                            start_at > (double)(now_ms + SMARTLOVE_LED_START_AT_WINDOW_MS) ||
+                            start_at < (double)(now_ms - SMARTLOVE_LED_START_AT_WINDOW_MS))) {
+            ESP_LOGW(TAG, "Invalid start_at: %.0f (now %lld, window %lld ms)", start_at,
+                     (long long)now_ms, (long long)SMARTLOVE_LED_START_AT_WINDOW_MS);
+            return false;
+        }
+        if (now_ms == 0 || time_sync_to_local_us((int64_t)start_at, &message->at_us) != ESP_OK) {
+            ESP_LOGW(TAG, "Clock not synced, applying start_at message now");
+            message->at_us = 0;
+        } else if (message->at_us <= 0) {
+            // Before boot: start now, still aligned as far back as possible
+            message->at_us = 1;
+        }
+    }
+
+    // Parse "intensity" (0-255)
+    int intensity;
+    if (led_json_get_int(doc, fields[JSON_FIELD_INTENSITY], &intensity)) {
         if (intensity >= 0 && intensity <= 255) {
-            led_controller_set_intensity((uint8_t)intensity);
+            set_intensity_at((uint8_t)intensity, meta);
         } else {
             ESP_LOGW(TAG, "Invalid intensity value: %d (must be 0-255)", intensity);
             success = false;
         }
     }
 
-    // Parse "color" {r, g, b}
-    cJSON *color_item = cJSON_GetObjectItem(root, "color");
-    if (color_item != NULL && cJSON_IsObject(color_item)) {
-        cJSON *r_item = cJSON_GetObjectItem(color_item, "r");
-        cJSON *g_item = cJSON_GetObjectItem(color_item, "g");
-        cJSON *b_item = cJSON_GetObjectItem(color_item, "b");
-
-        if (cJSON_IsNumber(r_item) && cJSON_IsNumber(g_item) && cJSON_IsNumber(b_item)) {
-            int r = r_item->valueint;
-            int g = g_item->valueint;
-            int b = b_item->valueint;
+    // Parse "color" {r, g, b} or {"hsv": ..} / {"hsl": ..}; decoded once,
+    // FADE below takes its target from the same members
+    int color_members[JSON_COLOR_KEYS];
+    led_json_get_members(doc, fields[JSON_FIELD_COLOR], s_json_color_keys, JSON_COLOR_KEYS,
+                         color_members);
+    bool color_hsx = json_has_hsx(color_members);
+    led_rgb_t color;
+    bool color_valid = false;
+    int color_rgb[3];
+    bool color_rgb_given = false;
+    if (color_hsx) {
+        color_valid = json_color_from_members(doc, color_members, &color);
+        if (color_valid) {
+            set_color_at(color.r, color.g, color.b, meta);
+        } else {
+            ESP_LOGW(TAG, "Invalid HSV/HSL color (h 0-360, s/v/l 0-100)");
+            success = false;
+        }
+    } else if (json_get_rgb_values(doc, color_members, color_rgb)) {
+        color_rgb_given = true;
+        int r = color_rgb[0];
+        int g = color_rgb[1];
+        int b = color_rgb[2];
+
+        if (r >= 0 && r <= 255 && g >= 0 && g <= 255 && b >= 0 && b <= 255) {
+            set_color_at((uint8_t)r, (uint8_t)g, (uint8_t)b, meta);
+        } else {
+            ESP_LOGW(TAG, "Invalid RGB values: (%d, %d, %d)", r, g, b);
+            success = false;
+        }
+    }
 
-            if (r >= 0 && r <= 255 && g >= 0 && g <= 255 && b >= 0 && b <= 255) {
-                led_controller_set_color((uint8_t)r, (uint8_t)g, (uint8_t)b);
+    // Parse "range": one segment or an array of segments
+    bool framebuffer_changed = false;
+    int range_item = fields[JSON_FIELD_RANGE];
+    if (led_json_type(doc, range_item) == LED_JSON_OBJECT) {
+        if (json_apply_range(doc, range_item, meta)) {
+            framebuffer_changed = true;
+        } else {
+            success = false;
+        }
+    } else if (led_json_type(doc, range_item) == LED_JSON_ARRAY) {
+        int segment = led_json_first(doc, range_item);
+        for (int i = 0; i < led_json_size(doc, range_item); i++, segment = led_json_next(doc, segment)) {
+            if (json_apply_range(doc, segment, meta)) {
+                framebuffer_changed = true;
             } else {
-                ESP_LOGW(TAG, "Invalid RGB values: (%d, %d, %d)", r, g, b);
                 success = false;
             }
         }
     }
 
+    // Parse "pixels" [r, g, b, ...] starting at "start"
+    int pixels_item = fields[JSON_FIELD_PIXELS];
+    if (led_json_type(doc, pixels_item) == LED_JSON_ARRAY) {
+        int start = 0;
+        led_json_get_int(doc, fields[JSON_FIELD_START], &start);
+        if (json_apply_pixels(doc, pixels_item, start)) {
+            framebuffer_changed = true;
+        } else {
+            success = false;
+        }
+    }
+
+    if (framebuffer_changed) {
+        commit_framebuffer(LED_SOURCE_COMMAND, false, meta);
+    }
+
     // Parse "show" (animation type)
-    cJSON *show_item = cJSON_GetObjectItem(root, "show");
-    if (show_item != NULL && cJSON_IsString(show_item)) {
-        const char *show_str = show_item->valuestring;
-        if (strcasecmp(show_str, "BLINK") == 0) {
-            led_controller_set_animation(LED_ANIM_BLINK);
+    int show_item = fields[JSON_FIELD_SHOW];
+    if (led_json_type(doc, show_item) == LED_JSON_STRING) {
+        char show_str[JSON_NAME_MAX];
+        led_animation_t effect_id;
+        if (!led_json_get_string(doc, show_item, show_str, sizeof(show_str))) {
+            ESP_LOGW(TAG, "Unknown animation (name too long)");
+            success = false;
         } else if (strcasecmp(show_str, "NONE") == 0 || strcasecmp(show_str, "STATIC") == 0) {
-            led_controller_set_animation(LED_ANIM_NONE);
+            set_animation_at(LED_ANIM_NONE, meta);
         } else if (strcasecmp(show_str, "FADE") == 0) {
             // Parse fade_ms and color
             int fade_ms = 1000;
-            cJSON *fade_item = cJSON_GetObjectItem(root, "fade_ms");
-            if (fade_item && cJSON_IsNumber(fade_item)) {
-                fade_ms = fade_item->valueint;
-            }
-            uint8_t r = s_led_state.color.r;
-            uint8_t g = s_led_state.color.g;
-            uint8_t b = s_led_state.color.b;
-            cJSON *color_item = cJSON_GetObjectItem(root, "color");
-            if (color_item && cJSON_IsObject(color_item)) {
-                cJSON *r_item = cJSON_GetObjectItem(color_item, "r");
-                cJSON *g_item = cJSON_GetObjectItem(color_item, "g");
-                cJSON *b_item = cJSON_GetObjectItem(color_item, "b");
-                if (cJSON_IsNumber(r_item)) r = r_item->valueint;
-                if (cJSON_IsNumber(g_item)) g = g_item->valueint;
-                if (cJSON_IsNumber(b_item)) b = b_item->valueint;
+            led_json_get_int(doc, fields[JSON_FIELD_FADE_MS], &fade_ms);
+            if (fade_ms < 0) {
+                ESP_LOGW(TAG, "Invalid fade_ms: %d (must be >= 0)", fade_ms);
+                success = false;
+            } else {
+                // Channels left out keep the current color
+                led_snapshot_t snap;
+                read_snapshot(&snap);
+                uint8_t r = snap.state.color.r;
+                uint8_t g = snap.state.color.g;
+                uint8_t b = snap.state.color.b;
+                if (color_hsx) {
+                    // Already rejected above if invalid
+                    if (color_valid) {
+                        r = color.r;
+                        g = color.g;
+                        b = color.b;
+                    }
+                } else if (color_rgb_given) {
+                    r = (uint8_t)color_rgb[0];
+                    g = (uint8_t)color_rgb[1];
+                    b = (uint8_t)color_rgb[2];
+                } else {
+                    int value;
+                    if (led_json_get_int(doc, color_members[JSON_COLOR_R], &value)) r = (uint8_t)value;
+                    if (led_json_get_int(doc, color_members[JSON_COLOR_G], &value)) g = (uint8_t)value;
+                    if (led_json_get_int(doc, color_members[JSON_COLOR_B], &value)) b = (uint8_t)value;
+                }
+                led_easing_t easing = LED_EASE_LINEAR;
+                int easing_item = fields[JSON_FIELD_EASING];
+                if (led_json_type(doc, easing_item) == LED_JSON_STRING) {
+                    char easing_str[JSON_NAME_MAX];
+                    if (!led_json_get_string(doc, easing_item, easing_str, sizeof(easing_str))) {
+                        ESP_LOGW(TAG, "Unknown easing (name too long)");
+                        success = false;
+                    } else if (!led_easing_from_name(easing_str, &easing)) {
+                        ESP_LOGW(TAG, "Unknown easing: %s", easing_str);
+                        success = false;
+                    }
+                }
+                fade_to_at(r, g, b, (uint32_t)fade_ms, easing, meta);
             }
-            led_controller_fade_to(r, g, b, fade_ms);
+        } else if (led_effect_find(show_str, &effect_id)) {
+            set_animation_at(effect_id, meta);
         } else {
             ESP_LOGW(TAG, "Unknown animation: %s", show_str);
             success = false;
         }
     }
 
-    cJSON_Delete(root);
+    // Parse "timeline", then "seek_ms" and "player"
+    int timeline_item = fields[JSON_FIELD_TIMELINE];
+    if (led_json_type(doc, timeline_item) == LED_JSON_OBJECT &&
+        !json_load_timeline(doc, timeline_item, meta)) {
+        success = false;
+    }
+
+    if (led_json_type(doc, fields[JSON_FIELD_SEEK_MS]) == LED_JSON_NUMBER) {
+        uint32_t seek_ms;
+        if (json_get_ms(doc, fields[JSON_FIELD_SEEK_MS], &seek_ms)) {
+            timeline_command_at(LED_CMD_TIMELINE_SEEK, seek_ms, meta);
+        } else {
+            ESP_LOGW(TAG, "Invalid seek_ms (must be 0-%u)", (unsigned int)UINT32_MAX);
+            success = false;
+        }
+    }
+
+    int player_item = fields[JSON_FIELD_PLAYER];
+    if (led_json_type(doc, player_item) == LED_JSON_STRING) {
+        char action[JSON_NAME_MAX];
+        if (!led_json_get_string(doc, player_item, action, sizeof(action))) {
+            action[0] = '\0';
+        }
+        if (strcasecmp(action, "play") == 0) {
+            timeline_command_at(LED_CMD_TIMELINE_PLAY, 0, meta);
+        } else if (strcasecmp(action, "pause") == 0) {
+            timeline_command_at(LED_CMD_TIMELINE_PAUSE, 0, meta);
+        } else if (strcasecmp(action, "stop") == 0) {
+            set_animation_at(LED_ANIM_NONE, meta);
+        } else {
+            ESP_LOGW(TAG, "Unknown player action: %s", action);
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+esp_err_t led_controller_process_json(const char *json_str)
+{
+    return led_controller_process_json_ex(json_str, 0);
+}
+
+esp_err_t led_controller_process_json_ex(const char *json_str, int64_t rx_us)
+{
+    if (json_str == NULL) {
+        ESP_LOGE(TAG, "NULL JSON string");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return led_controller_process_json_len(json_str, strlen(json_str), rx_us);
+}
+
+esp_err_t led_controller_process_json_len(const char *json, size_t len, int64_t rx_us)
+{
+    if (rx_us == 0) {
+        rx_us = esp_timer_get_time();
+    }
+
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "LED controller not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (json == NULL) {
+        ESP_LOGE(TAG, "NULL JSON string");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Tokenize into the shared token pool (no heap)
+    xSemaphoreTake(s_json_lock, portMAX_DELAY);
+    led_json_t doc;
+    if (!led_json_parse(&doc, json, len, s_json_tokens, SMARTLOVE_LED_JSON_MAX_TOKENS)) {
+        xSemaphoreGive(s_json_lock);
+        ESP_LOGE(TAG, "Failed to parse JSON: %s at byte %u",
+                 doc.error != NULL ? doc.error : "error", (unsigned int)doc.error_pos);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Every command queued below carries the start time and latency trace
+    // of this message
+    led_command_meta_t message = {
+        .rx_us = rx_us,
+        .parse_us = (uint32_t)(esp_timer_get_time() - rx_us),
+    };
+    bool success = json_apply_command(&doc, &message);
+    xSemaphoreGive(s_json_lock);
 
-    ESP_LOGI(TAG, "JSON processed: intensity=%d, RGB(%d,%d,%d), anim=%d",
-             s_led_state.intensity, 
-             s_led_state.color.r, s_led_state.color.g, s_led_state.color.b,
-             s_led_state.animation);
+    ESP_LOGI(TAG, "JSON processed (%s)", success ? "ok" : "with errors");
 
     return success ? ESP_OK : ESP_ERR_INVALID_ARG;
 }
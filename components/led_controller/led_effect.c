@@ -0,0 +1,218 @@
+/**
+ * @file led_effect.c
+ * @brief LED effect registry and built-in effects
+ */
+
+#include "led_effect.h"
+#include "led_color.h"
+#include "led_fade.h"
+#include "led_timeline.h"
+#include <string.h>
+#include <strings.h>
+
+// ============================================================================
+// Effect Tuning
+// ============================================================================
+
+#define RAINBOW_PERIOD_MS       5000    // One full hue cycle
+#define CHASE_STEP_MS           50      // Time per LED step
+#define CHASE_TAIL              4       // Tail length in LEDs
+#define BREATHE_PERIOD_MS       4000    // One in/out breath
+#define TWINKLE_SPAWN_DIVISOR   32      // One new sparkle per 32 LEDs per frame
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static inline void fill(led_effect_frame_t *f, led_rgb_t color)
+{
+    for (uint16_t i = 0; i < f->count; i++) {
+        f->pixels[i] = color;
+    }
+}
+
+static inline led_rgb_t scale_color(led_rgb_t c, uint8_t level)
+{
+    led_rgb_t out = {
+        .r = (uint8_t)((c.r * (level + 1)) >> 8),
+        .g = (uint8_t)((c.g * (level + 1)) >> 8),
+        .b = (uint8_t)((c.b * (level + 1)) >> 8),
+    };
+    return out;
+}
+
+/**
+ * @brief Small xorshift PRNG (deterministic, no hardware dependency)
+ */
+static uint32_t next_random(void)
+{
+    static uint32_t state = 0x9E3779B9;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// ============================================================================
+// Built-in Effects
+// ============================================================================
+
+static bool blink_render(led_effect_frame_t *f)
+{
+    if ((f->elapsed_ms / LED_BLINK_INTERVAL_MS) % 2 == 0) {
+        memcpy(f->pixels, f->base, (size_t)f->count * sizeof(led_rgb_t));
+    } else {
+        memset(f->pixels, 0, (size_t)f->count * sizeof(led_rgb_t));
+    }
+    return true;
+}
+
+bool led_effect_fade_render(led_effect_frame_t *f)
+{
+    // Position comes from elapsed time, so a late frame catches up
+    // instead of stretching the fade
+    bool done = led_fade_sample((const led_fade_t *)f->arg, f->time_us, &f->color);
+    fill(f, f->color);
+    return !done;
+}
+
+bool led_effect_timeline_render(led_effect_frame_t *f)
+{
+    const led_timeline_player_t *player = (const led_timeline_player_t *)f->arg;
+
+    if (player->timeline.count == 0) {
+        memcpy(f->pixels, f->base, (size_t)f->count * sizeof(led_rgb_t));
+        return false;
+    }
+
+    uint32_t position_ms = led_timeline_position(&player->clock, f->time_us);
+    bool done = led_timeline_sample(&player->timeline, position_ms, &f->color);
+    fill(f, f->color);
+    return !done;
+}
+
+static bool rainbow_render(led_effect_frame_t *f)
+{
+    uint16_t offset = (uint16_t)((f->elapsed_ms % RAINBOW_PERIOD_MS) * LED_HUE_MAX / RAINBOW_PERIOD_MS);
+    // One full hue circle over the strip
+    led_hue_gradient(f->pixels, f->count, offset, ((uint32_t)LED_HUE_MAX << 8) / f->count, 255, 255);
+    return true;
+}
+
+static bool chase_render(led_effect_frame_t *f)
+{
+    uint16_t head = (uint16_t)((f->elapsed_ms / CHASE_STEP_MS) % f->count);
+
+    memset(f->pixels, 0, (size_t)f->count * sizeof(led_rgb_t));
+    for (uint16_t t = 0; t < CHASE_TAIL && t < f->count; t++) {
+        uint16_t i = (uint16_t)((head + f->count - t) % f->count);
+        f->pixels[i] = scale_color(f->color, (uint8_t)(255 >> t));
+    }
+    return true;
+}
+
+static bool breathe_render(led_effect_frame_t *f)
+{
+    // Triangle wave, squared for a softer low end
+    uint32_t phase = f->elapsed_ms % BREATHE_PERIOD_MS;
+    uint32_t half = BREATHE_PERIOD_MS / 2;
+    uint32_t tri = phase < half ? phase * 255 / half : (BREATHE_PERIOD_MS - phase) * 255 / half;
+    uint8_t level = (uint8_t)((tri * tri) / 255);
+
+    for (uint16_t i = 0; i < f->count; i++) {
+        f->pixels[i] = scale_color(f->base[i], level);
+    }
+    return true;
+}
+
+static bool twinkle_render(led_effect_frame_t *f)
+{
+    // Let every sparkle decay by 1/8 per frame
+    for (uint16_t i = 0; i < f->count; i++) {
+        led_rgb_t *p = &f->pixels[i];
+        p->r = (uint8_t)((p->r * 224) >> 8);
+        p->g = (uint8_t)((p->g * 224) >> 8);
+        p->b = (uint8_t)((p->b * 224) >> 8);
+    }
+
+    uint16_t spawn = f->count / TWINKLE_SPAWN_DIVISOR;
+    if (spawn == 0) {
+        // Short strips: one sparkle every few frames
+        spawn = (next_random() & 7) == 0 ? 1 : 0;
+    }
+    for (uint16_t n = 0; n < spawn; n++) {
+        f->pixels[next_random() % f->count] = f->color;
+    }
+    return true;
+}
+
+static const led_effect_t s_blink_effect = { .name = "blink", .render = blink_render };
+static const led_effect_t s_rainbow_effect = { .name = "rainbow", .render = rainbow_render };
+static const led_effect_t s_chase_effect = { .name = "chase", .render = chase_render };
+static const led_effect_t s_breathe_effect = { .name = "breathe", .render = breathe_render };
+static const led_effect_t s_twinkle_effect = { .name = "twinkle", .render = twinkle_render };
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+static const led_effect_t *s_effects[LED_EFFECT_MAX] = {
+    [LED_ANIM_BLINK]   = &s_blink_effect,
+    [LED_ANIM_RAINBOW] = &s_rainbow_effect,
+    [LED_ANIM_CHASE]   = &s_chase_effect,
+    [LED_ANIM_BREATHE] = &s_breathe_effect,
+    [LED_ANIM_TWINKLE] = &s_twinkle_effect,
+};
+
+_Static_assert(LED_ANIM_BUILTIN_COUNT <= LED_EFFECT_MAX, "LED_EFFECT_MAX too small");
+
+esp_err_t led_effect_register(const led_effect_t *effect, led_animation_t *id)
+{
+    if (effect == NULL || effect->name == NULL || effect->render == NULL || id == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_animation_t existing;
+    if (led_effect_find(effect->name, &existing)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (int i = LED_ANIM_BUILTIN_COUNT; i < LED_EFFECT_MAX; i++) {
+        if (s_effects[i] == NULL) {
+            s_effects[i] = effect;
+            *id = (led_animation_t)i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t led_effect_register_as(led_animation_t id, const led_effect_t *effect)
+{
+    if (id <= LED_ANIM_NONE || id >= LED_EFFECT_MAX || effect == NULL || effect->render == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_effects[id] = effect;
+    return ESP_OK;
+}
+
+const led_effect_t *led_effect_get(led_animation_t id)
+{
+    if (id <= LED_ANIM_NONE || id >= LED_EFFECT_MAX) {
+        return NULL;
+    }
+    return s_effects[id];
+}
+
+bool led_effect_find(const char *name, led_animation_t *id)
+{
+    for (int i = LED_ANIM_NONE + 1; i < LED_EFFECT_MAX; i++) {
+        if (s_effects[i] != NULL && s_effects[i]->name != NULL &&
+            strcasecmp(s_effects[i]->name, name) == 0) {
+            *id = (led_animation_t)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file led_fade.c
+ * @brief Fixed-point color fade with easing curves
+ */
+
+#include "led_fade.h"
+#include <stddef.h>
+#include <strings.h>
+
+/**
+ * @brief Exponential ease-in, (2^(10(t-1)) - 2^-10) / (1 - 2^-10), at t = k/16 (Q16)
+ */
+static const uint32_t s_expo_table[17] = {
+        0,    35,    88,   171,   298,   495,   798,  1265,
+     1986,  3097,  4812,  7455, 11532, 17820, 27517, 42472,
+    65536
+};
+
+uint32_t led_ease(led_easing_t easing, uint32_t t)
+{
+    if (t >= LED_FADE_ONE) {
+        return LED_FADE_ONE;
+    }
+
+    switch (easing) {
+        case LED_EASE_IN:
+            // t^2
+            return (uint32_t)(((uint64_t)t * t) >> 16);
+
+        case LED_EASE_OUT: {
+            // 1 - (1 - t)^2
+            uint32_t inv = LED_FADE_ONE - t;
+            return LED_FADE_ONE - (uint32_t)(((uint64_t)inv * inv) >> 16);
+        }
+
+        case LED_EASE_IN_OUT: {
+            // 2t^2 for the first half, mirrored for the second
+            if (t < LED_FADE_ONE / 2) {
+                return (uint32_t)(((uint64_t)t * t) >> 15);
+            }
+            uint32_t inv = LED_FADE_ONE - t;
+            return LED_FADE_ONE - (uint32_t)(((uint64_t)inv * inv) >> 15);
+        }
+
+        case LED_EASE_EXPO: {
+            // Piecewise linear over 16 segments
+            uint32_t seg = t >> 12;
+            uint32_t frac = t & 0x0FFF;
+            uint32_t a = s_expo_table[seg];
+            uint32_t b = s_expo_table[seg + 1];
+            return a + (((b - a) * frac) >> 12);
+        }
+
+        case LED_EASE_LINEAR:
+        default:
+            return t;
+    }
+}
+
+void led_fade_start(led_fade_t *fade, led_rgb_t from, led_rgb_t to,
+                    uint32_t duration_ms, led_easing_t easing, int64_t now_us)
+{
+    fade->from = from;
+    fade->to = to;
+    fade->start_us = now_us;
+    fade->duration_us = (uint64_t)duration_ms * 1000;
+    fade->easing = easing;
+}
+
+static inline uint8_t lerp_channel(uint8_t from, uint8_t to, uint32_t k)
+{
+    int32_t delta = (int32_t)to - (int32_t)from;
+    return (uint8_t)(from + ((delta * (int32_t)k + (int32_t)(LED_FADE_ONE / 2)) >> 16));
+}
+
+led_rgb_t led_fade_mix(led_rgb_t from, led_rgb_t to, uint32_t k)
+{
+    led_rgb_t out = {
+        .r = lerp_channel(from.r, to.r, k),
+        .g = lerp_channel(from.g, to.g, k),
+        .b = lerp_channel(from.b, to.b, k),
+    };
+    return out;
+}
+
+bool led_fade_sample(const led_fade_t *fade, int64_t now_us, led_rgb_t *out)
+{
+    int64_t elapsed_us = now_us - fade->start_us;
+
+    if (fade->duration_us == 0) {
+        *out = fade->to;
+        return true;
+    }
+    if (elapsed_us <= 0) {
+        *out = fade->from;
+        return false;
+    }
+    if ((uint64_t)elapsed_us >= fade->duration_us) {
+        *out = fade->to;
+        return true;
+    }
+
+    uint32_t t = (uint32_t)(((uint64_t)elapsed_us << 16) / fade->duration_us);
+    *out = led_fade_mix(fade->from, fade->to, led_ease(fade->easing, t));
+    return false;
+}
+
+bool led_easing_from_name(const char *name, led_easing_t *easing)
+{
+    static const struct {
+        const char *name;
+        led_easing_t easing;
+    } names[] = {
+        { "linear",      LED_EASE_LINEAR },
+        { "ease-in",     LED_EASE_IN },
+        { "ease-out",    LED_EASE_OUT },
+        { "ease-in-out", LED_EASE_IN_OUT },
+        { "exp",         LED_EASE_EXPO },
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcasecmp(name, names[i].name) == 0) {
+            *easing = names[i].easing;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,507 @@
+/**
+ * @file led_json.c
+ * @brief Allocation-free JSON tokenizer for LED commands
+ *
+ * The tokenizer is iterative: open objects and arrays are kept on a small
+ * stack of LED_JSON_MAX_DEPTH entries, so neither the heap nor the caller's
+ * stack grows with the message.
+ */
+
+#include "led_json.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+
+#define TOKEN(doc, i)   (&(doc)->tokens[(i)])
+
+typedef struct {
+    const char *json;
+    size_t len;
+    size_t pos;
+    led_json_token_t *tokens;
+    uint16_t max_tokens;
+    uint16_t count;
+    const char *error;
+} parser_t;
+
+static inline void skip_ws(parser_t *p)
+{
+    while (p->pos < p->len) {
+        char c = p->json[p->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        p->pos++;
+    }
+}
+
+static led_json_token_t *new_token(parser_t *p, led_json_type_t type, size_t start)
+{
+    if (p->count >= p->max_tokens) {
+        p->error = "too many tokens";
+        return NULL;
+    }
+    led_json_token_t *tok = &p->tokens[p->count++];
+    tok->type = (uint8_t)type;
+    tok->size = 0;
+    tok->start = (uint16_t)start;
+    tok->end = (uint16_t)start;
+    tok->next = p->count;
+    return tok;
+}
+
+static bool is_hex(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+/**
+ * @brief Tokenize a string starting at the opening quote
+ */
+static bool parse_string(parser_t *p)
+{
+    size_t start = ++p->pos;
+
+    while (p->pos < p->len) {
+        char c = p->json[p->pos];
+        if (c == '"') {
+            led_json_token_t *tok = new_token(p, LED_JSON_STRING, start);
+            if (tok == NULL) {
+                return false;
+            }
+            tok->end = (uint16_t)p->pos;
+            p->pos++;
+            return true;
+        }
+        if (c == '\\') {
+            if (p->pos + 1 >= p->len) {
+                break;
+            }
+            c = p->json[++p->pos];
+            if (c == 'u') {
+                if (p->pos + 4 >= p->len || !is_hex(p->json[p->pos + 1]) ||
+                    !is_hex(p->json[p->pos + 2]) || !is_hex(p->json[p->pos + 3]) ||
+                    !is_hex(p->json[p->pos + 4])) {
+                    p->error = "invalid escape";
+                    return false;
+                }
+                p->pos += 4;
+            } else if (strchr("\"\\/bfnrt", c) == NULL || c == '\0') {
+                p->error = "invalid escape";
+                return false;
+            }
+        }
+        p->pos++;
+    }
+
+    p->error = "unterminated string";
+    return false;
+}
+
+static size_t skip_digits(parser_t *p)
+{
+    size_t n = 0;
+    while (p->pos < p->len && p->json[p->pos] >= '0' && p->json[p->pos] <= '9') {
+        p->pos++;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Tokenize a number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static bool parse_number(parser_t *p)
+{
+    size_t start = p->pos;
+
+    if (p->json[p->pos] == '-') {
+        p->pos++;
+    }
+    if (p->pos < p->len && p->json[p->pos] == '0') {
+        p->pos++;
+    } else if (skip_digits(p) == 0) {
+        p->error = "invalid number";
+        return false;
+    }
+    if (p->pos < p->len && p->json[p->pos] == '.') {
+        p->pos++;
+        if (skip_digits(p) == 0) {
+            p->error = "invalid number";
+            return false;
+        }
+    }
+    if (p->pos < p->len && (p->json[p->pos] == 'e' || p->json[p->pos] == 'E')) {
+        p->pos++;
+        if (p->pos < p->len && (p->json[p->pos] == '+' || p->json[p->pos] == '-')) {
+            p->pos++;
+        }
+        if (skip_digits(p) == 0) {
+            p->error = "invalid number";
+            return false;
+        }
+    }
+
+    led_json_token_t *tok = new_token(p, LED_JSON_NUMBER, start);
+    if (tok == NULL) {
+        return false;
+    }
+    tok->end = (uint16_t)p->pos;
+    return true;
+}
+
+static bool parse_literal(parser_t *p, const char *text, led_json_type_t type)
+{
+    size_t n = strlen(text);
+    if (p->len - p->pos < n || memcmp(&p->json[p->pos], text, n) != 0) {
+        p->error = "invalid value";
+        return false;
+    }
+
+    led_json_token_t *tok = new_token(p, type, p->pos);
+    if (tok == NULL) {
+        return false;
+    }
+    p->pos += n;
+    tok->end = (uint16_t)p->pos;
+    return true;
+}
+
+/**
+ * @brief Tokenize an object key and the colon after it
+ */
+static bool parse_key(parser_t *p)
+{
+    skip_ws(p);
+    if (p->pos >= p->len || p->json[p->pos] != '"') {
+        p->error = "expected key";
+        return false;
+    }
+    if (!parse_string(p)) {
+        return false;
+    }
+    skip_ws(p);
+    if (p->pos >= p->len || p->json[p->pos] != ':') {
+        p->error = "expected ':'";
+        return false;
+    }
+    p->pos++;
+    return true;
+}
+
+bool led_json_parse(led_json_t *doc, const char *json, size_t len,
+                    led_json_token_t *tokens, uint16_t max_tokens)
+{
+    parser_t p = {
+        .json = json,
+        .len = len,
+        .tokens = tokens,
+        .max_tokens = max_tokens,
+    };
+    uint16_t stack[LED_JSON_MAX_DEPTH];  // Open objects and arrays
+    int depth = 0;
+
+    doc->json = json;
+    doc->tokens = tokens;
+    doc->count = 0;
+    doc->error = NULL;
+    doc->error_pos = 0;
+
+    if (json == NULL || tokens == NULL || len > LED_JSON_MAX_LEN) {
+        doc->error = "too long";
+        return false;
+    }
+
+    for (;;) {
+        // A value
+        skip_ws(&p);
+        if (p.pos >= p.len) {
+            p.error = "unexpected end";
+            goto fail;
+        }
+
+        char c = p.json[p.pos];
+        bool closed = true;
+        if (c == '{' || c == '[') {
+            if (depth == LED_JSON_MAX_DEPTH) {
+                p.error = "nested too deep";
+                goto fail;
+            }
+            if (new_token(&p, c == '{' ? LED_JSON_OBJECT : LED_JSON_ARRAY, p.pos) == NULL) {
+                goto fail;
+            }
+            stack[depth++] = (uint16_t)(p.count - 1);
+            p.pos++;
+
+            skip_ws(&p);
+            if (p.pos < p.len && p.json[p.pos] == (c == '{' ? '}' : ']')) {
+                // Empty, closed below
+                depth--;
+                led_json_token_t *tok = &p.tokens[stack[depth]];
+                p.pos++;
+                tok->end = (uint16_t)p.pos;
+            } else {
+                closed = false;
+                if (c == '{' && !parse_key(&p)) {
+                    goto fail;
+                }
+            }
+        } else if (c == '"') {
+            if (!parse_string(&p)) {
+                goto fail;
+            }
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!parse_number(&p)) {
+                goto fail;
+            }
+        } else if (c == 't') {
+            if (!parse_literal(&p, "true", LED_JSON_TRUE)) {
+                goto fail;
+            }
+        } else if (c == 'f') {
+            if (!parse_literal(&p, "false", LED_JSON_FALSE)) {
+                goto fail;
+            }
+        } else if (c == 'n') {
+            if (!parse_literal(&p, "null", LED_JSON_NULL)) {
+                goto fail;
+            }
+        } else {
+            p.error = "invalid value";
+            goto fail;
+        }
+
+        if (!closed) {
+            // First member or element of the container just opened
+            continue;
+        }
+
+        // The value is complete: continue or close the enclosing containers
+        for (;;) {
+            if (depth == 0) {
+                doc->count = p.count;
+                return true;
+            }
+
+            led_json_token_t *top = &p.tokens[stack[depth - 1]];
+            top->size++;
+
+            skip_ws(&p);
+            if (p.pos >= p.len) {
+                p.error = "unexpected end";
+                goto fail;
+            }
+            c = p.json[p.pos];
+            if (c == ',') {
+                p.pos++;
+                if (top->type == LED_JSON_OBJECT && !parse_key(&p)) {
+                    goto fail;
+                }
+                break;
+            }
+            if (c != (top->type == LED_JSON_OBJECT ? '}' : ']')) {
+                p.error = "expected ',' or end of container";
+                goto fail;
+            }
+            p.pos++;
+            top->end = (uint16_t)p.pos;
+            top->next = p.count;
+            depth--;
+        }
+    }
+
+fail:
+    doc->error = p.error;
+    doc->error_pos = p.pos;
+    return false;
+}
+
+led_json_type_t led_json_type(const led_json_t *doc, int value)
+{
+    if (value < 0 || value >= doc->count) {
+        return LED_JSON_NONE;
+    }
+    return (led_json_type_t)TOKEN(doc, value)->type;
+}
+
+int led_json_size(const led_json_t *doc, int value)
+{
+    led_json_type_t type = led_json_type(doc, value);
+    return (type == LED_JSON_OBJECT || type == LED_JSON_ARRAY) ? TOKEN(doc, value)->size : 0;
+}
+
+int led_json_first(const led_json_t *doc, int array)
+{
+    if (led_json_type(doc, array) != LED_JSON_ARRAY || TOKEN(doc, array)->size == 0) {
+        return -1;
+    }
+    return array + 1;
+}
+
+int led_json_next(const led_json_t *doc, int value)
+{
+    if (led_json_type(doc, value) == LED_JSON_NONE) {
+        return -1;
+    }
+    int next = TOKEN(doc, value)->next;
+    return next < doc->count ? next : -1;
+}
+
+void led_json_get_members(const led_json_t *doc, int object, const char *const *keys,
+                          int key_count, int *values)
+{
+    for (int i = 0; i < key_count; i++) {
+        values[i] = -1;
+    }
+    if (led_json_type(doc, object) != LED_JSON_OBJECT) {
+        return;
+    }
+
+    int key = object + 1;
+    for (int member = 0; member < TOKEN(doc, object)->size; member++) {
+        const char *name = &doc->json[TOKEN(doc, key)->start];
+        size_t name_len = TOKEN(doc, key)->end - TOKEN(doc, key)->start;
+        for (int i = 0; i < key_count; i++) {
+            if (values[i] < 0 && strncasecmp(name, keys[i], name_len) == 0 &&
+                keys[i][name_len] == '\0') {
+                values[i] = key + 1;
+                break;
+            }
+        }
+        key = TOKEN(doc, key + 1)->next;
+    }
+}
+
+int led_json_find(const led_json_t *doc, int object, const char *key)
+{
+    int value;
+    led_json_get_members(doc, object, &key, 1, &value);
+    return value;
+}
+
+bool led_json_get_number(const led_json_t *doc, int value, double *out)
+{
+    if (led_json_type(doc, value) != LED_JSON_NUMBER) {
+        return false;
+    }
+
+    // strtod needs a terminated copy; numbers of the command schema are short
+    const led_json_token_t *tok = TOKEN(doc, value);
+    char buf[40];
+    size_t n = tok->end - tok->start;
+    if (n >= sizeof(buf)) {
+        n = sizeof(buf) - 1;
+    }
+    memcpy(buf, &doc->json[tok->start], n);
+    buf[n] = '\0';
+    *out = strtod(buf, NULL);
+    return true;
+}
+
+bool led_json_get_int(const led_json_t *doc, int value, int *out)
+{
+    if (led_json_type(doc, value) != LED_JSON_NUMBER) {
+        return false;
+    }
+
+    // Plain integers (all of the command schema) without floating point
+    const led_json_token_t *tok = TOKEN(doc, value);
+    const char *s = &doc->json[tok->start];
+    size_t n = tok->end - tok->start;
+    bool negative = s[0] == '-';
+    size_t i = negative ? 1 : 0;
+    if (n - i <= 9) {
+        int result = 0;
+        for (; i < n && s[i] >= '0' && s[i] <= '9'; i++) {
+            result = result * 10 + (s[i] - '0');
+        }
+        if (i == n) {
+            *out = negative ? -result : result;
+            return true;
+        }
+    }
+
+    double d;
+    led_json_get_number(doc, value, &d);
+    if (d >= (double)INT_MAX) {
+        *out = INT_MAX;
+    } else if (d <= (double)INT_MIN) {
+        *out = INT_MIN;
+    } else {
+        *out = (int)d;
+    }
+    return true;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    return (c | 0x20) - 'a' + 10;
+}
+
+bool led_json_get_string(const led_json_t *doc, int value, char *buf, size_t size)
+{
+    if (led_json_type(doc, value) != LED_JSON_STRING || size == 0) {
+        return false;
+    }
+
+    const led_json_token_t *tok = TOKEN(doc, value);
+    const char *s = &doc->json[tok->start];
+    const char *end = &doc->json[tok->end];
+    size_t n = 0;
+
+    while (s < end) {
+        char c = *s++;
+        char utf8[3];
+        size_t utf8_len = 1;
+        utf8[0] = c;
+        if (c == '\\') {
+            c = *s++;
+            switch (c) {
+            case 'b': utf8[0] = '\b'; break;
+            case 'f': utf8[0] = '\f'; break;
+            case 'n': utf8[0] = '\n'; break;
+            case 'r': utf8[0] = '\r'; break;
+            case 't': utf8[0] = '\t'; break;
+            case 'u': {
+                // Basic plane only, which covers every name we look up
+                unsigned int cp = (unsigned int)((hex_value(s[0]) << 12) | (hex_value(s[1]) << 8) |
+                                                 (hex_value(s[2]) << 4) | hex_value(s[3]));
+                s += 4;
+                if (cp < 0x80) {
+                    utf8[0] = (char)cp;
+                } else if (cp < 0x800) {
+                    utf8[0] = (char)(0xC0 | (cp >> 6));
+                    utf8[1] = (char)(0x80 | (cp & 0x3F));
+                    utf8_len = 2;
+                } else {
+                    utf8[0] = (char)(0xE0 | (cp >> 12));
+                    utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    utf8[2] = (char)(0x80 | (cp & 0x3F));
+                    utf8_len = 3;
+                }
+                break;
+            }
+            default:
+                utf8[0] = c;  // \" \\ \/
+                break;
+            }
+        }
+        if (n + utf8_len >= size) {
+            return false;
+        }
+        memcpy(&buf[n], utf8, utf8_len);
+        n += utf8_len;
+    }
+
+    buf[n] = '\0';
+    return true;
+}
+
+bool led_json_is_true(const led_json_t *doc, int value)
+{
+    return led_json_type(doc, value) == LED_JSON_TRUE;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file led_latency.c
+ * @brief Command-to-photon latency histograms
+ */
+
+#include "led_latency.h"
+
+/**
+ * @brief Bucket of a latency: values below 4 us exactly, then 4 buckets
+ * per power of two
+ */
+static uint32_t bucket_index(uint32_t us)
+{
+    if (us < 4) {
+        return us;
+    }
+
+    uint32_t msb = 31 - (uint32_t)__builtin_clz(us);
+    uint32_t index = 4 * (msb - 1) + ((us >> (msb - 2)) & 3);
+    return index < LED_LATENCY_BUCKETS ? index : LED_LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief Largest latency that falls into a bucket
+ */
+static uint32_t bucket_upper(uint32_t index)
+{
+    if (index < 4) {
+        return index;
+    }
+
+    uint32_t shift = index / 4 - 1;
+    uint32_t lower = (4 + index % 4) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+void led_latency_record(led_latency_hist_t *hist, uint32_t us)
+{
+    hist->buckets[bucket_index(us)]++;
+    hist->samples++;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+uint32_t led_latency_percentile(const led_latency_hist_t *hist, uint32_t percent)
+{
+    if (hist->samples == 0) {
+        return 0;
+    }
+
+    // Rank of the sample, rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)hist->samples * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LED_LATENCY_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = bucket_upper(i);
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+void led_latency_summarize(const led_latency_hist_t *hist, led_latency_summary_t *out)
+{
+    out->samples = hist->samples;
+    out->p50_us = led_latency_percentile(hist, 50);
+    out->p99_us = led_latency_percentile(hist, 99);
+    out->max_us = hist->max_us;
+}
+
+const char *led_latency_stage_name(led_latency_stage_t stage)
+{
+    static const char *const names[LED_LATENCY_STAGE_COUNT] = {
+        [LED_LATENCY_PARSE] = "parse",
+        [LED_LATENCY_APPLY] = "apply",
+        [LED_LATENCY_ENCODE] = "encode",
+        [LED_LATENCY_OUTPUT] = "output",
+        [LED_LATENCY_TOTAL] = "total",
+    };
+    return stage < LED_LATENCY_STAGE_COUNT ? names[stage] : "?";
+}
@@ -0,0 +1,289 @@
+/**
+ * @file led_persist.c
+ * @brief Persisted LED state (NVS) with a debounced, coalescing writer
+ *
+ * The state is stored as one small blob in the application namespace, so
+ * a save is a single NVS entry write. The blob also carries the number of
+ * writes it has seen, which gives the flash wear over the device lifetime
+ * without a second entry.
+ */
+
+#include "led_persist.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "led_persist";
+
+#define PERSIST_TASK_STACK_SIZE 2560
+#define PERSIST_TASK_PRIORITY   1
+#define PERSIST_BLOB_VERSION    1
+
+/**
+ * @brief Stored layout (fixed size, no padding)
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t is_on;
+    uint8_t intensity;
+    uint8_t animation;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t reserved;
+    uint32_t writes;        ///< Writes including this one
+} led_persist_blob_t;
+
+_Static_assert(sizeof(led_persist_blob_t) == 12, "led_persist_blob_t must not change size");
+
+// Latest state handed over; s_dirty is set until the writer has taken it
+static led_persist_state_t s_pending;
+static bool s_pending_valid = false;
+static bool s_dirty = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Writer task only (load runs before it starts)
+static led_persist_state_t s_saved;
+static bool s_saved_valid = false;
+static led_persist_stats_t s_stats;
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_task_stop = false;
+
+#if SMARTLOVE_LED_STATIC_ALLOC
+static StaticTask_t s_task_tcb;
+static StackType_t s_task_stack[PERSIST_TASK_STACK_SIZE];
+#endif
+
+static bool state_equal(const led_persist_state_t *a, const led_persist_state_t *b)
+{
+    return a->is_on == b->is_on && a->intensity == b->intensity &&
+           a->color.r == b->color.r && a->color.g == b->color.g && a->color.b == b->color.b &&
+           a->animation == b->animation;
+}
+
+esp_err_t led_persist_load(led_persist_state_t *state)
+{
+    if (state == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(SMARTLOVE_NVS_APP_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        // The namespace does not exist before the first write
+        return err == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : err;
+    }
+
+    led_persist_blob_t blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs_handle, SMARTLOVE_NVS_KEY_LED_STATE, &blob, &len);
+    nvs_close(nvs_handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK && err != ESP_ERR_NVS_INVALID_LENGTH) {
+        return err;
+    }
+
+    s_stats.writes_total = err == ESP_OK ? blob.writes : 0;
+    if (err != ESP_OK || len != sizeof(blob) || blob.version != PERSIST_BLOB_VERSION ||
+        blob.is_on > 1 || blob.animation >= LED_ANIM_BUILTIN_COUNT ||
+        blob.animation == LED_ANIM_FADE || blob.animation == LED_ANIM_TIMELINE) {
+        ESP_LOGW(TAG, "Ignoring invalid saved LED state");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    state->is_on = blob.is_on;
+    state->intensity = blob.intensity;
+    state->color.r = blob.r;
+    state->color.g = blob.g;
+    state->color.b = blob.b;
+    state->animation = (led_animation_t)blob.animation;
+
+    // An unchanged state is not written again
+    s_saved = *state;
+    s_saved_valid = true;
+    return ESP_OK;
+}
+
+static esp_err_t write_blob(const led_persist_state_t *state, uint32_t writes)
+{
+    const led_persist_blob_t blob = {
+        .version = PERSIST_BLOB_VERSION,
+        .is_on = state->is_on,
+        .intensity = state->intensity,
+        .animation = (uint8_t)state->animation,
+        .r = state->color.r,
+        .g = state->color.g,
+        .b = state->color.b,
+        .writes = writes,
+    };
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(SMARTLOVE_NVS_APP_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, SMARTLOVE_NVS_KEY_LED_STATE, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    return err;
+}
+
+/**
+ * @brief Write the pending state if it differs from the saved one (writer task)
+ *
+ * A failed write is not retried until the state changes again.
+ */
+static void write_pending(void)
+{
+    led_persist_state_t state;
+    bool dirty;
+
+    portENTER_CRITICAL(&s_lock);
+    state = s_pending;
+    dirty = s_dirty;
+    s_dirty = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!dirty) {
+        return;
+    }
+    if (s_saved_valid && state_equal(&state, &s_saved)) {
+        // Changed and changed back within the window
+        s_stats.skipped++;
+        return;
+    }
+
+    esp_err_t err = write_blob(&state, s_stats.writes_total + 1);
+    if (err != ESP_OK) {
+        s_stats.errors++;
+        ESP_LOGW(TAG, "Failed to save LED state: %s", esp_err_to_name(err));
+        return;
+    }
+
+    s_saved = state;
+    s_saved_valid = true;
+    s_stats.writes++;
+    s_stats.writes_total++;
+    ESP_LOGD(TAG, "LED state saved (%u writes)", (unsigned int)s_stats.writes_total);
+}
+
+/**
+ * @brief Writer task: one write per window at most
+ *
+ * The first change after a write wakes the task; later changes only
+ * replace s_pending (led_persist_request() notifies while the state is
+ * clean only), so the window is not extended and its end writes the
+ * latest state. The notification during the window comes from stop.
+ */
+static void persist_task(void *pvParameters)
+{
+    const TickType_t window = pdMS_TO_TICKS(SMARTLOVE_LED_PERSIST_WINDOW_MS);
+
+    while (!s_task_stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        TickType_t deadline = xTaskGetTickCount() + window;
+        while (!s_task_stop) {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(deadline - now) <= 0) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, deadline - now);
+        }
+
+        write_pending();
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t led_persist_start(void)
+{
+    if (s_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+    s_task_stop = false;
+    TaskHandle_t handle = NULL;
+#if SMARTLOVE_LED_STATIC_ALLOC
+    handle = xTaskCreateStatic(persist_task, "led_persist", PERSIST_TASK_STACK_SIZE, NULL,
+                               PERSIST_TASK_PRIORITY, s_task_stack, &s_task_tcb);
+#else
+    xTaskCreate(persist_task, "led_persist", PERSIST_TASK_STACK_SIZE, NULL,
+                PERSIST_TASK_PRIORITY, &handle);
+#endif
+    if (handle == NULL) {
+        ESP_LOGE(TAG, "Failed to create LED persist task");
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_task_handle = handle;
+    bool dirty = s_dirty;
+    portEXIT_CRITICAL(&s_lock);
+
+    // Changes handed over before the task existed
+    if (dirty) {
+        xTaskNotifyGive(handle);
+    }
+    return ESP_OK;
+}
+
+void led_persist_stop(void)
+{
+    TaskHandle_t handle = s_task_handle;
+    if (handle == NULL) {
+        return;
+    }
+
+    // The task writes what is pending and exits
+    s_task_stop = true;
+    xTaskNotifyGive(handle);
+    for (int i = 0; s_task_handle != NULL && i < 100; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (s_task_handle != NULL) {
+        ESP_LOGW(TAG, "LED persist task did not stop");
+        return;
+    }
+#if SMARTLOVE_LED_STATIC_ALLOC
+    // Let the idle task release the static stack and TCB before a restart
+    vTaskDelay(pdMS_TO_TICKS(20));
+#endif
+}
+
+void led_persist_request(const led_persist_state_t *state)
+{
+    TaskHandle_t notify = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    if (!s_pending_valid || !state_equal(&s_pending, state)) {
+        s_pending = *state;
+        s_pending_valid = true;
+        if (!s_dirty) {
+            s_dirty = true;
+            notify = s_task_handle;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (notify != NULL) {
+        xTaskNotifyGive(notify);
+    }
+}
+
+void led_persist_get_stats(led_persist_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * @file led_staging.c
+ * @brief Lock-free single-producer ring of pixel frames
+ *
+ * published and applied count frames. Frames applied + 1 .. published
+ * wait for the LED task; frame published + 1 is the one being drawn. The
+ * producer only writes a slot the LED task is done with, the LED task only
+ * reads published slots, and each counter has a single writer.
+ *
+ * A new frame starts as a copy of the previous image with nothing drawn,
+ * so a partial write (e.g. one channel of a pixel) keeps the rest of the
+ * pixel as the producer last drew it.
+ */
+
+#include "led_staging.h"
+#include <string.h>
+
+_Static_assert(LED_STAGING_LENGTH < 0xFFFF, "Staged LEDs are indexed in 16 bits");
+
+static inline led_staging_frame_t *frame_slot(led_staging_t *staging, uint32_t frame)
+{
+    return &staging->frames[frame % LED_STAGING_FRAMES];
+}
+
+void led_staging_init(led_staging_t *staging)
+{
+    memset(staging->frames, 0, sizeof(staging->frames));
+    atomic_init(&staging->published, 0);
+    atomic_init(&staging->applied, 0);
+    staging->drawn = false;
+}
+
+led_rgb_t *led_staging_buffer(led_staging_t *staging)
+{
+    uint32_t published = (uint32_t)atomic_load_explicit(&staging->published,
+                                                        memory_order_relaxed);
+    return frame_slot(staging, published + 1)->pixels;
+}
+
+void led_staging_mark(led_staging_t *staging, uint32_t low, uint32_t high)
+{
+    uint32_t published = (uint32_t)atomic_load_explicit(&staging->published,
+                                                        memory_order_relaxed);
+    uint32_t *drawn = frame_slot(staging, published + 1)->drawn;
+
+    if (high > LED_STAGING_LENGTH) {
+        high = LED_STAGING_LENGTH;
+    }
+    for (uint32_t i = low; i < high; ) {
+        uint32_t bit = i & 31;
+        uint32_t n = high - i < 32 - bit ? high - i : 32 - bit;
+        uint32_t mask = n == 32 ? UINT32_MAX : ((1u << n) - 1) << bit;
+        drawn[i >> 5] |= mask;
+        i += n;
+    }
+    if (low < high) {
+        staging->drawn = true;
+    }
+}
+
+bool led_staging_publish(led_staging_t *staging, uint32_t *frame)
+{
+    uint32_t published = (uint32_t)atomic_load_explicit(&staging->published,
+                                                        memory_order_relaxed);
+    if (!staging->drawn) {
+        *frame = published;
+        return true;
+    }
+
+    // The next frame's slot must be applied: at most FRAMES - 1 waiting
+    uint32_t applied = (uint32_t)atomic_load_explicit(&staging->applied,
+                                                      memory_order_acquire);
+    if (published + 1 - applied >= LED_STAGING_FRAMES) {
+        return false;
+    }
+
+    led_staging_frame_t *current = frame_slot(staging, published + 1);
+    led_staging_frame_t *next = frame_slot(staging, published + 2);
+    atomic_store_explicit(&staging->published, published + 1, memory_order_release);
+    staging->drawn = false;
+
+    // The published frame is only read from here on, also by the LED task
+    memcpy(next->pixels, current->pixels, sizeof(next->pixels));
+    memset(next->drawn, 0, sizeof(next->drawn));
+
+    *frame = published + 1;
+    return true;
+}
+
+/**
+ * @brief Copy the drawn LEDs of one frame
+ */
+static void copy_drawn(const led_staging_frame_t *src, led_rgb_t *framebuffer)
+{
+    for (uint32_t w = 0; w < LED_STAGING_WORDS; w++) {
+        uint32_t bits = src->drawn[w];
+        uint32_t base = w * 32;
+        if (bits == UINT32_MAX) {
+            memcpy(&framebuffer[base], &src->pixels[base], 32 * sizeof(led_rgb_t));
+            continue;
+        }
+        while (bits != 0) {
+            uint32_t i = base + (uint32_t)__builtin_ctz(bits);
+            framebuffer[i] = src->pixels[i];
+            bits &= bits - 1;
+        }
+    }
+}
+
+uint32_t led_staging_apply(led_staging_t *staging, uint32_t frame, led_rgb_t *framebuffer)
+{
+    uint32_t applied = (uint32_t)atomic_load_explicit(&staging->applied, memory_order_relaxed);
+    uint32_t published = (uint32_t)atomic_load_explicit(&staging->published,
+                                                        memory_order_acquire);
+    uint32_t count = 0;
+
+    // Frames in order; one whose commit was dropped goes with the next
+    while ((int32_t)(frame - applied) > 0 && (int32_t)(published - applied) > 0) {
+        applied++;
+        copy_drawn(frame_slot(staging, applied), framebuffer);
+        atomic_store_explicit(&staging->applied, applied, memory_order_release);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file led_timeline.c
+ * @brief Keyframe timeline and its player
+ */
+
+#include "led_timeline.h"
+#include "led_fade.h"
+
+bool led_timeline_is_valid(const led_timeline_t *timeline)
+{
+    if (timeline->count == 0 || timeline->count > LED_TIMELINE_MAX_KEYFRAMES) {
+        return false;
+    }
+    for (uint16_t i = 1; i < timeline->count; i++) {
+        if (timeline->keyframes[i].time_ms < timeline->keyframes[i - 1].time_ms) {
+            return false;
+        }
+    }
+    return timeline->duration_ms >= timeline->keyframes[timeline->count - 1].time_ms;
+}
+
+/**
+ * @brief Index of the last keyframe at or before a position (binary search)
+ */
+static uint16_t find_keyframe(const led_timeline_t *timeline, uint32_t position_ms)
+{
+    uint16_t low = 0;
+    uint16_t high = timeline->count;
+
+    while (high - low > 1) {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+        if (timeline->keyframes[mid].time_ms <= position_ms) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static inline uint8_t scale_channel(uint8_t value, uint8_t level)
+{
+    return (uint8_t)(((uint32_t)value * level + 127) / 255);
+}
+
+bool led_timeline_sample(const led_timeline_t *timeline, uint32_t position_ms, led_rgb_t *out)
+{
+    bool finished = false;
+
+    if (timeline->loop) {
+        if (timeline->duration_ms > 0) {
+            position_ms %= timeline->duration_ms;
+        }
+    } else if (position_ms >= timeline->duration_ms) {
+        position_ms = timeline->duration_ms;
+        finished = true;
+    }
+
+    uint16_t i = find_keyframe(timeline, position_ms);
+    const led_keyframe_t *from = &timeline->keyframes[i];
+    led_rgb_t color = from->color;
+    uint8_t level = from->intensity;
+
+    if (i + 1 < timeline->count && position_ms >= from->time_ms) {
+        const led_keyframe_t *to = &timeline->keyframes[i + 1];
+        uint32_t span = to->time_ms - from->time_ms;
+        if (!to->step && span > 0) {
+            uint32_t t = (uint32_t)(((uint64_t)(position_ms - from->time_ms) << 16) / span);
+            uint32_t k = led_ease(to->easing, t);
+            color = led_fade_mix(from->color, to->color, k);
+            int32_t delta = (int32_t)to->intensity - (int32_t)from->intensity;
+            level = (uint8_t)(from->intensity + ((delta * (int32_t)k + (int32_t)(LED_FADE_ONE / 2)) >> 16));
+        }
+    }
+
+    out->r = scale_channel(color.r, level);
+    out->g = scale_channel(color.g, level);
+    out->b = scale_channel(color.b, level);
+    return finished;
+}
+
+void led_timeline_play(led_timeline_clock_t *clock, const led_timeline_t *timeline, int64_t now_us)
+{
+    clock->origin_us = now_us;
+    clock->paused_ms = 0;
+    clock->loop_ms = timeline->loop ? timeline->duration_ms : 0;
+    clock->paused = false;
+}
+
+void led_timeline_pause(led_timeline_clock_t *clock, int64_t now_us)
+{
+    if (!clock->paused) {
+        clock->paused_ms = led_timeline_position(clock, now_us);
+        clock->paused = true;
+    }
+}
+
+void led_timeline_resume(led_timeline_clock_t *clock, int64_t now_us)
+{
+    if (clock->paused) {
+        clock->origin_us = now_us - (int64_t)clock->paused_ms * 1000;
+        clock->paused = false;
+    }
+}
+
+void led_timeline_seek(led_timeline_clock_t *clock, uint32_t position_ms, int64_t now_us)
+{
+    clock->paused_ms = position_ms;
+    clock->origin_us = now_us - (int64_t)position_ms * 1000;
+}
+
+uint32_t led_timeline_position(const led_timeline_clock_t *clock, int64_t now_us)
+{
+    int64_t elapsed_ms = clock->paused ? clock->paused_ms : (now_us - clock->origin_us) / 1000;
+    if (elapsed_ms < 0) {
+        return 0;
+    }
+    if (clock->loop_ms > 0) {
+        return (uint32_t)(elapsed_ms % clock->loop_ms);
+    }
+    return elapsed_ms > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed_ms;
+}
@@ -0,0 +1,224 @@
+/**
+ * @file ws2812_capture.c
+ * @brief WS2812 capture backend for tests and benchmarks
+ */
+
+#include "ws2812_capture.h"
+#include "ws2812_encoder.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+
+static const char *TAG = "ws2812_capture";
+
+/**
+ * @brief WS2812 high time tolerance (datasheet: +/-150ns)
+ */
+#define WS2812_CAPTURE_TOLERANCE_NS 150
+
+/**
+ * @brief Capture backend state of one strip
+ */
+typedef struct {
+    ws2812_pixel_format_t format;
+    ws2812_encoder_t encoder;  // Tables for the format's timing
+    size_t symbol_count;     // Symbols per frame
+    uint32_t *symbols;       // WS2812_CAPTURE_HISTORY frames
+    uint32_t frame_count;    // Frames started
+    uint32_t pending;        // Slot prepared for the next frame
+    int64_t timestamp_us[WS2812_CAPTURE_HISTORY];
+    uint32_t duration_us[WS2812_CAPTURE_HISTORY];
+    ws2812_handle_t strip;
+} ws2812_capture_ctx_t;
+
+static int64_t ws2812_capture_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static esp_err_t ws2812_capture_attach(ws2812_handle_t strip, const ws2812_backend_config_t *config,
+                                       void **out_ctx)
+{
+    ws2812_capture_ctx_t *ctx = calloc(1, sizeof(ws2812_capture_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ctx->strip = strip;
+    ctx->format = *config->format;
+    ws2812_encoder_init_timing(&ctx->encoder, &ctx->format.timing);
+    ctx->symbol_count = (size_t)config->led_count * ctx->format.channels * WS2812_SYMBOLS_PER_BYTE;
+    ctx->symbols = calloc(ctx->symbol_count * WS2812_CAPTURE_HISTORY, sizeof(uint32_t));
+    if (ctx->symbols == NULL) {
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Capture strip: %d LEDs (channel %d)", config->led_count, config->channel);
+
+    *out_ctx = ctx;
+    return ESP_OK;
+}
+
+static void ws2812_capture_detach(void *arg)
+{
+    ws2812_capture_ctx_t *ctx = (ws2812_capture_ctx_t *)arg;
+    free(ctx->symbols);
+    free(ctx);
+}
+
+static esp_err_t ws2812_capture_prepare(void *arg, const uint8_t *frame, size_t len,
+                                        size_t dirty_start, size_t dirty_len)
+{
+    ws2812_capture_ctx_t *ctx = (ws2812_capture_ctx_t *)arg;
+
+    // Encode like the RMT backend, straight into the history slot. The slot
+    // holds an older frame, so the whole frame is encoded.
+    ctx->pending = ctx->frame_count % WS2812_CAPTURE_HISTORY;
+    ws2812_encode(&ctx->encoder, frame, len, ctx->symbols + ctx->pending * ctx->symbol_count);
+
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_capture_start(void *arg, const uint8_t *frame, size_t len)
+{
+    ws2812_capture_ctx_t *ctx = (ws2812_capture_ctx_t *)arg;
+    const uint32_t *symbols = ctx->symbols + ctx->pending * ctx->symbol_count;
+
+    // Waveform length as the hardware would send it
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < ctx->symbol_count; i++) {
+        ticks += (symbols[i] & 0x7FFF) + ((symbols[i] >> 16) & 0x7FFF);
+    }
+
+    ctx->timestamp_us[ctx->pending] = ws2812_capture_now_us();
+    ctx->duration_us[ctx->pending] = (uint32_t)(ticks * WS2812_TICK_NS / 1000) + ctx->format.timing.reset_us;
+    ctx->frame_count++;
+
+    // Nothing to wait for: the frame is complete as soon as it is recorded
+    ws2812_backend_frame_done(ctx->strip);
+
+    return ESP_OK;
+}
+
+static size_t ws2812_capture_memory_usage(void *arg)
+{
+    ws2812_capture_ctx_t *ctx = (ws2812_capture_ctx_t *)arg;
+    return sizeof(ws2812_capture_ctx_t)
+         + ctx->symbol_count * WS2812_CAPTURE_HISTORY * sizeof(uint32_t);
+}
+
+const ws2812_backend_t ws2812_capture_backend = {
+    .name = "capture",
+    .attach = ws2812_capture_attach,
+    .detach = ws2812_capture_detach,
+    .prepare = ws2812_capture_prepare,
+    .start = ws2812_capture_start,
+    .memory_usage = ws2812_capture_memory_usage,
+};
+
+uint32_t ws2812_capture_get_frame_count(ws2812_handle_t strip)
+{
+    ws2812_capture_ctx_t *ctx = ws2812_get_backend_context(strip, &ws2812_capture_backend);
+    return ctx != NULL ? ctx->frame_count : 0;
+}
+
+esp_err_t ws2812_capture_get_frame(ws2812_handle_t strip, uint32_t age, ws2812_capture_frame_t *frame)
+{
+    ws2812_capture_ctx_t *ctx = ws2812_get_backend_context(strip, &ws2812_capture_backend);
+    if (ctx == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (age >= WS2812_CAPTURE_HISTORY || age >= ctx->frame_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t sequence = ctx->frame_count - age;
+    uint32_t slot = (sequence - 1) % WS2812_CAPTURE_HISTORY;
+
+    frame->sequence = sequence;
+    frame->timestamp_us = ctx->timestamp_us[slot];
+    frame->duration_us = ctx->duration_us[slot];
+    frame->symbols = ctx->symbols + slot * ctx->symbol_count;
+    frame->symbol_count = ctx->symbol_count;
+    frame->format = &ctx->format;
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_capture_decode_timing(const uint32_t *symbols, size_t symbol_count,
+                                              uint8_t *bytes, size_t len,
+                                              const ws2812_timing_t *timing)
+{
+    if (symbols == NULL || bytes == NULL || symbol_count % WS2812_SYMBOLS_PER_BYTE != 0 ||
+        len < symbol_count / WS2812_SYMBOLS_PER_BYTE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint32_t tolerance = WS2812_CAPTURE_TOLERANCE_NS;
+    const uint32_t t0h = timing->t0h_ns;
+    const uint32_t t1h = timing->t1h_ns;
+
+    for (size_t i = 0; i < symbol_count; i += WS2812_SYMBOLS_PER_BYTE) {
+        uint8_t byte = 0;
+        for (int bit = 0; bit < WS2812_SYMBOLS_PER_BYTE; bit++) {
+            uint32_t symbol = symbols[i + bit];
+            bool level0 = (symbol >> 15) & 1;
+            bool level1 = (symbol >> 31) & 1;
+            uint32_t high_ns = (uint32_t)((symbol & 0x7FFF) * WS2812_TICK_NS);
+
+            if (!level0 || level1) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+
+            byte <<= 1;
+            if (high_ns + tolerance >= t1h && high_ns <= t1h + tolerance) {
+                byte |= 1;
+            } else if (high_ns + tolerance < t0h || high_ns > t0h + tolerance) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        }
+        bytes[i / WS2812_SYMBOLS_PER_BYTE] = byte;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_capture_decode(const uint32_t *symbols, size_t symbol_count, uint8_t *bytes, size_t len)
+{
+    const ws2812_timing_t timing = WS2812_TIMING_WS2812B;
+    return ws2812_capture_decode_timing(symbols, symbol_count, bytes, len, &timing);
+}
+
+esp_err_t ws2812_capture_get_pixel(const ws2812_capture_frame_t *frame, uint16_t index,
+                                   uint8_t *r, uint8_t *g, uint8_t *b, uint8_t *w)
+{
+    if (frame == NULL || frame->format == NULL || r == NULL || g == NULL || b == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const size_t symbols_per_led = (size_t)frame->format->channels * WS2812_SYMBOLS_PER_BYTE;
+    size_t first = (size_t)index * symbols_per_led;
+    if (first + symbols_per_led > frame->symbol_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t wire[WS2812_MAX_CHANNELS_PER_LED];
+    esp_err_t ret = ws2812_capture_decode_timing(frame->symbols + first, symbols_per_led,
+                                                 wire, sizeof(wire), &frame->format->timing);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t offsets[WS2812_MAX_CHANNELS_PER_LED];
+    ws2812_order_offsets(frame->format->order, offsets);
+    *r = wire[offsets[0]];
+    *g = wire[offsets[1]];
+    *b = wire[offsets[2]];
+    if (w != NULL) {
+        *w = offsets[3] < frame->format->channels ? wire[offsets[3]] : 0;
+    }
+    return ESP_OK;
+}
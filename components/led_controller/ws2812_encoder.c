@@ -0,0 +1,52 @@
+/**
+ * @file ws2812_encoder.c
+ * @brief Table-driven WS2812 bit encoder
+ */
+
+#include "ws2812_encoder.h"
+#include <string.h>
+
+void ws2812_encoder_init(ws2812_encoder_t *enc, uint16_t t0h, uint16_t t0l,
+                         uint16_t t1h, uint16_t t1l)
+{
+    enc->bit[0] = WS2812_SYMBOL(1, t0h, 0, t0l);
+    enc->bit[1] = WS2812_SYMBOL(1, t1h, 0, t1l);
+
+    for (int value = 0; value < 16; value++) {
+        for (int bit = 0; bit < 4; bit++) {
+            enc->nibble[value][bit] = enc->bit[(value >> (3 - bit)) & 1];
+        }
+    }
+}
+
+static inline uint16_t ns_to_ticks(uint32_t ns)
+{
+    // Rounded conversion to ticks
+    return (uint16_t)((ns + (WS2812_TICK_NS / 2)) / WS2812_TICK_NS);
+}
+
+void ws2812_encoder_init_default(ws2812_encoder_t *enc)
+{
+    ws2812_encoder_init(enc,
+                        ns_to_ticks(WS2812_T0H_NS), ns_to_ticks(WS2812_T0L_NS),
+                        ns_to_ticks(WS2812_T1H_NS), ns_to_ticks(WS2812_T1L_NS));
+}
+
+void ws2812_encoder_init_timing(ws2812_encoder_t *enc, const ws2812_timing_t *timing)
+{
+    ws2812_encoder_init(enc,
+                        ns_to_ticks(timing->t0h_ns), ns_to_ticks(timing->t0l_ns),
+                        ns_to_ticks(timing->t1h_ns), ns_to_ticks(timing->t1l_ns));
+}
+
+void ws2812_encode(const ws2812_encoder_t *enc, const uint8_t *src, size_t len,
+                   uint32_t *dst)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = src[i];
+        // Two 16-byte table copies per byte instead of 8 branches
+        memcpy(dst, enc->nibble[byte >> 4], sizeof(enc->nibble[0]));
+        memcpy(dst + 4, enc->nibble[byte & 0x0F], sizeof(enc->nibble[0]));
+        dst += WS2812_SYMBOLS_PER_BYTE;
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @file ws2812_format.c
+ * @brief Pixel formats of WS2812-style LEDs and their pixel packers
+ *
+ * The loops are written once as always-inline functions taking the channel
+ * order; each packer instantiates them with a constant order, so the
+ * compiler resolves the offsets and channel count and the GRB loops are
+ * the same code as a hand-written GRB loop.
+ */
+
+#include "ws2812_format.h"
+#include <stddef.h>
+
+#define NO_WHITE 0xFF
+
+const ws2812_pixel_format_t ws2812_format_ws2812b = {
+    .order = WS2812_ORDER_GRB,
+    .channels = 3,
+    .timing = WS2812_TIMING_WS2812B,
+};
+
+const ws2812_pixel_format_t ws2812_format_ws2812_rgb = {
+    .order = WS2812_ORDER_RGB,
+    .channels = 3,
+    .timing = WS2812_TIMING_WS2812B,
+};
+
+const ws2812_pixel_format_t ws2812_format_sk6812_rgbw = {
+    .order = WS2812_ORDER_GRBW,
+    .channels = 4,
+    .timing = WS2812_TIMING_SK6812,
+};
+
+/**
+ * @brief Byte offset of R, G, B and W per order
+ */
+static const uint8_t s_offsets[WS2812_ORDER_COUNT][WS2812_MAX_CHANNELS_PER_LED] = {
+    [WS2812_ORDER_GRB]  = { 1, 0, 2, NO_WHITE },
+    [WS2812_ORDER_RGB]  = { 0, 1, 2, NO_WHITE },
+    [WS2812_ORDER_BRG]  = { 1, 2, 0, NO_WHITE },
+    [WS2812_ORDER_GRBW] = { 1, 0, 2, 3 },
+    [WS2812_ORDER_RGBW] = { 0, 1, 2, 3 },
+};
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+ALWAYS_INLINE bool has_white(ws2812_order_t order)
+{
+    return s_offsets[order][3] != NO_WHITE;
+}
+
+/**
+ * @brief Write one LED, return true if it changed
+ */
+ALWAYS_INLINE bool put_pixel(uint8_t *p, ws2812_order_t order,
+                             uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    const uint8_t *off = s_offsets[order];
+    bool changed = p[off[0]] != r || p[off[1]] != g || p[off[2]] != b;
+    if (has_white(order)) {
+        changed = changed || p[off[3]] != w;
+    }
+    if (changed) {
+        p[off[0]] = r;
+        p[off[1]] = g;
+        p[off[2]] = b;
+        if (has_white(order)) {
+            p[off[3]] = w;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Move the common part of r, g, b to the white channel
+ */
+ALWAYS_INLINE uint8_t split_white(uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    uint8_t w = *r < *g ? *r : *g;
+    if (*b < w) {
+        w = *b;
+    }
+    *r -= w;
+    *g -= w;
+    *b -= w;
+    return w;
+}
+
+ALWAYS_INLINE bool pack_run(ws2812_order_t order, uint8_t *dst, const uint8_t *rgb,
+                            uint16_t count, const uint8_t *lut, uint16_t *first, uint16_t *last)
+{
+    const uint8_t channels = has_white(order) ? 4 : 3;
+    uint8_t *p = dst;
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+
+    for (uint16_t i = 0; i < count; i++, p += channels, rgb += 3) {
+        uint8_t r = rgb[0];
+        uint8_t g = rgb[1];
+        uint8_t b = rgb[2];
+        if (lut != NULL) {
+            r = lut[r];
+            g = lut[g];
+            b = lut[b];
+        }
+        uint8_t w = has_white(order) ? split_white(&r, &g, &b) : 0;
+        if (put_pixel(p, order, r, g, b, w)) {
+            if (lo == UINT32_MAX) {
+                lo = i;
+            }
+            hi = i;
+        }
+    }
+
+    if (lo == UINT32_MAX) {
+        return false;
+    }
+    *first = (uint16_t)lo;
+    *last = (uint16_t)hi;
+    return true;
+}
+
+ALWAYS_INLINE bool fill_run(ws2812_order_t order, uint8_t *dst, uint16_t count,
+                            uint8_t r, uint8_t g, uint8_t b, uint16_t *first, uint16_t *last)
+{
+    const uint8_t channels = has_white(order) ? 4 : 3;
+    uint8_t w = has_white(order) ? split_white(&r, &g, &b) : 0;
+    uint8_t *p = dst;
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+
+    for (uint16_t i = 0; i < count; i++, p += channels) {
+        if (put_pixel(p, order, r, g, b, w)) {
+            if (lo == UINT32_MAX) {
+                lo = i;
+            }
+            hi = i;
+        }
+    }
+
+    if (lo == UINT32_MAX) {
+        return false;
+    }
+    *first = (uint16_t)lo;
+    *last = (uint16_t)hi;
+    return true;
+}
+
+/**
+ * @brief Instantiate the packer of one order
+ */
+#define WS2812_DEFINE_PACKER(name, order, n)                                                \
+    static bool name##_pack(uint8_t *dst, const uint8_t *rgb, uint16_t count,               \
+                            const uint8_t *lut, uint16_t *first, uint16_t *last)            \
+    {                                                                                       \
+        return pack_run(order, dst, rgb, count, lut, first, last);                          \
+    }                                                                                       \
+    static bool name##_fill(uint8_t *dst, uint16_t count, uint8_t r, uint8_t g, uint8_t b,  \
+                            uint16_t *first, uint16_t *last)                                \
+    {                                                                                       \
+        return fill_run(order, dst, count, r, g, b, first, last);                           \
+    }                                                                                       \
+    static bool name##_set(uint8_t *dst, uint8_t r, uint8_t g, uint8_t b, uint8_t w)        \
+    {                                                                                       \
+        return put_pixel(dst, order, r, g, b, w);                                           \
+    }                                                                                       \
+    static const ws2812_packer_t name = {                                                   \
+        .channels = (n),                                                                    \
+        .pack = name##_pack,                                                                \
+        .fill = name##_fill,                                                                \
+        .set = name##_set,                                                                  \
+    }
+
+WS2812_DEFINE_PACKER(s_packer_grb, WS2812_ORDER_GRB, 3);
+WS2812_DEFINE_PACKER(s_packer_rgb, WS2812_ORDER_RGB, 3);
+WS2812_DEFINE_PACKER(s_packer_brg, WS2812_ORDER_BRG, 3);
+WS2812_DEFINE_PACKER(s_packer_grbw, WS2812_ORDER_GRBW, 4);
+WS2812_DEFINE_PACKER(s_packer_rgbw, WS2812_ORDER_RGBW, 4);
+
+static const ws2812_packer_t *const s_packers[WS2812_ORDER_COUNT] = {
+    [WS2812_ORDER_GRB] = &s_packer_grb,
+    [WS2812_ORDER_RGB] = &s_packer_rgb,
+    [WS2812_ORDER_BRG] = &s_packer_brg,
+    [WS2812_ORDER_GRBW] = &s_packer_grbw,
+    [WS2812_ORDER_RGBW] = &s_packer_rgbw,
+};
+
+uint8_t ws2812_order_channels(ws2812_order_t order)
+{
+    if ((unsigned)order >= WS2812_ORDER_COUNT) {
+        return 0;
+    }
+    return s_offsets[order][3] != NO_WHITE ? 4 : 3;
+}
+
+bool ws2812_format_is_valid(const ws2812_pixel_format_t *format)
+{
+    return format != NULL && ws2812_order_channels(format->order) != 0 &&
+           format->channels == ws2812_order_channels(format->order);
+}
+
+void ws2812_order_offsets(ws2812_order_t order, uint8_t offsets[WS2812_MAX_CHANNELS_PER_LED])
+{
+    for (int i = 0; i < WS2812_MAX_CHANNELS_PER_LED; i++) {
+        offsets[i] = s_offsets[order][i];
+    }
+}
+
+const ws2812_packer_t *ws2812_get_packer(ws2812_order_t order)
+{
+    if ((unsigned)order >= WS2812_ORDER_COUNT) {
+        return NULL;
+    }
+    return s_packers[order];
+}
@@ -1,103 +1,244 @@
 /**
  * @file ws2812_rmt.c
- * @brief WS2812B LED Driver using RMT peripheral (ESP-IDF 4.4.x compatible)
+ * @brief WS2812 output backend using the RMT peripheral (ESP-IDF 4.4.x compatible)
  */
 
-#include "ws2812_rmt.h"
+#include "ws2812_backend.h"
+#include "ws2812_encoder.h"
+#include "smartlove_config.h"
 #include "driver/rmt.h"
+#include "soc/soc_caps.h"
 #include "esp_log.h"
 #include "esp_err.h"
-#include "esp_rom_sys.h"   // ets_delay_us
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include <string.h>
-#include <stdlib.h>
+#include <stdbool.h>
 
-static const char *TAG = "ws2812";
+static const char *TAG = "ws2812_rmt";
 
 /**
- * WS2812 timings in nanoseconds (typical)
- * WS2812 (800kHz):
- *  - T0H ~ 350ns, T0L ~ 800ns
- *  - T1H ~ 700ns, T1L ~ 600ns
- * Reset/Latch: > 50us (we use 80us)
+ * Streaming (translator) mode:
+ * Strips with at least WS2812_STREAM_MIN_LEDS LEDs are not pre-encoded.
+ * The RMT driver calls the translator from its ISR whenever half of the
+ * channel memory has been sent, so encode memory is fixed at the channel
+ * RAM size. Two memory blocks (128 items = 16 bytes of pixel data) give
+ * the ISR enough headroom to refill before the hardware runs dry.
  */
-#define WS2812_T0H_NS   350
-#define WS2812_T0L_NS   800
-#define WS2812_T1H_NS   700
-#define WS2812_T1L_NS   600
-#define WS2812_RESET_US 80
+#define WS2812_STREAM_MIN_LEDS   SMARTLOVE_LED_RMT_STREAM_MIN_LEDS
+#define WS2812_STREAM_MEM_BLOCKS 2
 
 /**
- * RMT clocking:
- * APB clock = 80MHz
- * Choose clk_div = 2 -> RMT tick = 80MHz/2 = 40MHz -> 25ns per tick
+ * @brief Distinct bit timings in use at the same time (e.g. WS2812B and SK6812)
  */
-#define WS2812_RMT_CLK_DIV 2
-#define WS2812_TICK_NS (1000000000ULL / (80000000ULL / WS2812_RMT_CLK_DIV))
+#define WS2812_RMT_MAX_TIMINGS   2
 
-static inline uint16_t ns_to_ticks(uint32_t ns)
+/**
+ * @brief Encoder tables of one bit timing, shared by the strips using it
+ */
+typedef struct {
+    ws2812_timing_t timing;
+    ws2812_encoder_t encoder;
+    uint8_t users;
+} ws2812_rmt_encoder_slot_t;
+
+/**
+ * @brief RMT backend state of one strip
+ */
+typedef struct {
+    ws2812_handle_t strip;
+    uint8_t rmt_channel;
+    uint16_t reset_us;               // Latch time of the pixel format
+    ws2812_rmt_encoder_slot_t *slot; // Encoder tables of the pixel format's timing
+    bool streaming;                  // Encode on the fly via the RMT translator
+    rmt_item32_t *items;             // Encode buffer: one RMT item per bit, sized at init
+    size_t item_count;               // 0 in streaming mode
+    bool items_owned;                // items allocated here, not caller-provided
+    esp_timer_handle_t latch_timer;  // Ends the frame after the reset time
+} ws2812_rmt_ctx_t;
+
+/**
+ * @brief Backend state by RMT channel (one strip per channel, so it needs
+ * no allocation), and the strips in use for the shared TX end callback
+ */
+static ws2812_rmt_ctx_t s_channel_state[RMT_CHANNEL_MAX];
+static ws2812_rmt_ctx_t *s_channel_ctx[RMT_CHANNEL_MAX];
+static bool s_tx_end_registered = false;
+
+/**
+ * @brief Encoder tables, built once per bit timing
+ */
+static ws2812_rmt_encoder_slot_t s_encoders[WS2812_RMT_MAX_TIMINGS];
+
+_Static_assert(sizeof(rmt_item32_t) == sizeof(uint32_t), "RMT item must be one 32-bit symbol");
+_Static_assert(WS2812_MAX_CHANNELS <= RMT_CHANNEL_MAX, "More strips than RMT channels");
+
+/**
+ * @brief RMT translator for streaming mode (called from the RMT ISR)
+ *
+ * Encodes as many whole bytes as fit into the requested number of items.
+ */
+static void ws2812_rmt_translator(const void *src, rmt_item32_t *dest, size_t src_size,
+                                  size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    // Rounded conversion to ticks
-    return (uint16_t)((ns + (WS2812_TICK_NS / 2)) / WS2812_TICK_NS);
+    size_t bytes = wanted_num / WS2812_SYMBOLS_PER_BYTE;
+    if (bytes > src_size) {
+        bytes = src_size;
+    }
+
+    // The channel is only known through the context set at attach time
+    ws2812_rmt_ctx_t *ctx = NULL;
+    rmt_translator_get_context(item_num, (void **)&ctx);
+    ws2812_encode(&ctx->slot->encoder, (const uint8_t *)src, bytes, (uint32_t *)dest);
+
+    *translated_size = bytes;
+    *item_num = bytes * WS2812_SYMBOLS_PER_BYTE;
 }
 
 /**
- * @brief WS2812 strip structure
+ * @brief RMT TX end callback (ISR context): start the latch timer
+ *
+ * The reset time is enforced by a one-shot esp_timer instead of spinning
+ * the CPU in ets_delay_us().
  */
-struct ws2812_strip_t {
-    uint8_t gpio_num;
-    uint16_t led_count;
-    uint8_t rmt_channel;
-    uint8_t *led_buffer;  // GRB format: 3 bytes per LED
-};
+static void ws2812_rmt_tx_end(rmt_channel_t channel, void *arg)
+{
+    ws2812_rmt_ctx_t *ctx = s_channel_ctx[channel];
+    if (ctx != NULL) {
+        esp_timer_start_once(ctx->latch_timer, ctx->reset_us);
+    }
+}
+
+/**
+ * @brief Latch timer callback (esp_timer task): frame complete
+ */
+static void ws2812_rmt_latch_done(void *arg)
+{
+    ws2812_rmt_ctx_t *ctx = (ws2812_rmt_ctx_t *)arg;
+    ws2812_backend_frame_done(ctx->strip);
+}
+
+static bool timing_equal(const ws2812_timing_t *a, const ws2812_timing_t *b)
+{
+    return a->t0h_ns == b->t0h_ns && a->t0l_ns == b->t0l_ns &&
+           a->t1h_ns == b->t1h_ns && a->t1l_ns == b->t1l_ns;
+}
 
 /**
- * @brief Convert bit to RMT item
+ * @brief Get the encoder tables of a timing, building them on first use
  */
-static inline void ws2812_bit_to_rmt(uint8_t bit, rmt_item32_t *item)
+static ws2812_rmt_encoder_slot_t *ws2812_rmt_get_encoder(const ws2812_timing_t *timing)
 {
-    if (bit) {
-        // Bit 1: High for T1H, Low for T1L
-        item->level0 = 1;
-        item->duration0 = ns_to_ticks(WS2812_T1H_NS);
-        item->level1 = 0;
-        item->duration1 = ns_to_ticks(WS2812_T1L_NS);
-    } else {
-        // Bit 0: High for T0H, Low for T0L
-        item->level0 = 1;
-        item->duration0 = ns_to_ticks(WS2812_T0H_NS);
-        item->level1 = 0;
-        item->duration1 = ns_to_ticks(WS2812_T0L_NS);
+    ws2812_rmt_encoder_slot_t *free_slot = NULL;
+
+    for (int i = 0; i < WS2812_RMT_MAX_TIMINGS; i++) {
+        ws2812_rmt_encoder_slot_t *slot = &s_encoders[i];
+        if (slot->users > 0 && timing_equal(&slot->timing, timing)) {
+            slot->users++;
+            return slot;
+        }
+        if (slot->users == 0 && free_slot == NULL) {
+            free_slot = slot;
+        }
     }
+
+    if (free_slot != NULL) {
+        free_slot->timing = *timing;
+        ws2812_encoder_init_timing(&free_slot->encoder, timing);
+        free_slot->users = 1;
+    }
+    return free_slot;
+}
+
+static void ws2812_rmt_free(ws2812_rmt_ctx_t *ctx)
+{
+    if (ctx->slot != NULL) {
+        ctx->slot->users--;
+    }
+    if (ctx->latch_timer != NULL) {
+        esp_timer_delete(ctx->latch_timer);
+    }
+    if (ctx->items_owned) {
+        heap_caps_free(ctx->items);
+    }
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+static uint8_t ws2812_rmt_channel_stride(uint16_t led_count, uint8_t bytes_per_led)
+{
+    // Streaming strips occupy two RMT memory blocks, i.e. two channels
+    return (led_count >= WS2812_STREAM_MIN_LEDS) ? WS2812_STREAM_MEM_BLOCKS : 1;
 }
 
-ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel)
+static esp_err_t ws2812_rmt_attach(ws2812_handle_t strip, const ws2812_backend_config_t *config,
+                                   void **out_ctx)
 {
-    // Allocate strip structure
-    struct ws2812_strip_t *strip = malloc(sizeof(struct ws2812_strip_t));
-    if (strip == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate strip structure");
-        return NULL;
+    uint8_t rmt_channel = config->channel;
+    if (rmt_channel >= RMT_CHANNEL_MAX || s_channel_ctx[rmt_channel] != NULL) {
+        ESP_LOGE(TAG, "RMT channel %d invalid or in use", rmt_channel);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const ws2812_pixel_format_t *format = config->format;
+
+    ws2812_rmt_ctx_t *ctx = &s_channel_state[rmt_channel];
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->strip = strip;
+    ctx->rmt_channel = rmt_channel;
+    ctx->reset_us = format->timing.reset_us;
+    ctx->streaming = (config->led_count >= WS2812_STREAM_MIN_LEDS);
+
+    ctx->slot = ws2812_rmt_get_encoder(&format->timing);
+    if (ctx->slot == NULL) {
+        ESP_LOGE(TAG, "More than %d bit timings in use", WS2812_RMT_MAX_TIMINGS);
+        return ESP_ERR_NOT_SUPPORTED;
     }
 
-    strip->gpio_num = gpio_num;
-    strip->led_count = led_count;
-    strip->rmt_channel = rmt_channel;
+    if (!ctx->streaming) {
+        // The RMT encode buffer (each bit = 1 RMT item) must live in internal
+        // RAM, otherwise rmt_write_items() makes a temporary copy
+        ctx->item_count = WS2812_RMT_ENCODE_WORDS(config->led_count, format->channels);
+        if (config->encode != NULL) {
+            if (config->encode_words < ctx->item_count) {
+                ESP_LOGE(TAG, "Encode buffer too small (%u of %u words)",
+                         (unsigned int)config->encode_words, (unsigned int)ctx->item_count);
+                ws2812_rmt_free(ctx);
+                return ESP_ERR_INVALID_SIZE;
+            }
+            ctx->items = (rmt_item32_t *)config->encode;
+        } else {
+            ctx->items = heap_caps_malloc(ctx->item_count * sizeof(rmt_item32_t),
+                                          MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            ctx->items_owned = true;
+        }
+        if (ctx->items == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate RMT encode buffer (%u bytes)",
+                     (unsigned int)(ctx->item_count * sizeof(rmt_item32_t)));
+            ws2812_rmt_free(ctx);
+            return ESP_ERR_NO_MEM;
+        }
+    }
 
-    // Allocate LED buffer (GRB: 3 bytes per LED)
-    strip->led_buffer = calloc((size_t)led_count * 3, sizeof(uint8_t));
-    if (strip->led_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate LED buffer");
-        free(strip);
-        return NULL;
+    const esp_timer_create_args_t latch_timer_args = {
+        .callback = ws2812_rmt_latch_done,
+        .arg = ctx,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ws2812_latch",
+    };
+    esp_err_t ret = esp_timer_create(&latch_timer_args, &ctx->latch_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create latch timer: %s", esp_err_to_name(ret));
+        ws2812_rmt_free(ctx);
+        return ret;
     }
 
     // Configure RMT
-    rmt_config_t config = {
+    rmt_config_t rmt_cfg = {
         .rmt_mode = RMT_MODE_TX,
         .channel = (rmt_channel_t)rmt_channel,
-        .gpio_num = (gpio_num_t)gpio_num,
+        .gpio_num = (gpio_num_t)config->gpio_num,
         .clk_div = WS2812_RMT_CLK_DIV,
-        .mem_block_num = 1,
+        .mem_block_num = ctx->streaming ? WS2812_STREAM_MEM_BLOCKS : 1,
         .tx_config = {
             .carrier_en = false,
             .loop_en = false,
@@ -106,110 +247,120 @@ ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_ch
         }
     };
 
-    esp_err_t ret = rmt_config(&config);
+    ret = rmt_config(&rmt_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure RMT: %s", esp_err_to_name(ret));
-        free(strip->led_buffer);
-        free(strip);
-        return NULL;
+        ws2812_rmt_free(ctx);
+        return ret;
     }
 
     ret = rmt_driver_install((rmt_channel_t)rmt_channel, 0, 0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to install RMT driver: %s", esp_err_to_name(ret));
-        free(strip->led_buffer);
-        free(strip);
-        return NULL;
+        ws2812_rmt_free(ctx);
+        return ret;
+    }
+
+    if (ctx->streaming) {
+        ret = rmt_translator_init((rmt_channel_t)rmt_channel, ws2812_rmt_translator);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to install RMT translator: %s", esp_err_to_name(ret));
+            rmt_driver_uninstall((rmt_channel_t)rmt_channel);
+            ws2812_rmt_free(ctx);
+            return ret;
+        }
+        rmt_translator_set_context((rmt_channel_t)rmt_channel, ctx);
+    }
+
+    // One TX end callback serves all channels
+    s_channel_ctx[rmt_channel] = ctx;
+    if (!s_tx_end_registered) {
+        rmt_register_tx_end_callback(ws2812_rmt_tx_end, NULL);
+        s_tx_end_registered = true;
     }
 
     ESP_LOGI(TAG,
-             "WS2812 initialized: GPIO %d, %d LEDs, RMT channel %d, clk_div=%d, tick=%lluns",
-             gpio_num, led_count, rmt_channel, WS2812_RMT_CLK_DIV, (unsigned long long)WS2812_TICK_NS);
+             "WS2812 initialized: GPIO %d, %d LEDs x %d bytes, RMT channel %d, clk_div=%d, tick=%lluns, %s mode",
+             config->gpio_num, config->led_count, format->channels, rmt_channel, WS2812_RMT_CLK_DIV,
+             (unsigned long long)WS2812_TICK_NS, ctx->streaming ? "streaming" : "pre-encoded");
 
-    return strip;
+    *out_ctx = ctx;
+    return ESP_OK;
 }
 
-void ws2812_deinit(ws2812_handle_t strip)
+static void ws2812_rmt_detach(void *arg)
 {
-    if (strip == NULL) {
-        return;
-    }
+    ws2812_rmt_ctx_t *ctx = (ws2812_rmt_ctx_t *)arg;
 
-    rmt_driver_uninstall((rmt_channel_t)strip->rmt_channel);
-    free(strip->led_buffer);
-    free(strip);
+    s_channel_ctx[ctx->rmt_channel] = NULL;
+    rmt_driver_uninstall((rmt_channel_t)ctx->rmt_channel);
+    ws2812_rmt_free(ctx);
 }
 
-esp_err_t ws2812_set_pixel(ws2812_handle_t strip, uint16_t index, uint8_t r, uint8_t g, uint8_t b)
+static esp_err_t ws2812_rmt_prepare(void *arg, const uint8_t *frame, size_t len,
+                                    size_t dirty_start, size_t dirty_len)
 {
-    if (strip == NULL || index >= strip->led_count) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    ws2812_rmt_ctx_t *ctx = (ws2812_rmt_ctx_t *)arg;
 
-    // WS2812 uses GRB order
-    uint32_t offset = (uint32_t)index * 3;
-    strip->led_buffer[offset + 0] = g;
-    strip->led_buffer[offset + 1] = r;
-    strip->led_buffer[offset + 2] = b;
+    if (!ctx->streaming) {
+        // The encode buffer still holds the previous frame: only re-encode
+        // the bytes that changed (each bit = 1 RMT item)
+        ws2812_encode(&ctx->slot->encoder, frame + dirty_start, dirty_len,
+                      (uint32_t *)ctx->items + dirty_start * WS2812_SYMBOLS_PER_BYTE);
+    }
 
     return ESP_OK;
 }
 
-esp_err_t ws2812_refresh(ws2812_handle_t strip)
+static esp_err_t ws2812_rmt_start(void *arg, const uint8_t *frame, size_t len)
 {
-    if (strip == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    // Calculate number of bits to send
-    uint32_t total_bytes = (uint32_t)strip->led_count * 3;
-    uint32_t total_bits  = total_bytes * 8;
+    ws2812_rmt_ctx_t *ctx = (ws2812_rmt_ctx_t *)arg;
 
-    // Allocate RMT items (each bit = 1 RMT item)
-    rmt_item32_t *items = (rmt_item32_t *)malloc((size_t)total_bits * sizeof(rmt_item32_t));
-    if (items == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate RMT items");
-        return ESP_ERR_NO_MEM;
-    }
-
-    // Convert each bit to RMT item
-    uint32_t item_index = 0;
-    for (uint32_t byte_index = 0; byte_index < total_bytes; byte_index++) {
-        uint8_t byte = strip->led_buffer[byte_index];
-        for (int bit = 7; bit >= 0; bit--) {
-            ws2812_bit_to_rmt((byte >> bit) & 1, &items[item_index++]);
-        }
+    if (ctx->streaming) {
+        // Encoded by the translator while the hardware drains the channel memory
+        return rmt_write_sample((rmt_channel_t)ctx->rmt_channel, frame, len, false);
     }
 
-    // Send data via RMT
-    esp_err_t ret = rmt_write_items((rmt_channel_t)strip->rmt_channel, items, (int)total_bits, true);
-
-    free(items);
-
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to send RMT data: %s", esp_err_to_name(ret));
-        return ret;
-    }
+    return rmt_write_items((rmt_channel_t)ctx->rmt_channel, ctx->items,
+                           (int)(len * WS2812_SYMBOLS_PER_BYTE), false);
+}
 
-    // Wait for transmission to complete
-    ret = rmt_wait_tx_done((rmt_channel_t)strip->rmt_channel, pdMS_TO_TICKS(100));
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "RMT transmission timeout: %s", esp_err_to_name(ret));
-        return ret;
+static void ws2812_rmt_group_begin(void *const *ctxs, size_t count)
+{
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    // Hardware start synchronisation: the group starts once all are armed
+    for (size_t i = 0; i < count; i++) {
+        rmt_add_channel_to_group((rmt_channel_t)((ws2812_rmt_ctx_t *)ctxs[i])->rmt_channel);
     }
-
-    // Reset/Latch
-    ets_delay_us(WS2812_RESET_US);
-
-    return ESP_OK;
+#else
+    // Each channel has its own RMT memory, so once started they all send in
+    // parallel; without hardware sync the start skew is a few microseconds
+#endif
 }
 
-esp_err_t ws2812_clear(ws2812_handle_t strip)
+static void ws2812_rmt_group_end(void *const *ctxs, size_t count)
 {
-    if (strip == NULL) {
-        return ESP_ERR_INVALID_ARG;
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < count; i++) {
+        rmt_remove_channel_from_group((rmt_channel_t)((ws2812_rmt_ctx_t *)ctxs[i])->rmt_channel);
     }
+#endif
+}
 
-    memset(strip->led_buffer, 0, (size_t)strip->led_count * 3);
-    return ws2812_refresh(strip);
+static size_t ws2812_rmt_memory_usage(void *arg)
+{
+    ws2812_rmt_ctx_t *ctx = (ws2812_rmt_ctx_t *)arg;
+    return ctx->items_owned ? ctx->item_count * sizeof(rmt_item32_t) : 0;
 }
+
+const ws2812_backend_t ws2812_rmt_backend = {
+    .name = "rmt",
+    .attach = ws2812_rmt_attach,
+    .detach = ws2812_rmt_detach,
+    .prepare = ws2812_rmt_prepare,
+    .start = ws2812_rmt_start,
+    .channel_stride = ws2812_rmt_channel_stride,
+    .group_begin = ws2812_rmt_group_begin,
+    .group_end = ws2812_rmt_group_end,
+    .memory_usage = ws2812_rmt_memory_usage,
+};
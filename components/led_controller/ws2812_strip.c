@@ -0,0 +1,640 @@
+/**
+ * @file ws2812_strip.c
+ * @brief WS2812B strip core: pixel buffers, double buffering and completion
+ *
+ * Output is delegated to a backend (see ws2812_backend.h).
+ */
+
+#include "ws2812_rmt.h"
+#include "ws2812_backend.h"
+#include "ws2812_capture.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+static const char *TAG = "ws2812";
+
+/**
+ * @brief Upper bound for one frame incl. latch (1 ms per 30 LEDs, plus margin)
+ */
+#define WS2812_FRAME_TIMEOUT_MS(led_count) (100 + (led_count) / 30)
+
+/**
+ * @brief WS2812 strip structure
+ *
+ * Pixel data is double buffered: led_buffer is the draw buffer written by
+ * ws2812_set_pixel(), tx_buffer is the frame currently being sent.
+ */
+struct ws2812_strip_t {
+    uint16_t led_count;
+    uint8_t channel;
+    uint8_t bytes_per_led;       // format.channels
+    ws2812_pixel_format_t format;
+    const ws2812_packer_t *packer;  // RGB to wire order for format.order
+    uint8_t *pixels;      // Both pixel buffers in one allocation
+    uint8_t *led_buffer;  // Draw buffer in wire order, bytes_per_led per LED
+    uint8_t *tx_buffer;   // Buffer in flight, wire order
+    const ws2812_backend_t *backend;
+    void *backend_ctx;
+    SemaphoreHandle_t idle_sem;  // Given while no frame is in flight
+    StaticSemaphore_t idle_sem_buf;
+    bool static_mem;             // Strip and pixels are caller-provided
+    ws2812_done_cb_t done_cb;
+    void *done_cb_arg;
+    uint32_t dirty_start;        // Changed byte range [start, end) since the last frame
+    uint32_t dirty_end;          // start == end: nothing to send
+    uint32_t frame_start;        // Dirty range of the prepared frame, restored
+    uint32_t frame_end;          // if the frame is dropped before it starts
+    ws2812_stats_t stats;
+};
+
+_Static_assert(sizeof(struct ws2812_strip_t) <= WS2812_STRIP_STORAGE_SIZE,
+               "WS2812_STRIP_STORAGE_SIZE too small");
+
+/**
+ * @brief Extend the dirty range by [start, end)
+ */
+static inline void ws2812_mark_range(struct ws2812_strip_t *strip, uint32_t start, uint32_t end)
+{
+    if (strip->dirty_start == strip->dirty_end) {
+        strip->dirty_start = start;
+        strip->dirty_end = end;
+        return;
+    }
+    if (start < strip->dirty_start) {
+        strip->dirty_start = start;
+    }
+    if (end > strip->dirty_end) {
+        strip->dirty_end = end;
+    }
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+static const ws2812_backend_t *s_default_backend = &ws2812_capture_backend;
+#else
+static const ws2812_backend_t *s_default_backend = &ws2812_rmt_backend;
+#endif
+
+/**
+ * @brief Release all resources owned by a strip (safe on partially built strips)
+ */
+static void ws2812_free(struct ws2812_strip_t *strip)
+{
+    if (strip->backend_ctx != NULL) {
+        strip->backend->detach(strip->backend_ctx);
+    }
+    if (strip->idle_sem != NULL) {
+        vSemaphoreDelete(strip->idle_sem);
+    }
+    if (!strip->static_mem) {
+        free(strip->pixels);
+        free(strip);
+    }
+}
+
+static uint8_t ws2812_channel_stride(const ws2812_backend_t *backend, uint16_t led_count,
+                                     const ws2812_pixel_format_t *format)
+{
+    uint8_t channels = format != NULL ? format->channels : ws2812_format_ws2812b.channels;
+    return backend->channel_stride != NULL ? backend->channel_stride(led_count, channels) : 1;
+}
+
+void ws2812_backend_frame_done(ws2812_handle_t strip)
+{
+    // Callback first: until the strip is released no new frame is
+    // prepared, so the callback sees the counters of the frame just sent
+    if (strip->done_cb != NULL) {
+        strip->done_cb(strip, strip->done_cb_arg);
+    }
+
+    xSemaphoreGive(strip->idle_sem);
+}
+
+void ws2812_set_default_backend(const ws2812_backend_t *backend)
+{
+    if (backend != NULL) {
+        s_default_backend = backend;
+    }
+}
+
+/**
+ * @brief Create a strip, in mem if given, otherwise on the heap
+ */
+static ws2812_handle_t ws2812_create(const ws2812_backend_t *backend, uint8_t gpio_num,
+                                     uint16_t led_count, uint8_t channel,
+                                     const ws2812_pixel_format_t *format,
+                                     const ws2812_static_mem_t *mem)
+{
+    if (format == NULL) {
+        format = &ws2812_format_ws2812b;
+    }
+    if (backend == NULL || led_count == 0 || !ws2812_format_is_valid(format)) {
+        return NULL;
+    }
+    if (mem != NULL && (mem->strip == NULL || mem->pixels == NULL)) {
+        return NULL;
+    }
+
+    // Allocate strip structure
+    struct ws2812_strip_t *strip;
+    if (mem != NULL) {
+        strip = (struct ws2812_strip_t *)mem->strip;
+        memset(strip, 0, sizeof(*strip));
+        strip->static_mem = true;
+    } else {
+        strip = calloc(1, sizeof(struct ws2812_strip_t));
+        if (strip == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate strip structure");
+            return NULL;
+        }
+    }
+
+    strip->led_count = led_count;
+    strip->channel = channel;
+    strip->backend = backend;
+    strip->format = *format;
+    strip->bytes_per_led = format->channels;
+    strip->packer = ws2812_get_packer(format->order);
+
+    // Both pixel buffers (bytes_per_led per LED each)
+    const size_t pixel_bytes = WS2812_PIXEL_BYTES(led_count, format->channels);
+    if (mem != NULL) {
+        strip->pixels = mem->pixels;
+        memset(strip->pixels, 0, pixel_bytes);
+    } else {
+        strip->pixels = calloc(pixel_bytes, sizeof(uint8_t));
+        if (strip->pixels == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate LED buffer");
+            ws2812_free(strip);
+            return NULL;
+        }
+    }
+    strip->led_buffer = strip->pixels;
+    strip->tx_buffer = strip->pixels + (size_t)led_count * format->channels;
+
+    // The strip's actual state is unknown until the first frame is sent
+    strip->dirty_start = 0;
+    strip->dirty_end = (uint32_t)led_count * format->channels;
+
+    strip->idle_sem = xSemaphoreCreateBinaryStatic(&strip->idle_sem_buf);
+    xSemaphoreGive(strip->idle_sem);
+
+    const ws2812_backend_config_t config = {
+        .gpio_num = gpio_num,
+        .channel = channel,
+        .led_count = led_count,
+        .format = &strip->format,
+        .encode = mem != NULL ? mem->encode : NULL,
+        .encode_words = mem != NULL ? mem->encode_words : 0,
+    };
+    esp_err_t ret = backend->attach(strip, &config, &strip->backend_ctx);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to attach %s backend: %s", backend->name, esp_err_to_name(ret));
+        strip->backend_ctx = NULL;
+        ws2812_free(strip);
+        return NULL;
+    }
+
+    if (mem != NULL) {
+        ESP_LOGI(TAG, "WS2812 memory: %u bytes static, %u bytes heap, 0 bytes heap per refresh (%s backend)",
+                 (unsigned int)(sizeof(*strip) + pixel_bytes +
+                                mem->encode_words * sizeof(uint32_t)),
+                 (unsigned int)ws2812_get_memory_usage(strip), backend->name);
+    } else {
+        ESP_LOGI(TAG, "WS2812 memory: %u bytes preallocated, 0 bytes heap per refresh (%s backend)",
+                 (unsigned int)ws2812_get_memory_usage(strip), backend->name);
+    }
+
+    return strip;
+}
+
+ws2812_handle_t ws2812_init_with_backend(const ws2812_backend_t *backend, uint8_t gpio_num,
+                                         uint16_t led_count, uint8_t channel,
+                                         const ws2812_pixel_format_t *format)
+{
+    return ws2812_create(backend, gpio_num, led_count, channel, format, NULL);
+}
+
+ws2812_handle_t ws2812_init(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel,
+                            const ws2812_pixel_format_t *format)
+{
+    return ws2812_create(s_default_backend, gpio_num, led_count, rmt_channel, format, NULL);
+}
+
+ws2812_handle_t ws2812_init_static(uint8_t gpio_num, uint16_t led_count, uint8_t rmt_channel,
+                                   const ws2812_pixel_format_t *format,
+                                   const ws2812_static_mem_t *mem)
+{
+    if (mem == NULL) {
+        return NULL;
+    }
+    return ws2812_create(s_default_backend, gpio_num, led_count, rmt_channel, format, mem);
+}
+
+/**
+ * @brief Create count strips on consecutive channels (mems NULL = heap)
+ */
+static esp_err_t ws2812_create_multi(const uint8_t *gpio_nums, size_t count, uint16_t led_count,
+                                     uint8_t first_channel, const ws2812_pixel_format_t *format,
+                                     const ws2812_static_mem_t *mems, ws2812_handle_t *strips)
+{
+    if (gpio_nums == NULL || strips == NULL || count == 0 || count > WS2812_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Some backends need more than one channel per strip
+    uint8_t stride = ws2812_channel_stride(s_default_backend, led_count, format);
+    if (first_channel + count * stride > WS2812_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "%u strips of %d LEDs need %u channels from %d",
+                 (unsigned int)count, led_count, (unsigned int)(count * stride), first_channel);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        strips[i] = ws2812_create(s_default_backend, gpio_nums[i], led_count,
+                                  (uint8_t)(first_channel + i * stride), format,
+                                  mems != NULL ? &mems[i] : NULL);
+        if (strips[i] == NULL) {
+            while (i-- > 0) {
+                ws2812_deinit(strips[i]);
+                strips[i] = NULL;
+            }
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_init_multi(const uint8_t *gpio_nums, size_t count, uint16_t led_count,
+                            uint8_t first_channel, const ws2812_pixel_format_t *format,
+                            ws2812_handle_t *strips)
+{
+    return ws2812_create_multi(gpio_nums, count, led_count, first_channel, format, NULL, strips);
+}
+
+esp_err_t ws2812_init_multi_static(const uint8_t *gpio_nums, size_t count, uint16_t led_count,
+                                   uint8_t first_channel, const ws2812_pixel_format_t *format,
+                                   const ws2812_static_mem_t *mems, ws2812_handle_t *strips)
+{
+    if (mems == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ws2812_create_multi(gpio_nums, count, led_count, first_channel, format, mems, strips);
+}
+
+void ws2812_deinit(ws2812_handle_t strip)
+{
+    if (strip == NULL) {
+        return;
+    }
+
+    // Never tear down a channel in the middle of a frame
+    ws2812_wait_done(strip, WS2812_FRAME_TIMEOUT_MS(strip->led_count));
+    ws2812_free(strip);
+}
+
+size_t ws2812_get_memory_usage(ws2812_handle_t strip)
+{
+    if (strip == NULL) {
+        return 0;
+    }
+
+    size_t backend_bytes = 0;
+    if (strip->backend->memory_usage != NULL) {
+        backend_bytes = strip->backend->memory_usage(strip->backend_ctx);
+    }
+
+    if (strip->static_mem) {
+        return backend_bytes;
+    }
+    return sizeof(struct ws2812_strip_t)
+         + WS2812_PIXEL_BYTES(strip->led_count, strip->bytes_per_led)
+         + backend_bytes;
+}
+
+void *ws2812_get_backend_context(ws2812_handle_t strip, const ws2812_backend_t *backend)
+{
+    if (strip == NULL || strip->backend != backend) {
+        return NULL;
+    }
+
+    return strip->backend_ctx;
+}
+
+esp_err_t ws2812_register_done_callback(ws2812_handle_t strip, ws2812_done_cb_t callback, void *arg)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    strip->done_cb = callback;
+    strip->done_cb_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t ws2812_set_pixel(ws2812_handle_t strip, uint16_t index, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (strip == NULL || index >= strip->led_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t rgb[3] = { r, g, b };
+    uint16_t first;
+    uint16_t last;
+    uint32_t offset = (uint32_t)index * strip->bytes_per_led;
+    if (strip->packer->pack(&strip->led_buffer[offset], rgb, 1, NULL, &first, &last)) {
+        ws2812_mark_range(strip, offset, offset + strip->bytes_per_led);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_set_pixel_rgbw(ws2812_handle_t strip, uint16_t index,
+                                uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    if (strip == NULL || index >= strip->led_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t offset = (uint32_t)index * strip->bytes_per_led;
+    if (strip->packer->set(&strip->led_buffer[offset], r, g, b, w)) {
+        ws2812_mark_range(strip, offset, offset + strip->bytes_per_led);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_set_pixels(ws2812_handle_t strip, uint16_t start, const uint8_t *rgb,
+                            uint16_t count, const uint8_t *lut)
+{
+    if (strip == NULL || (rgb == NULL && count > 0) ||
+        (uint32_t)start + count > strip->led_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The packer finds the changed range while copying
+    const uint32_t bpl = strip->bytes_per_led;
+    uint16_t first;
+    uint16_t last;
+    if (strip->packer->pack(&strip->led_buffer[start * bpl], rgb, count, lut, &first, &last)) {
+        ws2812_mark_range(strip, (start + first) * bpl, (start + last + 1) * bpl);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_fill(ws2812_handle_t strip, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The packer finds the changed range while filling
+    const uint32_t bpl = strip->bytes_per_led;
+    uint16_t first;
+    uint16_t last;
+    if (strip->packer->fill(strip->led_buffer, strip->led_count, r, g, b, &first, &last)) {
+        ws2812_mark_range(strip, first * bpl, (last + 1) * bpl);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Check whether any pixel changed since the last frame
+ */
+static inline bool ws2812_is_dirty(const struct ws2812_strip_t *strip)
+{
+    return strip->dirty_start != strip->dirty_end;
+}
+
+/**
+ * @brief Claim the strip and hand the draw buffer to the backend
+ *
+ * Waits for the previous frame, swaps the pixel buffers and lets the
+ * backend prepare (encode) the frame, so that starting it is cheap.
+ */
+static esp_err_t ws2812_prepare_frame(struct ws2812_strip_t *strip)
+{
+    // Only blocks if the previous frame (incl. latch) is still going out
+    if (xSemaphoreTake(strip->idle_sem, pdMS_TO_TICKS(WS2812_FRAME_TIMEOUT_MS(strip->led_count))) != pdTRUE) {
+        ESP_LOGE(TAG, "Previous frame did not complete");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Swap buffers: the finished draw buffer goes out, drawing continues on a
+    // copy so pixels that are not touched keep their value
+    size_t total_bytes = (size_t)strip->led_count * strip->bytes_per_led;
+    uint8_t *frame = strip->led_buffer;
+    strip->led_buffer = strip->tx_buffer;
+    strip->tx_buffer = frame;
+    memcpy(strip->led_buffer, frame, total_bytes);
+
+    // The draw buffer holds the same pixels, so on failure the dirty range
+    // is simply kept and the next refresh tries again
+    esp_err_t ret = strip->backend->prepare(strip->backend_ctx, frame, total_bytes,
+                                            strip->dirty_start, strip->dirty_end - strip->dirty_start);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(strip->idle_sem);
+        return ret;
+    }
+
+    strip->frame_start = strip->dirty_start;
+    strip->frame_end = strip->dirty_end;
+    strip->dirty_start = 0;
+    strip->dirty_end = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Release a prepared frame that will not be sent
+ *
+ * Its changes are marked dirty again so the next refresh sends them.
+ */
+static void ws2812_drop_frame(struct ws2812_strip_t *strip)
+{
+    ws2812_mark_range(strip, strip->frame_start, strip->frame_end);
+    xSemaphoreGive(strip->idle_sem);
+}
+
+/**
+ * @brief Start sending a prepared frame
+ */
+static esp_err_t ws2812_start_frame(struct ws2812_strip_t *strip)
+{
+    esp_err_t ret = strip->backend->start(strip->backend_ctx, strip->tx_buffer,
+                                          (size_t)strip->led_count * strip->bytes_per_led);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send frame: %s", esp_err_to_name(ret));
+        ws2812_drop_frame(strip);
+        return ret;
+    }
+
+    strip->stats.frames_sent++;
+    return ESP_OK;
+}
+
+esp_err_t ws2812_refresh_async(ws2812_handle_t strip)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The draw buffer matches the last frame sent: nothing to do
+    if (!ws2812_is_dirty(strip)) {
+        strip->stats.frames_skipped++;
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ws2812_prepare_frame(strip);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return ws2812_start_frame(strip);
+}
+
+esp_err_t ws2812_refresh_multi_async(const ws2812_handle_t *strips, size_t count)
+{
+    if (strips == NULL || count == 0 || count > WS2812_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strips[i] == NULL || strips[i]->backend != strips[0]->backend) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // Only strips that changed are sent
+    struct ws2812_strip_t *active[WS2812_MAX_CHANNELS];
+    size_t active_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (ws2812_is_dirty(strips[i])) {
+            active[active_count++] = strips[i];
+        } else {
+            strips[i]->stats.frames_skipped++;
+        }
+    }
+    if (active_count == 0) {
+        return ESP_OK;
+    }
+
+    // Do all the encoding first so the channels start back to back
+    void *ctxs[WS2812_MAX_CHANNELS];
+    for (size_t i = 0; i < active_count; i++) {
+        esp_err_t ret = ws2812_prepare_frame(active[i]);
+        if (ret != ESP_OK) {
+            // Release the strips already claimed; their changes stay
+            // dirty and go out with the next refresh
+            while (i-- > 0) {
+                ws2812_drop_frame(active[i]);
+            }
+            return ret;
+        }
+        ctxs[i] = active[i]->backend_ctx;
+    }
+
+    const ws2812_backend_t *backend = strips[0]->backend;
+    if (backend->group_begin != NULL) {
+        backend->group_begin(ctxs, active_count);
+    }
+
+    esp_err_t result = ESP_OK;
+    for (size_t i = 0; i < active_count; i++) {
+        esp_err_t ret = ws2812_start_frame(active[i]);
+        if (ret != ESP_OK) {
+            result = ret;
+        }
+    }
+
+    if (backend->group_end != NULL) {
+        backend->group_end(ctxs, active_count);
+    }
+
+    return result;
+}
+
+esp_err_t ws2812_refresh_multi(const ws2812_handle_t *strips, size_t count)
+{
+    esp_err_t ret = ws2812_refresh_multi_async(strips, count);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        ret = ws2812_wait_done(strips[i], WS2812_FRAME_TIMEOUT_MS(strips[i]->led_count));
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Transmission timeout on channel %d", strips[i]->channel);
+            return ret;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_wait_done(ws2812_handle_t strip, uint32_t timeout_ms)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xSemaphoreTake(strip->idle_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(strip->idle_sem);
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_refresh(ws2812_handle_t strip)
+{
+    esp_err_t ret = ws2812_refresh_async(strip);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Wait for transmission and latch to complete
+    ret = ws2812_wait_done(strip, WS2812_FRAME_TIMEOUT_MS(strip->led_count));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Transmission timeout: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ws2812_clear(ws2812_handle_t strip)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws2812_fill(strip, 0, 0, 0);
+    return ws2812_refresh(strip);
+}
+
+esp_err_t ws2812_mark_dirty(ws2812_handle_t strip)
+{
+    if (strip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws2812_mark_range(strip, 0, (uint32_t)strip->led_count * strip->bytes_per_led);
+    return ESP_OK;
+}
+
+esp_err_t ws2812_get_stats(ws2812_handle_t strip, ws2812_stats_t *stats)
+{
+    if (strip == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = strip->stats;
+    return ESP_OK;
+}
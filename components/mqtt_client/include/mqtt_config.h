@@ -49,6 +49,11 @@ extern "C" {
  */
 #define MQTT_TOPIC_STATUS_SUFFIX "status"
 
+/**
+ * @brief Binary LED frames: SmartLove/<chipID>/frame
+ */
+#define MQTT_TOPIC_FRAME_SUFFIX "frame"
+
 // ============================================================================
 // Connection Settings
 // ============================================================================
@@ -75,6 +80,11 @@ extern "C" {
  */
 #define MQTT_QOS_LEVEL          1
 
+/**
+ * @brief QoS for the frame topic (a late frame is worth less than a lost one)
+ */
+#define MQTT_FRAME_QOS          0
+
 /**
  * @brief Retain flag for published messages
  * true = Message is retained by broker, false = Not retained
@@ -93,9 +103,22 @@ extern "C" {
 
 /**
  * @brief Buffer size for incoming messages
+ * 
+ * Larger messages arrive in chunks of this size.
  */
 #define MQTT_BUFFER_SIZE        1024
 
+/**
+ * @brief Largest message reassembled from chunks (bytes)
+ * 
+ * Messages on the in topic that do not fit MQTT_BUFFER_SIZE are collected
+ * in one static buffer of this size before the message callback sees
+ * them; larger ones are dropped and counted. Room for a JSON command that
+ * fills the whole LED command token pool (SMARTLOVE_LED_JSON_MAX_TOKENS).
+ * Frames are not affected: they are passed on chunk by chunk.
+ */
+#define MQTT_RX_MESSAGE_MAX_SIZE 4096
+
 /**
  * @brief Task stack size for MQTT
  */
@@ -27,9 +27,23 @@ typedef enum {
     MQTT_STATUS_ERROR              ///< Connection error
 } mqtt_status_t;
 
+/**
+ * @brief Receive counters of the message callback path
+ */
+typedef struct {
+    uint32_t messages;      ///< Messages delivered to the message callback
+    uint32_t reassembled;   ///< Of those, collected from several chunks
+    uint32_t dropped;       ///< Too large for MQTT_RX_MESSAGE_MAX_SIZE or incomplete
+} mqtt_rx_stats_t;
+
 /**
  * @brief Callback function type for incoming MQTT messages
  * 
+ * Always called with the complete payload. A message that arrived in one
+ * chunk is passed in place from the MQTT receive buffer, one that arrived
+ * in several chunks from the reassembly buffer. Either way the payload is
+ * only valid during the call and is length-delimited (not NUL-terminated).
+ * 
  * @param topic The topic the message was received on (e.g., "SmartLove/ABC123/in")
  * @param topic_len Length of the topic string
  * @param data The message payload
@@ -40,6 +54,22 @@ typedef void (*mqtt_message_callback_t)(const char *topic, int topic_len,
                                        const char *data, int data_len,
                                        void *user_data);
 
+/**
+ * @brief Callback function type for binary frames
+ *
+ * Called for every chunk of a message on SmartLove/<chipID>/frame. Messages
+ * larger than the MQTT buffer arrive in several chunks; @p offset is the
+ * position of @p data within the whole payload of @p total_len bytes.
+ *
+ * @param data Chunk data
+ * @param len Chunk length in bytes
+ * @param offset Chunk position in the payload
+ * @param total_len Total payload length
+ * @param user_data User data pointer provided during callback registration
+ */
+typedef void (*mqtt_frame_callback_t)(const uint8_t *data, int len, int offset,
+                                      int total_len, void *user_data);
+
 /**
  * @brief Callback function type for MQTT connection status changes
  * 
@@ -102,6 +132,37 @@ mqtt_status_t mqtt_client_get_status(void);
 esp_err_t mqtt_client_register_message_callback(mqtt_message_callback_t callback,
                                                void *user_data);
 
+/**
+ * @brief Register callback for binary frames
+ *
+ * The callback will be called for messages on SmartLove/<chipID>/frame,
+ * which are not passed to the message callback.
+ *
+ * @param callback Callback function pointer
+ * @param user_data Optional user data passed to callback
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mqtt_client_register_frame_callback(mqtt_frame_callback_t callback,
+                                             void *user_data);
+
+/**
+ * @brief Get the receive time of the message being delivered
+ * 
+ * Valid inside the message and frame callbacks; for messages in several
+ * chunks it is the arrival of the first chunk.
+ * 
+ * @return Time in us (esp_timer_get_time() base)
+ */
+int64_t mqtt_client_get_rx_time_us(void);
+
+/**
+ * @brief Get the receive counters of the message callback path
+ * 
+ * @param stats Output counters
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for NULL
+ */
+esp_err_t mqtt_client_get_rx_stats(mqtt_rx_stats_t *stats);
+
 /**
  * @brief Register callback for connection status changes
  * 
@@ -5,9 +5,11 @@
 
 #include "smartlove_mqtt.h"  // Our header
 #include "mqtt_config.h"
+#include "smartlove_utils.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_event.h"
+#include "esp_timer.h"
 #include "mqtt_client.h"     // ESP-IDF MQTT component
 #include "esp_mac.h"
 #include <string.h>
@@ -27,12 +29,37 @@ static char client_id[64] = {0};
 static char topic_out[128] = {0};
 static char topic_in[128] = {0};
 static char topic_status[128] = {0};
+static char topic_frame[128] = {0};
+static int topic_frame_len = 0;
+
+// Set by the first chunk of a message, later chunks carry no topic
+static bool data_is_frame = false;
+
+// Arrival of the first chunk of the message being delivered
+static int64_t data_rx_us = 0;
+
+/**
+ * Reassembly of messages larger than the MQTT buffer. The client delivers
+ * the chunks of one message back to back on its task, so a single static
+ * buffer, reused for every message, is the whole pool.
+ */
+static struct {
+    bool active;              // Chunks of a message are being collected
+    int total_len;
+    int received;
+    int topic_len;
+    char topic[128];          // Later chunks carry no topic
+} rx_assembly;
+static char rx_buffer[MQTT_RX_MESSAGE_MAX_SIZE + 1];
+static mqtt_rx_stats_t rx_stats;
 
 // Callbacks
 static mqtt_message_callback_t message_callback = NULL;
 static void *message_callback_user_data = NULL;
 static mqtt_status_callback_t status_callback = NULL;
 static void *status_callback_user_data = NULL;
+static mqtt_frame_callback_t frame_callback = NULL;
+static void *frame_callback_user_data = NULL;
 
 /**
  * @brief Get the chip ID as a hex string
@@ -68,10 +95,15 @@ static void build_topics(void)
     snprintf(topic_status, sizeof(topic_status), "%s/%s/%s",
              MQTT_TOPIC_PREFIX, chip_id, MQTT_TOPIC_STATUS_SUFFIX);
     
+    // SmartLove/<chipID>/frame
+    topic_frame_len = snprintf(topic_frame, sizeof(topic_frame), "%s/%s/%s",
+                               MQTT_TOPIC_PREFIX, chip_id, MQTT_TOPIC_FRAME_SUFFIX);
+    
     ESP_LOGI(TAG, "Chip ID: %s", chip_id);
     ESP_LOGI(TAG, "Client ID: %s", client_id);
     ESP_LOGI(TAG, "Topic OUT: %s", topic_out);
     ESP_LOGI(TAG, "Topic IN: %s", topic_in);
+    ESP_LOGI(TAG, "Topic FRAME: %s", topic_frame);
 }
 
 /**
@@ -89,6 +121,71 @@ static void update_status(mqtt_status_t new_status)
     }
 }
 
+/**
+ * @brief Hand a complete message to the message callback
+ */
+static void deliver_message(const char *topic, int topic_len, const char *data, int data_len)
+{
+    rx_stats.messages++;
+    if (message_callback != NULL) {
+        message_callback(topic, topic_len, data, data_len, message_callback_user_data);
+    }
+}
+
+/**
+ * @brief Collect one chunk of a multi-chunk message, deliver it when complete
+ */
+static void reassemble_chunk(esp_mqtt_event_handle_t event)
+{
+    if (event->current_data_offset == 0) {
+        if (rx_assembly.active) {
+            rx_stats.dropped++;
+            ESP_LOGW(TAG, "Incomplete message dropped (%d of %d bytes)",
+                     rx_assembly.received, rx_assembly.total_len);
+        }
+        rx_assembly.active = false;
+
+        if (event->total_data_len > MQTT_RX_MESSAGE_MAX_SIZE ||
+            event->topic_len >= (int)sizeof(rx_assembly.topic)) {
+            rx_stats.dropped++;
+            ESP_LOGW(TAG, "Message of %d bytes dropped (limit %d)",
+                     event->total_data_len, MQTT_RX_MESSAGE_MAX_SIZE);
+            return;
+        }
+
+        memcpy(rx_assembly.topic, event->topic, event->topic_len);
+        rx_assembly.topic_len = event->topic_len;
+        rx_assembly.total_len = event->total_data_len;
+        rx_assembly.received = 0;
+        rx_assembly.active = true;
+    }
+
+    if (!rx_assembly.active) {
+        // Rest of a dropped message
+        return;
+    }
+
+    if (event->current_data_offset != rx_assembly.received ||
+        event->data_len > rx_assembly.total_len - rx_assembly.received) {
+        rx_assembly.active = false;
+        rx_stats.dropped++;
+        ESP_LOGW(TAG, "Unexpected chunk at %d (expected %d), message dropped",
+                 event->current_data_offset, rx_assembly.received);
+        return;
+    }
+
+    memcpy(&rx_buffer[rx_assembly.received], event->data, event->data_len);
+    rx_assembly.received += event->data_len;
+
+    if (rx_assembly.received == rx_assembly.total_len) {
+        rx_assembly.active = false;
+        rx_buffer[rx_assembly.total_len] = '\0';
+        rx_stats.reassembled++;
+        deliver_message(rx_assembly.topic, rx_assembly.topic_len,
+                        rx_buffer, rx_assembly.total_len);
+    }
+}
+
 /**
  * @brief MQTT event handler (IDF 4.x style)
  */
@@ -103,13 +200,20 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
             int msg_id = esp_mqtt_client_subscribe(mqtt_client, topic_in, MQTT_QOS_LEVEL);
             ESP_LOGI(TAG, "Subscribed to %s, msg_id=%d", topic_in, msg_id);
             
+            msg_id = esp_mqtt_client_subscribe(mqtt_client, topic_frame, MQTT_FRAME_QOS);
+            ESP_LOGI(TAG, "Subscribed to %s, msg_id=%d", topic_frame, msg_id);
+            
             // Publish online status
             if (MQTT_LWT_ENABLED) {
                 esp_mqtt_client_publish(mqtt_client, topic_status, "online",
                                       0, MQTT_LWT_QOS, MQTT_LWT_RETAIN);
             }
             
-            // Send startup message with system information
+            // Send startup message with system information and boot times
+            smartlove_boot_mark(SMARTLOVE_BOOT_MQTT_CONNECTED);
+            char boot_json[160];
+            smartlove_boot_format_json(boot_json, sizeof(boot_json));
+            
             char startup_msg[512];
             esp_chip_info_t chip_info;
             esp_chip_info(&chip_info);
@@ -124,7 +228,8 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
                      "\"idf_version\":\"%s\","
                      "\"chip_id\":\"%s\","
                      "\"free_heap\":%d,"
-                     "\"min_free_heap\":%d"
+                     "\"min_free_heap\":%d,"
+                     "\"boot_ms\":%s"
                      "}",
                      chip_info.cores,
                      chip_info.revision,
@@ -133,7 +238,8 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
                      esp_get_idf_version(),
                      chip_id,
                      esp_get_free_heap_size(),
-                     esp_get_minimum_free_heap_size());
+                     esp_get_minimum_free_heap_size(),
+                     boot_json);
             
             esp_mqtt_client_publish(mqtt_client, topic_out, startup_msg,
                                   0, MQTT_QOS_LEVEL, 0);
@@ -158,15 +264,32 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
             break;
             
         case MQTT_EVENT_DATA:
-            ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-            ESP_LOGD(TAG, "Topic: %.*s", event->topic_len, event->topic);
-            ESP_LOGD(TAG, "Data: %.*s", event->data_len, event->data);
+            if (event->current_data_offset == 0) {
+                data_rx_us = esp_timer_get_time();
+                data_is_frame = event->topic_len == topic_frame_len &&
+                                memcmp(event->topic, topic_frame, topic_frame_len) == 0;
+            }
+            
+            // Frames go straight to the frame callback, without logging
+            if (data_is_frame) {
+                if (frame_callback != NULL) {
+                    frame_callback((const uint8_t *)event->data, event->data_len,
+                                   event->current_data_offset, event->total_data_len,
+                                   frame_callback_user_data);
+                }
+                break;
+            }
+            
+            ESP_LOGI(TAG, "MQTT_EVENT_DATA (%d of %d bytes at %d)", event->data_len,
+                     event->total_data_len, event->current_data_offset);
             
-            // Call message callback
-            if (message_callback != NULL) {
-                message_callback(event->topic, event->topic_len,
-                               event->data, event->data_len,
-                               message_callback_user_data);
+            if (event->current_data_offset == 0 && event->data_len == event->total_data_len) {
+                // Complete in one chunk: passed in place, without a copy
+                ESP_LOGD(TAG, "Topic: %.*s", event->topic_len, event->topic);
+                ESP_LOGD(TAG, "Data: %.*s", event->data_len, event->data);
+                deliver_message(event->topic, event->topic_len, event->data, event->data_len);
+            } else {
+                reassemble_chunk(event);
             }
             break;
             
@@ -325,6 +448,20 @@ esp_err_t mqtt_client_register_message_callback(mqtt_message_callback_t callback
     return ESP_OK;
 }
 
+int64_t mqtt_client_get_rx_time_us(void)
+{
+    return data_rx_us;
+}
+
+esp_err_t mqtt_client_get_rx_stats(mqtt_rx_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = rx_stats;
+    return ESP_OK;
+}
+
 esp_err_t mqtt_client_register_status_callback(mqtt_status_callback_t callback,
                                               void *user_data)
 {
@@ -334,6 +471,15 @@ esp_err_t mqtt_client_register_status_callback(mqtt_status_callback_t callback,
     return ESP_OK;
 }
 
+esp_err_t mqtt_client_register_frame_callback(mqtt_frame_callback_t callback,
+                                             void *user_data)
+{
+    frame_callback = callback;
+    frame_callback_user_data = user_data;
+    ESP_LOGI(TAG, "Frame callback registered");
+    return ESP_OK;
+}
+
 esp_err_t mqtt_client_send(const char *message)
 {
     if (message == NULL) {
@@ -456,6 +602,9 @@ esp_err_t mqtt_client_deinit(void)
     message_callback_user_data = NULL;
     status_callback = NULL;
     status_callback_user_data = NULL;
+    frame_callback = NULL;
+    frame_callback_user_data = NULL;
+    rx_assembly.active = false;
     
     current_status = MQTT_STATUS_DISCONNECTED;
     
@@ -0,0 +1,144 @@
+/**
+ * @file realtime_protocol.h
+ * @brief DDP and E1.31 (sACN) packet parsing
+ * 
+ * Pure packet parsing and sequence tracking without sockets or RTOS
+ * dependencies, so it can be checked on the host.
+ */
+
+#ifndef REALTIME_PROTOCOL_H
+#define REALTIME_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// DDP (Distributed Display Protocol)
+// ============================================================================
+
+#define DDP_HEADER_LEN          10      ///< Header without timecode
+#define DDP_TIMECODE_LEN        4       ///< Extra header bytes with DDP_FLAG_TIMECODE
+
+#define DDP_FLAG_VER_MASK       0xC0
+#define DDP_FLAG_VER1           0x40
+#define DDP_FLAG_TIMECODE       0x10
+#define DDP_FLAG_STORAGE        0x08
+#define DDP_FLAG_REPLY          0x04
+#define DDP_FLAG_QUERY          0x02
+#define DDP_FLAG_PUSH           0x01    ///< Last packet of a frame: display it
+
+#define DDP_SEQUENCE_MASK       0x0F    ///< 1-15, 0 = not used by the sender
+
+#define DDP_TYPE_UNDEFINED      0x00
+#define DDP_TYPE_RGB24          0x0B    ///< RGB, 8 bits per channel
+
+#define DDP_ID_DISPLAY          1
+#define DDP_ID_ALL              255
+
+/**
+ * @brief Parsed DDP data packet
+ */
+typedef struct {
+    uint8_t flags;          ///< DDP_FLAG_*
+    uint8_t sequence;       ///< 1-15, 0 = not used
+    uint32_t offset;        ///< Byte offset of data in the display buffer
+    uint16_t length;        ///< Data length in bytes
+    const uint8_t *data;    ///< Pixel data (points into the packet)
+} ddp_packet_t;
+
+/**
+ * @brief Parse a DDP data packet for the display
+ * 
+ * @param buf Packet
+ * @param len Packet length
+ * @param pkt Parsed packet
+ * @return ESP_OK for RGB data addressed to the display,
+ *         ESP_ERR_NOT_SUPPORTED for valid packets without pixel data
+ *         (queries, replies, storage, other outputs or data types),
+ *         ESP_ERR_INVALID_SIZE / ESP_ERR_INVALID_VERSION for malformed packets
+ */
+esp_err_t ddp_parse(const uint8_t *buf, size_t len, ddp_packet_t *pkt);
+
+// ============================================================================
+// E1.31 (Streaming ACN)
+// ============================================================================
+
+#define E131_DATA_OFFSET        126     ///< First DMX channel in the packet
+#define E131_MAX_CHANNELS       512
+
+#define E131_OPT_PREVIEW        0x80    ///< Preview data, not for live output
+#define E131_OPT_TERMINATED     0x40    ///< Source stops sending
+
+/**
+ * @brief Parsed E1.31 data packet
+ */
+typedef struct {
+    uint16_t universe;      ///< Universe (1-63999)
+    uint8_t sequence;       ///< Per-universe sequence number
+    uint8_t priority;       ///< Source priority (0-200)
+    uint8_t options;        ///< E131_OPT_*
+    uint16_t channel_count; ///< DMX channels in data
+    const uint8_t *data;    ///< DMX channel 1 onwards (points into the packet)
+} e131_packet_t;
+
+/**
+ * @brief Parse an E1.31 data packet with DMX start code 0
+ * 
+ * @param buf Packet
+ * @param len Packet length
+ * @param pkt Parsed packet
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for other start codes or
+ *         packet types, ESP_ERR_INVALID_SIZE / ESP_ERR_INVALID_RESPONSE for
+ *         malformed packets
+ */
+esp_err_t e131_parse(const uint8_t *buf, size_t len, e131_packet_t *pkt);
+
+// ============================================================================
+// Sequence Tracking
+// ============================================================================
+
+/**
+ * @brief Sequence number state of one stream
+ */
+typedef struct {
+    uint8_t last;           ///< Last accepted sequence number
+    bool valid;             ///< last is set
+    uint8_t rejected;       ///< Packets rejected since the last accepted one
+} realtime_seq_t;
+
+/**
+ * @brief Check a DDP sequence number (1-15, wraps to 1)
+ * 
+ * Up to 7 ahead of the last packet is new (the gap is lost), a repeat or
+ * 8-14 ahead is a late packet. The third rejected packet in a row is
+ * accepted again, so the stream recovers from a burst loss of 8 or more.
+ * 
+ * @param seq Stream state, updated for accepted packets
+ * @param sequence Sequence number of the packet
+ * @return Packets lost before this one, -1 for a late or repeated packet
+ */
+int realtime_seq_ddp(realtime_seq_t *seq, uint8_t sequence);
+
+/**
+ * @brief Check an E1.31 sequence number (0-255)
+ * 
+ * Follows E1.31 section 6.7.2: a packet up to 20 behind the last one is
+ * out of order and must be ignored.
+ * 
+ * @param seq Stream state, updated for accepted packets
+ * @param sequence Sequence number of the packet
+ * @return Packets lost before this one, -1 for a late packet
+ */
+int realtime_seq_e131(realtime_seq_t *seq, uint8_t sequence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REALTIME_PROTOCOL_H
@@ -0,0 +1,74 @@
+/**
+ * @file realtime_receiver.h
+ * @brief DDP / E1.31 (sACN) UDP receiver for LED frames
+ * 
+ * Receives pixel data on the LAN and writes it straight into the
+ * led_controller framebuffer, bypassing the MQTT broker.
+ * 
+ * - DDP (port SMARTLOVE_DDP_PORT): data offset = framebuffer byte, frame
+ *   is shown on packets with the PUSH flag
+ * - E1.31 (port SMARTLOVE_E131_PORT): universe SMARTLOVE_E131_UNIVERSE_START
+ *   + n starts at byte n * SMARTLOVE_E131_CHANNELS_PER_UNIVERSE, frame is
+ *   shown when the universe holding the last LED arrives
+ */
+
+#ifndef REALTIME_RECEIVER_H
+#define REALTIME_RECEIVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Receiver statistics (both protocols)
+ */
+typedef struct {
+    uint32_t packets_received;      ///< Valid data packets
+    uint32_t packets_invalid;       ///< Malformed or unsupported packets
+    uint32_t packets_lost;          ///< Gaps in the sequence numbers
+    uint32_t packets_out_of_order;  ///< Late or repeated packets (ignored)
+    uint32_t frames_received;       ///< Complete frames
+    uint32_t frames_displayed;      ///< Frames sent to the LEDs
+    uint32_t latency_last_us;       ///< First packet of a frame to LED output
+    uint32_t latency_avg_us;        ///< Moving average of the latency
+    uint32_t latency_max_us;        ///< Maximum latency since start
+} realtime_receiver_stats_t;
+
+/**
+ * @brief Start the receiver (call once the network is up)
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t realtime_receiver_start(void);
+
+/**
+ * @brief Stop the receiver
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t realtime_receiver_stop(void);
+
+/**
+ * @brief Check if the receiver is running
+ * 
+ * @return true if running
+ */
+bool realtime_receiver_is_running(void);
+
+/**
+ * @brief Get receiver statistics
+ * 
+ * @param stats Pointer to statistics structure to fill
+ * @return ESP_OK on success
+ */
+esp_err_t realtime_receiver_get_stats(realtime_receiver_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REALTIME_RECEIVER_H
@@ -0,0 +1,174 @@
+/**
+ * @file realtime_protocol.c
+ * @brief DDP and E1.31 (sACN) packet parsing
+ */
+
+#include "realtime_protocol.h"
+#include <string.h>
+
+// E1.31 layout (ANSI E1.31-2018, section 4)
+#define E131_PREAMBLE_SIZE      0x0010
+#define E131_VECTOR_ROOT_DATA   0x00000004
+#define E131_VECTOR_FRAME_DATA  0x00000002
+#define E131_VECTOR_DMP_SET     0x02
+#define E131_DMP_ADDRESS_TYPE   0xA1
+
+// DDP numbers only 1..15: a forward gap of up to 7 is loss, anything else is
+// a late or repeated packet. After a burst loss of 8 or more every packet
+// looks late, so a few rejects in a row restart the count.
+#define DDP_SEQ_MAX_GAP         7
+#define DDP_SEQ_RESYNC          3
+
+static const uint8_t s_acn_packet_id[12] = {
+    'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0x00, 0x00, 0x00
+};
+
+static inline uint16_t read_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// ============================================================================
+// DDP
+// ============================================================================
+
+esp_err_t ddp_parse(const uint8_t *buf, size_t len, ddp_packet_t *pkt)
+{
+    if (len < DDP_HEADER_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t flags = buf[0];
+    if ((flags & DDP_FLAG_VER_MASK) != DDP_FLAG_VER1) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    size_t header_len = DDP_HEADER_LEN;
+    if (flags & DDP_FLAG_TIMECODE) {
+        header_len += DDP_TIMECODE_LEN;
+    }
+
+    uint16_t length = read_be16(&buf[8]);
+    if (len < header_len + length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pkt->flags = flags;
+    pkt->sequence = buf[1] & DDP_SEQUENCE_MASK;
+    pkt->offset = read_be32(&buf[4]);
+    pkt->length = length;
+    pkt->data = &buf[header_len];
+
+    // Only pixel data written to the display is of interest
+    if (flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY | DDP_FLAG_STORAGE)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (buf[3] != DDP_ID_DISPLAY && buf[3] != DDP_ID_ALL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (buf[2] != DDP_TYPE_UNDEFINED && buf[2] != DDP_TYPE_RGB24) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
+// ============================================================================
+// E1.31
+// ============================================================================
+
+esp_err_t e131_parse(const uint8_t *buf, size_t len, e131_packet_t *pkt)
+{
+    if (len < E131_DATA_OFFSET) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Root layer
+    if (read_be16(&buf[0]) != E131_PREAMBLE_SIZE || read_be16(&buf[2]) != 0 ||
+        memcmp(&buf[4], s_acn_packet_id, sizeof(s_acn_packet_id)) != 0) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (read_be32(&buf[18]) != E131_VECTOR_ROOT_DATA) {
+        // Synchronization / discovery packets
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Framing layer
+    if (read_be32(&buf[40]) != E131_VECTOR_FRAME_DATA) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // DMP layer
+    if (buf[117] != E131_VECTOR_DMP_SET || buf[118] != E131_DMP_ADDRESS_TYPE ||
+        read_be16(&buf[119]) != 0 || read_be16(&buf[121]) != 1) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // Property values: start code + channels
+    uint16_t count = read_be16(&buf[123]);
+    if (count < 1 || count > E131_MAX_CHANNELS + 1 || len < E131_DATA_OFFSET - 1 + (size_t)count) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (buf[125] != 0) {
+        // Not DMX level data (e.g. per-channel priority)
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    pkt->priority = buf[108];
+    pkt->sequence = buf[111];
+    pkt->options = buf[112];
+    pkt->universe = read_be16(&buf[113]);
+    pkt->channel_count = count - 1;
+    pkt->data = &buf[E131_DATA_OFFSET];
+
+    return ESP_OK;
+}
+
+// ============================================================================
+// Sequence Tracking
+// ============================================================================
+
+int realtime_seq_ddp(realtime_seq_t *seq, uint8_t sequence)
+{
+    // 0 = sender does not number its packets
+    if (sequence == 0) {
+        return 0;
+    }
+
+    int lost = 0;
+    if (seq->valid) {
+        // Distance on the 1..15 cycle: 0 is the same packet again, more
+        // than half the cycle ahead is a packet that arrived late
+        int gap = (sequence - seq->last + 15) % 15;
+        if ((gap == 0 || gap > DDP_SEQ_MAX_GAP) && ++seq->rejected < DDP_SEQ_RESYNC) {
+            return -1;
+        }
+        lost = gap > 0 && gap <= DDP_SEQ_MAX_GAP ? gap - 1 : 0;
+    }
+
+    seq->last = sequence;
+    seq->valid = true;
+    seq->rejected = 0;
+    return lost;
+}
+
+int realtime_seq_e131(realtime_seq_t *seq, uint8_t sequence)
+{
+    int lost = 0;
+    if (seq->valid) {
+        int8_t diff = (int8_t)(sequence - seq->last);
+        if (diff <= 0 && diff > -20) {
+            return -1;
+        }
+        lost = diff > 0 ? diff - 1 : 0;
+    }
+
+    seq->last = sequence;
+    seq->valid = true;
+    return lost;
+}
@@ -0,0 +1,350 @@
+/**
+ * @file realtime_receiver.c
+ * @brief DDP / E1.31 (sACN) UDP receiver for LED frames
+ */
+
+#include "realtime_receiver.h"
+#include "realtime_protocol.h"
+#include "led_controller.h"
+#include "smartlove_config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "realtime_rx";
+
+#define RT_FRAMEBUFFER_BYTES    (LED_STRIP_LENGTH * 3)
+#define RT_MAX_PACKET_SIZE      1472    // Ethernet MTU minus IP/UDP headers
+#define RT_SELECT_TIMEOUT_MS    100     // Stop flag poll interval
+
+/**
+ * @brief Universes needed to cover the strip
+ */
+#define RT_E131_UNIVERSE_COUNT \
+    ((RT_FRAMEBUFFER_BYTES + SMARTLOVE_E131_CHANNELS_PER_UNIVERSE - 1) / SMARTLOVE_E131_CHANNELS_PER_UNIVERSE)
+#define RT_E131_UNIVERSE_LAST   (SMARTLOVE_E131_UNIVERSE_START + RT_E131_UNIVERSE_COUNT - 1)
+
+static int s_ddp_socket = -1;
+static int s_e131_socket = -1;
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+
+// Packet buffer (static, the task stack stays small)
+static uint8_t s_rx_buffer[RT_MAX_PACKET_SIZE];
+
+static realtime_seq_t s_ddp_seq;
+static realtime_seq_t s_e131_seq[RT_E131_UNIVERSE_COUNT];
+static int64_t s_frame_start_us = 0;   // Receive time of the first packet, 0 = none
+static realtime_receiver_stats_t s_stats;
+
+// ============================================================================
+// Private Functions
+// ============================================================================
+
+/**
+ * @brief Remember when the first packet of a frame arrived
+ */
+static void begin_packet(int64_t rx_us)
+{
+    if (s_frame_start_us == 0) {
+        s_frame_start_us = rx_us;
+    }
+}
+
+/**
+ * @brief Count a lost/late packet; false if the packet must be ignored
+ */
+static bool check_sequence(int lost)
+{
+    if (lost < 0) {
+        s_stats.packets_out_of_order++;
+        return false;
+    }
+    s_stats.packets_lost += lost;
+    return true;
+}
+
+/**
+ * @brief Copy packet data to the framebuffer, clipped to the strip
+ */
+static void write_pixels(uint32_t offset, const uint8_t *data, size_t len)
+{
+    if (offset >= RT_FRAMEBUFFER_BYTES) {
+        return;
+    }
+    if (len > RT_FRAMEBUFFER_BYTES - offset) {
+        len = RT_FRAMEBUFFER_BYTES - offset;
+    }
+    led_controller_write_framebuffer(offset, data, len);
+}
+
+/**
+ * @brief Show the received frame and record its latency
+ */
+static void show_frame(void)
+{
+    s_stats.frames_received++;
+    if (led_controller_show_frame() == ESP_OK) {
+        s_stats.frames_displayed++;
+    }
+
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - s_frame_start_us);
+    s_stats.latency_last_us = latency_us;
+    if (latency_us > s_stats.latency_max_us) {
+        s_stats.latency_max_us = latency_us;
+    }
+    // Exponential moving average, weight 1/8
+    if (s_stats.latency_avg_us == 0) {
+        s_stats.latency_avg_us = latency_us;
+    } else {
+        s_stats.latency_avg_us += ((int32_t)latency_us - (int32_t)s_stats.latency_avg_us) / 8;
+    }
+
+    s_frame_start_us = 0;
+}
+
+static void handle_ddp(const uint8_t *buf, size_t len, int64_t rx_us)
+{
+    ddp_packet_t pkt;
+    if (ddp_parse(buf, len, &pkt) != ESP_OK) {
+        s_stats.packets_invalid++;
+        return;
+    }
+    if (!check_sequence(realtime_seq_ddp(&s_ddp_seq, pkt.sequence))) {
+        return;
+    }
+
+    s_stats.packets_received++;
+    begin_packet(rx_us);
+    write_pixels(pkt.offset, pkt.data, pkt.length);
+
+    if (pkt.flags & DDP_FLAG_PUSH) {
+        show_frame();
+    }
+}
+
+static void handle_e131(const uint8_t *buf, size_t len, int64_t rx_us)
+{
+    e131_packet_t pkt;
+    if (e131_parse(buf, len, &pkt) != ESP_OK) {
+        s_stats.packets_invalid++;
+        return;
+    }
+    if (pkt.universe < SMARTLOVE_E131_UNIVERSE_START || pkt.universe > RT_E131_UNIVERSE_LAST ||
+        (pkt.options & (E131_OPT_PREVIEW | E131_OPT_TERMINATED))) {
+        return;
+    }
+
+    uint16_t index = pkt.universe - SMARTLOVE_E131_UNIVERSE_START;
+    if (!check_sequence(realtime_seq_e131(&s_e131_seq[index], pkt.sequence))) {
+        return;
+    }
+
+    s_stats.packets_received++;
+    begin_packet(rx_us);
+
+    size_t channels = pkt.channel_count;
+    if (channels > SMARTLOVE_E131_CHANNELS_PER_UNIVERSE) {
+        channels = SMARTLOVE_E131_CHANNELS_PER_UNIVERSE;
+    }
+    write_pixels((uint32_t)index * SMARTLOVE_E131_CHANNELS_PER_UNIVERSE, pkt.data, channels);
+
+    if (pkt.universe == RT_E131_UNIVERSE_LAST) {
+        show_frame();
+    }
+}
+
+/**
+ * @brief Create a UDP socket bound to a port
+ */
+static int open_socket(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        return -1;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(port)
+    };
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind port %d", port);
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/**
+ * @brief Join the E1.31 multicast groups 239.255.<universe>
+ */
+static void join_e131_groups(int sock)
+{
+    for (uint16_t u = SMARTLOVE_E131_UNIVERSE_START; u <= RT_E131_UNIVERSE_LAST; u++) {
+        struct ip_mreq mreq = {
+            .imr_multiaddr.s_addr = htonl(0xEFFF0000 | u),
+            .imr_interface.s_addr = htonl(INADDR_ANY),
+        };
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            ESP_LOGW(TAG, "Failed to join multicast group of universe %d", u);
+        }
+    }
+}
+
+/**
+ * @brief Receive one pending packet from a socket
+ */
+static void receive_packet(int sock, void (*handler)(const uint8_t *, size_t, int64_t))
+{
+    int len = recv(sock, s_rx_buffer, sizeof(s_rx_buffer), 0);
+    if (len > 0) {
+        handler(s_rx_buffer, (size_t)len, esp_timer_get_time());
+    }
+}
+
+/**
+ * @brief Receiver task: blocks in select() until a packet arrives
+ */
+static void realtime_receiver_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Realtime receiver running (DDP %d, E1.31 %d, universes %d-%d)",
+             SMARTLOVE_DDP_PORT, SMARTLOVE_E131_PORT,
+             SMARTLOVE_E131_UNIVERSE_START, RT_E131_UNIVERSE_LAST);
+
+    while (s_running) {
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        int max_fd = -1;
+        if (s_ddp_socket >= 0) {
+            FD_SET(s_ddp_socket, &read_fds);
+            max_fd = s_ddp_socket;
+        }
+        if (s_e131_socket >= 0) {
+            FD_SET(s_e131_socket, &read_fds);
+            if (s_e131_socket > max_fd) {
+                max_fd = s_e131_socket;
+            }
+        }
+
+        struct timeval timeout = {
+            .tv_sec = 0,
+            .tv_usec = RT_SELECT_TIMEOUT_MS * 1000
+        };
+        int ready = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
+        if (ready <= 0) {
+            continue;
+        }
+
+        if (s_ddp_socket >= 0 && FD_ISSET(s_ddp_socket, &read_fds)) {
+            receive_packet(s_ddp_socket, handle_ddp);
+        }
+        if (s_e131_socket >= 0 && FD_ISSET(s_e131_socket, &read_fds)) {
+            receive_packet(s_e131_socket, handle_e131);
+        }
+    }
+
+    if (s_ddp_socket >= 0) {
+        close(s_ddp_socket);
+        s_ddp_socket = -1;
+    }
+    if (s_e131_socket >= 0) {
+        close(s_e131_socket);
+        s_e131_socket = -1;
+    }
+
+    ESP_LOGI(TAG, "Realtime receiver stopped");
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+esp_err_t realtime_receiver_start(void)
+{
+    if (s_running) {
+        ESP_LOGW(TAG, "Realtime receiver already running");
+        return ESP_OK;
+    }
+
+    // A previous task may still be leaving select() after a stop
+    for (int i = 0; s_task_handle != NULL && i < 3; i++) {
+        vTaskDelay(pdMS_TO_TICKS(RT_SELECT_TIMEOUT_MS));
+    }
+    if (s_task_handle != NULL) {
+        ESP_LOGE(TAG, "Previous receiver task did not stop");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+#if SMARTLOVE_DDP_ENABLED
+    s_ddp_socket = open_socket(SMARTLOVE_DDP_PORT);
+#endif
+#if SMARTLOVE_E131_ENABLED
+    s_e131_socket = open_socket(SMARTLOVE_E131_PORT);
+    if (s_e131_socket >= 0) {
+        join_e131_groups(s_e131_socket);
+    }
+#endif
+
+    if (s_ddp_socket < 0 && s_e131_socket < 0) {
+        ESP_LOGE(TAG, "No realtime protocol available");
+        return ESP_FAIL;
+    }
+
+    // New senders start new sequences
+    memset(&s_ddp_seq, 0, sizeof(s_ddp_seq));
+    memset(s_e131_seq, 0, sizeof(s_e131_seq));
+    s_frame_start_us = 0;
+
+    s_running = true;
+    if (xTaskCreate(realtime_receiver_task, "realtime_rx", 3072, NULL,
+                    SMARTLOVE_REALTIME_TASK_PRIORITY, &s_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create realtime receiver task");
+        s_running = false;
+        if (s_ddp_socket >= 0) {
+            close(s_ddp_socket);
+            s_ddp_socket = -1;
+        }
+        if (s_e131_socket >= 0) {
+            close(s_e131_socket);
+            s_e131_socket = -1;
+        }
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t realtime_receiver_stop(void)
+{
+    if (!s_running) {
+        return ESP_OK;
+    }
+
+    // The task closes the sockets after its next select() timeout
+    s_running = false;
+    return ESP_OK;
+}
+
+bool realtime_receiver_is_running(void)
+{
+    return s_running;
+}
+
+esp_err_t realtime_receiver_get_stats(realtime_receiver_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = s_stats;
+    return ESP_OK;
+}
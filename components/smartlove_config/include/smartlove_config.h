@@ -83,6 +83,11 @@ extern "C" {
 #define SMARTLOVE_NVS_KEY_SSID              "ssid"
 #define SMARTLOVE_NVS_KEY_PASSWORD          "password"
 
+/**
+ * @brief NVS key of the persisted LED state (in SMARTLOVE_NVS_APP_NAMESPACE)
+ */
+#define SMARTLOVE_NVS_KEY_LED_STATE         "led_state"
+
 // ============================================================================
 // MQTT Configuration
 // ============================================================================
@@ -183,10 +188,24 @@ extern "C" {
 #define SMARTLOVE_GPIO_LED_STRIP            13
 
 /**
- * @brief Number of LEDs in the strip
+ * @brief Number of LEDs in the strip (per data line)
  */
 #define SMARTLOVE_LED_COUNT                 2
 
+/**
+ * @brief Number of parallel LED data lines (1-8)
+ * 
+ * Each line drives SMARTLOVE_LED_COUNT LEDs on its own GPIO and RMT channel.
+ * All lines are sent at the same time, so adding lines does not lower the
+ * frame rate. Pixels are numbered line after line.
+ */
+#define SMARTLOVE_LED_LINE_COUNT            1
+
+/**
+ * @brief Data GPIOs of the LED lines (SMARTLOVE_LED_LINE_COUNT entries)
+ */
+#define SMARTLOVE_GPIO_LED_LINES            { SMARTLOVE_GPIO_LED_STRIP }
+
 /**
  * @brief Button/Switch input pin
  */
@@ -207,15 +226,64 @@ extern "C" {
 // ============================================================================
 
 /**
- * @brief RMT channel for LED control
+ * @brief RMT channel for LED control (first channel if several lines)
  */
 #define SMARTLOVE_LED_RMT_CHANNEL           0
 
+/**
+ * @brief Pixel format of the LED strips
+ * 
+ * 0 = WS2812B (GRB, 3 bytes per LED)
+ * 1 = WS2812 with RGB channel order (3 bytes per LED)
+ * 2 = SK6812 RGBW (GRBW, 4 bytes per LED; whites use the white LED)
+ */
+#define SMARTLOVE_LED_PIXEL_FORMAT          0
+
+/**
+ * @brief Strip length (LEDs) from which the WS2812 driver streams
+ * 
+ * Shorter strips are pre-encoded into a full RMT item buffer (32 bytes per
+ * LED byte, i.e. 96 bytes per RGB LED and 128 bytes per RGBW LED).
+ * Longer strips are encoded by the RMT translator while the hardware sends,
+ * so encode memory stays constant. Streaming uses two RMT memory blocks,
+ * i.e. the next RMT channel cannot be used. 0 = always stream.
+ */
+#define SMARTLOVE_LED_RMT_STREAM_MIN_LEDS   128
+
+/**
+ * @brief Allocate the LED strips and tasks statically
+ * 
+ * 1 = strip state, pixel buffers, RMT encode buffers and the LED task
+ *     stacks are static arrays sized from SMARTLOVE_LED_COUNT, so their
+ *     footprint is fixed at link time and they never touch the heap
+ * 0 = allocate them from the heap at init
+ */
+#define SMARTLOVE_LED_STATIC_ALLOC          1
+
+/**
+ * @brief Token pool of the JSON command parser
+ * 
+ * Every JSON value and object key takes one 10-byte token, so a command
+ * with "pixels" needs about three tokens per LED plus a few for the other
+ * fields. The pool is static; longer commands are rejected.
+ */
+#define SMARTLOVE_LED_JSON_MAX_TOKENS       256
+
 /**
  * @brief LED maximum brightness (0-255)
  */
 #define SMARTLOVE_LED_MAX_BRIGHTNESS        255
 
+/**
+ * @brief Apply gamma correction (2.2) to LED output
+ * 
+ * Makes fades and low intensities look perceptually even. The 8-bit
+ * output cannot go below 1/255, so with gamma a full color is dark at
+ * intensity 14 or less (linear output stays lit down to intensity 1).
+ * 0 = linear output
+ */
+#define SMARTLOVE_LED_GAMMA_ENABLED         1
+
 /**
  * @brief LED default brightness on startup (0-255)
  */
@@ -241,11 +309,150 @@ extern "C" {
  */
 #define SMARTLOVE_LED_DEFAULT_ON            1
 
+/**
+ * @brief Restore the last LED state (on/off, intensity, color, animation)
+ *        after a reboot
+ * 
+ * 0 = always start with the SMARTLOVE_LED_DEFAULT_* values
+ */
+#define SMARTLOVE_LED_PERSIST_ENABLED       1
+
+/**
+ * @brief Write window for the persisted LED state (ms)
+ * 
+ * Changes are collected for this long after the first one and then
+ * written once, so the state is saved at most once per window no matter
+ * how many commands arrive. Longer windows mean less flash wear, shorter
+ * ones lose less when power is cut.
+ */
+#define SMARTLOVE_LED_PERSIST_WINDOW_MS     5000
+
+/**
+ * @brief Boot-to-light budget (ms since the application started)
+ * 
+ * The LED controller is initialized before networking and shows the
+ * restored scene right away; a warning is logged when that takes longer.
+ */
+#define SMARTLOVE_BOOT_LED_BUDGET_MS        250
+
 /**
  * @brief LED blink animation interval (ms)
  */
 #define SMARTLOVE_LED_BLINK_INTERVAL_MS     500
 
+/**
+ * @brief Effect frame rate (frames per second)
+ * 
+ * All effects are rendered at this rate. The period is rounded to
+ * FreeRTOS ticks (CONFIG_FREERTOS_HZ).
+ */
+#define SMARTLOVE_LED_FRAME_RATE            50
+
+/**
+ * @brief LED command queue length (power of two)
+ * 
+ * Commands (color, intensity, show, ...) are queued for the LED task.
+ * When the queue is full, further commands are rejected until the LED
+ * task has caught up.
+ */
+#define SMARTLOVE_LED_COMMAND_QUEUE_LEN     32
+
+/**
+ * @brief Pixel frames per producer (set_pixels / binary frames / JSON
+ * pixels, and the realtime receiver), at least 2
+ * 
+ * A producer draws into one frame while up to this many minus one wait
+ * for the LED task; each costs 3 bytes per LED. When all are waiting, the
+ * next commit is rejected and its pixels go out with the one after.
+ */
+#define SMARTLOVE_LED_STAGING_FRAMES        4
+
+/**
+ * @brief Maximum number of keyframes in an uploaded timeline
+ * 
+ * Each keyframe takes 16 bytes, twice (upload buffer and player).
+ */
+#define SMARTLOVE_LED_TIMELINE_MAX_KEYFRAMES 64
+
+/**
+ * @brief Maximum number of commands waiting for their start time
+ * 
+ * Commands with "start_at" are held by the LED task until they are due.
+ * Further scheduled commands are dropped while all slots are taken.
+ */
+#define SMARTLOVE_LED_SCHEDULED_MAX         16
+
+/**
+ * @brief Accepted distance of "start_at" from the current time in ms
+ * 
+ * A start time further ahead or behind is taken for a typo (e.g. seconds
+ * instead of ms) and the command is rejected, instead of holding a
+ * scheduled slot that nothing can cancel.
+ */
+#define SMARTLOVE_LED_START_AT_WINDOW_MS    (24LL * 60 * 60 * 1000)
+
+// ============================================================================
+// Realtime Receiver Configuration (DDP / E1.31)
+// ============================================================================
+
+/**
+ * @brief Receive DDP frames (UDP)
+ */
+#define SMARTLOVE_DDP_ENABLED               1
+
+/**
+ * @brief DDP UDP port
+ */
+#define SMARTLOVE_DDP_PORT                  4048
+
+/**
+ * @brief Receive E1.31 (sACN) frames (UDP, unicast and multicast)
+ */
+#define SMARTLOVE_E131_ENABLED              1
+
+/**
+ * @brief E1.31 UDP port
+ */
+#define SMARTLOVE_E131_PORT                 5568
+
+/**
+ * @brief E1.31 universe mapped to the first LED
+ */
+#define SMARTLOVE_E131_UNIVERSE_START       1
+
+/**
+ * @brief DMX channels used per universe (510 = 170 RGB LEDs)
+ * 
+ * Universe SMARTLOVE_E131_UNIVERSE_START + n starts at LED
+ * n * SMARTLOVE_E131_CHANNELS_PER_UNIVERSE / 3.
+ */
+#define SMARTLOVE_E131_CHANNELS_PER_UNIVERSE 510
+
+/**
+ * @brief Realtime receiver task priority
+ */
+#define SMARTLOVE_REALTIME_TASK_PRIORITY    6
+
+// ============================================================================
+// Time Sync Configuration (SNTP)
+// ============================================================================
+
+/**
+ * @brief SNTP server for the shared clock
+ * 
+ * All devices of a show should use the same server (e.g. a local one) so
+ * their clocks agree to a few ms.
+ */
+#define SMARTLOVE_SNTP_SERVER               "pool.ntp.org"
+
+/**
+ * @brief Clock resync interval (seconds)
+ * 
+ * Bounds the drift between devices; the ESP32 clock drifts up to a few
+ * ms per minute.
+ */
+#define SMARTLOVE_TIME_SYNC_INTERVAL_SEC    120
+
 // ============================================================================
 // Web Server Configuration (Captive Portal)
 // ============================================================================
@@ -308,6 +515,11 @@ extern "C" {
  */
 #define SMARTLOVE_FEATURE_CAPTIVE_PORTAL    1
 
+/**
+ * @brief Enable the DDP / E1.31 realtime receiver
+ */
+#define SMARTLOVE_FEATURE_REALTIME          1
+
 #ifdef __cplusplus
 }
 #endif
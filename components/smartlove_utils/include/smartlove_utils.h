@@ -10,6 +10,7 @@
 #define SMARTLOVE_UTILS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "esp_err.h"
 #include "esp_idf_version.h"
@@ -25,6 +26,58 @@ extern "C" {
  */
 esp_err_t smartlove_utils_init(void);
 
+/**
+ * @brief Initialize NVS flash (erased and re-initialized if it is full or
+ *        from a newer format)
+ * 
+ * Safe to call more than once; lets components read settings before
+ * networking is up.
+ * 
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t smartlove_nvs_init(void);
+
+/**
+ * @brief Boot stages, in boot order
+ */
+typedef enum {
+    SMARTLOVE_BOOT_UTILS = 0,       ///< Utilities and NVS ready
+    SMARTLOVE_BOOT_LED_INIT,        ///< LED controller up, restored scene shown
+    SMARTLOVE_BOOT_WIFI_INIT,       ///< WiFi manager initialized
+    SMARTLOVE_BOOT_MQTT_INIT,       ///< MQTT client initialized
+    SMARTLOVE_BOOT_FIRST_IP,        ///< First IP address received
+    SMARTLOVE_BOOT_MQTT_CONNECTED,  ///< First MQTT connection
+    SMARTLOVE_BOOT_STAGE_COUNT
+} smartlove_boot_stage_t;
+
+/**
+ * @brief Record the time a boot stage was reached
+ * 
+ * Only the first call per stage counts, so reconnects do not move it.
+ * 
+ * @param stage Boot stage
+ */
+void smartlove_boot_mark(smartlove_boot_stage_t stage);
+
+/**
+ * @brief Get the time a boot stage was reached
+ * 
+ * @param stage Boot stage
+ * @return Milliseconds since the application started, 0 if not reached
+ */
+uint32_t smartlove_boot_get_ms(smartlove_boot_stage_t stage);
+
+/**
+ * @brief Format the reached boot stages as a JSON object
+ * 
+ * Example: {"utils":31,"led":38,"wifi":112,"mqtt":115,"ip":2410,"mqtt_connected":2690}
+ * 
+ * @param buffer Output buffer
+ * @param size Buffer size
+ * @return Length written (without terminator), size or more if truncated
+ */
+int smartlove_boot_format_json(char *buffer, size_t size);
+
 /**
  * @brief Get system uptime in milliseconds
  * 
@@ -7,11 +7,24 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_system.h"
+#include "nvs_flash.h"
 #include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "smartlove_utils";
 
+// Boot stage times in us since start, 0 = not reached
+static int64_t s_boot_us[SMARTLOVE_BOOT_STAGE_COUNT] = {0};
+
+static const char *const s_boot_stage_names[SMARTLOVE_BOOT_STAGE_COUNT] = {
+    [SMARTLOVE_BOOT_UTILS] = "utils",
+    [SMARTLOVE_BOOT_LED_INIT] = "led",
+    [SMARTLOVE_BOOT_WIFI_INIT] = "wifi",
+    [SMARTLOVE_BOOT_MQTT_INIT] = "mqtt",
+    [SMARTLOVE_BOOT_FIRST_IP] = "ip",
+    [SMARTLOVE_BOOT_MQTT_CONNECTED] = "mqtt_connected",
+};
+
 esp_err_t smartlove_utils_init(void)
 {
     ESP_LOGI(TAG, "Initializing SmartLove Utilities");
@@ -26,6 +39,60 @@ esp_err_t smartlove_utils_init(void)
     return ESP_OK;
 }
 
+esp_err_t smartlove_nvs_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition needs to be erased");
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    return ret;
+}
+
+void smartlove_boot_mark(smartlove_boot_stage_t stage)
+{
+    if (stage >= SMARTLOVE_BOOT_STAGE_COUNT || s_boot_us[stage] != 0) {
+        return;
+    }
+
+    s_boot_us[stage] = esp_timer_get_time();
+    ESP_LOGI(TAG, "Boot stage '%s' reached after %u ms", s_boot_stage_names[stage],
+             (unsigned int)(s_boot_us[stage] / 1000));
+}
+
+uint32_t smartlove_boot_get_ms(smartlove_boot_stage_t stage)
+{
+    if (stage >= SMARTLOVE_BOOT_STAGE_COUNT || s_boot_us[stage] == 0) {
+        return 0;
+    }
+    // A stage reached within the first ms still reads as reached
+    uint32_t ms = (uint32_t)(s_boot_us[stage] / 1000);
+    return ms > 0 ? ms : 1;
+}
+
+int smartlove_boot_format_json(char *buffer, size_t size)
+{
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+
+    int len = snprintf(buffer, size, "{");
+    for (int stage = 0; stage < SMARTLOVE_BOOT_STAGE_COUNT && len < (int)size; stage++) {
+        uint32_t ms = smartlove_boot_get_ms((smartlove_boot_stage_t)stage);
+        if (ms != 0) {
+            len += snprintf(buffer + len, size - len, "%s\"%s\":%u", len > 1 ? "," : "",
+                            s_boot_stage_names[stage], (unsigned int)ms);
+        }
+    }
+    if (len < (int)size) {
+        len += snprintf(buffer + len, size - len, "}");
+    }
+    return len;
+}
+
 uint64_t smartlove_get_uptime_ms(void)
 {
     return esp_timer_get_time() / 1000ULL;
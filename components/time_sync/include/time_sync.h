@@ -0,0 +1,84 @@
+/**
+ * @file time_sync.h
+ * @brief Shared wall clock (SNTP) for synchronised LED starts
+ * 
+ * Keeps the offset between the local esp_timer clock and Unix time, so a
+ * start time sent to several devices ("start_at" in Unix ms) maps to the
+ * same instant on each of them. The offset is refreshed every
+ * SMARTLOVE_TIME_SYNC_INTERVAL_SEC; each refresh records how far it moved
+ * (the drift since the last sync).
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Clock synchronisation statistics
+ */
+typedef struct {
+    bool synced;                ///< At least one sync since start
+    uint32_t syncs;             ///< Completed syncs
+    int64_t offset_us;          ///< Unix time minus local time
+    int32_t correction_us;      ///< Offset change applied by the last sync
+    uint32_t last_sync_age_ms;  ///< Time since the last sync
+} time_sync_stats_t;
+
+/**
+ * @brief Start synchronising (call once the network is up)
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t time_sync_start(void);
+
+/**
+ * @brief Stop synchronising (the last offset stays valid)
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t time_sync_stop(void);
+
+/**
+ * @brief Check if the clock has been synchronised
+ * 
+ * @return true after the first successful sync
+ */
+bool time_sync_is_synced(void);
+
+/**
+ * @brief Get the shared time
+ * 
+ * @return Unix time in ms, or 0 if not synchronised
+ */
+int64_t time_sync_now_ms(void);
+
+/**
+ * @brief Convert a shared time to local esp_timer time
+ * 
+ * @param time_ms Unix time in ms
+ * @param local_us Output local time in us (esp_timer_get_time() base)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not synchronised,
+ *         ESP_ERR_INVALID_ARG if time_ms is out of range (beyond +-4.6e15)
+ */
+esp_err_t time_sync_to_local_us(int64_t time_ms, int64_t *local_us);
+
+/**
+ * @brief Get synchronisation statistics
+ * 
+ * @param stats Pointer to statistics structure to fill
+ * @return ESP_OK on success
+ */
+esp_err_t time_sync_get_stats(time_sync_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIME_SYNC_H
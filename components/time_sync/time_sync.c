@@ -0,0 +1,152 @@
+/**
+ * @file time_sync.c
+ * @brief Shared wall clock (SNTP) for synchronised LED starts
+ */
+
+#include "time_sync.h"
+#include "smartlove_config.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sntp.h"
+#include "freertos/FreeRTOS.h"
+#include <sys/time.h>
+
+static const char *TAG = "time_sync";
+
+// IDF 5.1 renamed the SNTP API to esp_sntp_*
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#define SNTP_SETOPERATINGMODE(m)    esp_sntp_setoperatingmode(m)
+#define SNTP_SETSERVERNAME(i, s)    esp_sntp_setservername(i, s)
+#define SNTP_INIT()                 esp_sntp_init()
+#define SNTP_STOP()                 esp_sntp_stop()
+#define SNTP_OPMODE                 ESP_SNTP_OPMODE_POLL
+#else
+#define SNTP_SETOPERATINGMODE(m)    sntp_setoperatingmode(m)
+#define SNTP_SETSERVERNAME(i, s)    sntp_setservername(i, s)
+#define SNTP_INIT()                 sntp_init()
+#define SNTP_STOP()                 sntp_stop()
+#define SNTP_OPMODE                 SNTP_OPMODE_POLL
+#endif
+
+// Offset and statistics, written by the SNTP callback (lwIP task)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static time_sync_stats_t s_stats;
+static int64_t s_last_sync_us = 0;
+static bool s_running = false;
+
+// ============================================================================
+// Private Functions
+// ============================================================================
+
+/**
+ * @brief Take over the time just set by SNTP
+ */
+static void sync_notification_cb(struct timeval *tv)
+{
+    int64_t local_us = esp_timer_get_time();
+    int64_t offset_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - local_us;
+
+    portENTER_CRITICAL(&s_lock);
+    int32_t correction_us = s_stats.synced ? (int32_t)(offset_us - s_stats.offset_us) : 0;
+    s_stats.correction_us = correction_us;
+    s_stats.offset_us = offset_us;
+    s_stats.synced = true;
+    s_stats.syncs++;
+    s_last_sync_us = local_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Clock synced (correction %d us)", (int)correction_us);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+esp_err_t time_sync_start(void)
+{
+    if (s_running) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Starting SNTP (%s, every %d s)", SMARTLOVE_SNTP_SERVER,
+             SMARTLOVE_TIME_SYNC_INTERVAL_SEC);
+
+    SNTP_SETOPERATINGMODE(SNTP_OPMODE);
+    SNTP_SETSERVERNAME(0, SMARTLOVE_SNTP_SERVER);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_sync_interval(SMARTLOVE_TIME_SYNC_INTERVAL_SEC * 1000);
+    sntp_set_time_sync_notification_cb(sync_notification_cb);
+    SNTP_INIT();
+
+    s_running = true;
+    return ESP_OK;
+}
+
+esp_err_t time_sync_stop(void)
+{
+    if (!s_running) {
+        return ESP_OK;
+    }
+
+    SNTP_STOP();
+    s_running = false;
+    ESP_LOGI(TAG, "SNTP stopped");
+    return ESP_OK;
+}
+
+bool time_sync_is_synced(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool synced = s_stats.synced;
+    portEXIT_CRITICAL(&s_lock);
+    return synced;
+}
+
+int64_t time_sync_now_ms(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool synced = s_stats.synced;
+    int64_t offset_us = s_stats.offset_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!synced) {
+        return 0;
+    }
+    return (esp_timer_get_time() + offset_us) / 1000;
+}
+
+esp_err_t time_sync_to_local_us(int64_t time_ms, int64_t *local_us)
+{
+    // time_ms * 1000 must not overflow; the offset is far below the margin
+    if (local_us == NULL || time_ms > INT64_MAX / 2000 || time_ms < INT64_MIN / 2000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool synced = s_stats.synced;
+    int64_t offset_us = s_stats.offset_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!synced) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *local_us = time_ms * 1000 - offset_us;
+    return ESP_OK;
+}
+
+esp_err_t time_sync_get_stats(time_sync_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    int64_t last_sync_us = s_last_sync_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    stats->last_sync_age_ms = stats->synced ?
+        (uint32_t)((esp_timer_get_time() - last_sync_us) / 1000) : 0;
+    return ESP_OK;
+}
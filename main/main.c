@@ -22,17 +22,33 @@
 #include "wifi_manager.h"
 #include "smartlove_mqtt.h"
 #include "led_controller.h"
+#include "led_latency.h"
 #include "button_handler.h"
+#include "realtime_receiver.h"
+#include "time_sync.h"
 
 static const char *TAG = "SmartLove";
 
 // MQTT connection flag
 static bool mqtt_started = false;
 
+// Longest payload excerpt written to the log
+#define MQTT_LOG_DATA_MAX 128
+
+/**
+ * @brief Compare a length-delimited message with a text command
+ */
+static bool message_is(const char *data, int data_len, const char *command)
+{
+    size_t len = strlen(command);
+    return (size_t)data_len == len && memcmp(data, command, len) == 0;
+}
+
 /**
  * @brief MQTT message callback
  * 
- * Called when a message is received on SmartLove/<chipID>/in
+ * Called when a message is received on SmartLove/<chipID>/in. The payload
+ * is read in place and is not NUL-terminated.
  */
 static void mqtt_message_handler(const char *topic, int topic_len,
                                  const char *data, int data_len,
@@ -40,20 +56,15 @@ static void mqtt_message_handler(const char *topic, int topic_len,
 {
     ESP_LOGI(TAG, "📨 MQTT Message received:");
     ESP_LOGI(TAG, "   Topic: %.*s", topic_len, topic);
-    ESP_LOGI(TAG, "   Data: %.*s", data_len, data);
+    ESP_LOGI(TAG, "   Data: %.*s%s (%d bytes)", data_len < MQTT_LOG_DATA_MAX ? data_len : MQTT_LOG_DATA_MAX,
+             data, data_len > MQTT_LOG_DATA_MAX ? "..." : "", data_len);
     
     // Process message
-    if (data_len > 0 && data_len < 512) {
-        char message[512];
-        memcpy(message, data, data_len);
-        message[data_len] = '\0';
-        
-        ESP_LOGI(TAG, "💬 Processing command: %s", message);
-        
+    if (data_len > 0) {
         // Try to parse as JSON for LED control
-        if (message[0] == '{') {
+        if (data[0] == '{') {
             ESP_LOGI(TAG, "🎨 LED command detected");
-            esp_err_t ret = led_controller_process_json(message);
+            esp_err_t ret = led_controller_process_json_len(data, data_len, mqtt_client_get_rx_time_us());
             if (ret == ESP_OK) {
                 mqtt_client_send("{\"status\":\"ok\",\"type\":\"led\"}");
             } else {
@@ -61,34 +72,129 @@ static void mqtt_message_handler(const char *topic, int topic_len,
             }
         }
         // Simple text commands
-        else if (strcmp(message, "PING") == 0) {
+        else if (message_is(data, data_len, "PING")) {
             mqtt_client_send("PONG");
-        } else if (strcmp(message, "STATUS") == 0) {
-            char status_msg[256];
+        } else if (message_is(data, data_len, "STATUS")) {
+            char status_msg[704];
             led_state_t led_state;
+            led_stats_t led_stats;
+            mqtt_rx_stats_t rx_stats;
             led_controller_get_state(&led_state);
+            led_controller_get_stats(&led_stats);
+            mqtt_client_get_rx_stats(&rx_stats);
             
             snprintf(status_msg, sizeof(status_msg), 
                     "{\"status\":\"online\",\"heap\":%u,\"uptime\":%llu,"
-                    "\"led\":{\"on\":%s,\"intensity\":%d,\"color\":{\"r\":%d,\"g\":%d,\"b\":%d}}}",
+                    "\"mqtt\":{\"messages\":%u,\"reassembled\":%u,\"dropped\":%u},"
+                    "\"led\":{\"on\":%s,\"intensity\":%d,\"color\":{\"r\":%d,\"g\":%d,\"b\":%d},"
+                    "\"frames\":{\"sent\":%u,\"skipped\":%u,\"received\":%u,\"displayed\":%u},"
+                    "\"effects\":{\"frames\":%u,\"missed\":%u,\"render_us_max\":%u,\"transmit_us_max\":%u},"
+                    "\"commands\":{\"dropped\":%u},"
+                    "\"persist\":{\"writes\":%u,\"total\":%u},"
+                    "\"timeline\":{\"keyframes\":%u,\"position_ms\":%u,\"paused\":%s}}}",
                     (unsigned int)esp_get_free_heap_size(),
                     smartlove_get_uptime_ms() / 1000,
+                    (unsigned int)rx_stats.messages,
+                    (unsigned int)rx_stats.reassembled,
+                    (unsigned int)rx_stats.dropped,
                     led_state.is_on ? "true" : "false",
                     led_state.intensity,
                     led_state.color.r,
                     led_state.color.g,
-                    led_state.color.b);
+                    led_state.color.b,
+                    (unsigned int)led_stats.frames_sent,
+                    (unsigned int)led_stats.frames_skipped,
+                    (unsigned int)led_stats.stream_frames_received,
+                    (unsigned int)led_stats.stream_frames_displayed,
+                    (unsigned int)led_stats.effect_frames,
+                    (unsigned int)led_stats.deadlines_missed,
+                    (unsigned int)led_stats.render_us_max,
+                    (unsigned int)led_stats.transmit_us_max,
+                    (unsigned int)led_stats.commands_dropped,
+                    (unsigned int)led_stats.state_writes,
+                    (unsigned int)led_stats.state_writes_total,
+                    (unsigned int)led_state.timeline_keyframes,
+                    (unsigned int)led_state.timeline_position_ms,
+                    led_state.timeline_paused ? "true" : "false");
             mqtt_client_send(status_msg);
-        } else if (strcmp(message, "LED_ON") == 0) {
+        } else if (message_is(data, data_len, "REALTIME")) {
+            char rt_msg[320];
+            realtime_receiver_stats_t rt_stats;
+            realtime_receiver_get_stats(&rt_stats);
+            
+            snprintf(rt_msg, sizeof(rt_msg),
+                    "{\"realtime\":{\"running\":%s,"
+                    "\"packets\":{\"received\":%u,\"invalid\":%u,\"lost\":%u,\"out_of_order\":%u},"
+                    "\"frames\":{\"received\":%u,\"displayed\":%u},"
+                    "\"latency_us\":{\"last\":%u,\"avg\":%u,\"max\":%u}}}",
+                    realtime_receiver_is_running() ? "true" : "false",
+                    (unsigned int)rt_stats.packets_received,
+                    (unsigned int)rt_stats.packets_invalid,
+                    (unsigned int)rt_stats.packets_lost,
+                    (unsigned int)rt_stats.packets_out_of_order,
+                    (unsigned int)rt_stats.frames_received,
+                    (unsigned int)rt_stats.frames_displayed,
+                    (unsigned int)rt_stats.latency_last_us,
+                    (unsigned int)rt_stats.latency_avg_us,
+                    (unsigned int)rt_stats.latency_max_us);
+            mqtt_client_send(rt_msg);
+        } else if (message_is(data, data_len, "TIME")) {
+            char time_msg[192];
+            time_sync_stats_t time_stats;
+            time_sync_get_stats(&time_stats);
+            
+            snprintf(time_msg, sizeof(time_msg),
+                    "{\"time\":{\"synced\":%s,\"now_ms\":%lld,\"syncs\":%u,"
+                    "\"offset_us\":%lld,\"correction_us\":%d,\"last_sync_ms\":%u}}",
+                    time_stats.synced ? "true" : "false",
+                    (long long)time_sync_now_ms(),
+                    (unsigned int)time_stats.syncs,
+                    (long long)time_stats.offset_us,
+                    (int)time_stats.correction_us,
+                    (unsigned int)time_stats.last_sync_age_ms);
+            mqtt_client_send(time_msg);
+        } else if (message_is(data, data_len, "LATENCY")) {
+            char latency_msg[512];
+            led_latency_stats_t latency;
+            led_controller_get_latency(&latency);
+            
+            int len = snprintf(latency_msg, sizeof(latency_msg), "{\"latency_us\":{");
+            for (int stage = 0; stage < LED_LATENCY_STAGE_COUNT; stage++) {
+                const led_latency_summary_t *s = &latency.stages[stage];
+                len += snprintf(latency_msg + len, sizeof(latency_msg) - len,
+                                "%s\"%s\":{\"n\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u}",
+                                stage > 0 ? "," : "",
+                                led_latency_stage_name((led_latency_stage_t)stage),
+                                (unsigned int)s->samples, (unsigned int)s->p50_us,
+                                (unsigned int)s->p99_us, (unsigned int)s->max_us);
+            }
+            snprintf(latency_msg + len, sizeof(latency_msg) - len, "},\"unchanged\":%u}",
+                     (unsigned int)latency.traces_unchanged);
+            mqtt_client_send(latency_msg);
+        } else if (message_is(data, data_len, "LATENCY_RESET")) {
+            led_controller_reset_latency();
+            mqtt_client_send("{\"status\":\"ok\",\"latency\":\"reset\"}");
+        } else if (message_is(data, data_len, "LED_ON")) {
             led_controller_on();
             mqtt_client_send("{\"status\":\"ok\",\"led\":\"on\"}");
-        } else if (strcmp(message, "LED_OFF") == 0) {
+        } else if (message_is(data, data_len, "LED_OFF")) {
             led_controller_off();
             mqtt_client_send("{\"status\":\"ok\",\"led\":\"off\"}");
         }
     }
 }
 
+/**
+ * @brief MQTT frame callback
+ * 
+ * Called for each chunk of a binary frame on SmartLove/<chipID>/frame
+ */
+static void mqtt_frame_handler(const uint8_t *data, int len, int offset,
+                               int total_len, void *user_data)
+{
+    led_controller_write_frame(data, len, offset, total_len);
+}
+
 /**
  * @brief MQTT status callback
  */
@@ -132,6 +238,10 @@ static void wifi_event_callback(wifi_manager_event_t event, void *user_data)
     switch (event) {
         case WIFI_MANAGER_EVENT_STA_CONNECTED:
             ESP_LOGI(TAG, "📶 WiFi Connected!");
+            smartlove_boot_mark(SMARTLOVE_BOOT_FIRST_IP);
+            
+            // Shared clock for "start_at" commands
+            time_sync_start();
             
             if (!mqtt_started) {
                 ESP_LOGI(TAG, "Starting MQTT client...");
@@ -141,6 +251,13 @@ static void wifi_event_callback(wifi_manager_event_t event, void *user_data)
                     ESP_LOGE(TAG, "Failed to start MQTT client");
                 }
             }
+            
+#if SMARTLOVE_FEATURE_REALTIME
+            // LAN realtime input (DDP / E1.31)
+            if (realtime_receiver_start() != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to start realtime receiver");
+            }
+#endif
             break;
             
         case WIFI_MANAGER_EVENT_STA_DISCONNECTED:
@@ -151,6 +268,13 @@ static void wifi_event_callback(wifi_manager_event_t event, void *user_data)
                 mqtt_client_stop();
                 mqtt_started = false;
             }
+            
+            // The last offset stays in use until the next sync
+            time_sync_stop();
+            
+#if SMARTLOVE_FEATURE_REALTIME
+            realtime_receiver_stop();
+#endif
             break;
             
         case WIFI_MANAGER_EVENT_AP_STARTED:
@@ -181,8 +305,10 @@ static void wifi_event_callback(wifi_manager_event_t event, void *user_data)
  */
 void app_main(void)
 {
-    // Initialize utilities
+    // Initialize utilities and NVS (the LED controller reads its saved state)
     ESP_ERROR_CHECK(smartlove_utils_init());
+    ESP_ERROR_CHECK(smartlove_nvs_init());
+    smartlove_boot_mark(SMARTLOVE_BOOT_UTILS);
     
     ESP_LOGI(TAG, "=================================");
     ESP_LOGI(TAG, "   SmartLove Application");
@@ -191,6 +317,18 @@ void app_main(void)
     ESP_LOGI(TAG, "IDF 5.x compatible: %s", 
              smartlove_is_idf5_or_higher() ? "Yes" : "No");
     
+    // Initialize LED controller first: it restores and shows the last
+    // scene without waiting for networking
+    ESP_LOGI(TAG, "Initializing LED controller...");
+    ESP_ERROR_CHECK(led_controller_init());
+    smartlove_boot_mark(SMARTLOVE_BOOT_LED_INIT);
+    ESP_LOGI(TAG, "LED controller initialized (GPIO %d, %d LEDs)", LED_GPIO_PIN, LED_STRIP_LENGTH);
+    if (smartlove_boot_get_ms(SMARTLOVE_BOOT_LED_INIT) > SMARTLOVE_BOOT_LED_BUDGET_MS) {
+        ESP_LOGW(TAG, "LEDs lit after %u ms (budget %d ms)",
+                 (unsigned int)smartlove_boot_get_ms(SMARTLOVE_BOOT_LED_INIT),
+                 SMARTLOVE_BOOT_LED_BUDGET_MS);
+    }
+    
     // Initialize WiFi Manager
     ESP_LOGI(TAG, "Initializing WiFi Manager...");
     wifi_manager_config_t config = wifi_manager_get_default_config();
@@ -200,19 +338,17 @@ void app_main(void)
     
     ESP_ERROR_CHECK(wifi_manager_init(&config));
     ESP_ERROR_CHECK(wifi_manager_register_event_callback(wifi_event_callback, NULL));
+    smartlove_boot_mark(SMARTLOVE_BOOT_WIFI_INIT);
     
     // Initialize MQTT client BEFORE starting WiFi
     ESP_LOGI(TAG, "Initializing MQTT client...");
     ESP_ERROR_CHECK(mqtt_client_init());
     ESP_ERROR_CHECK(mqtt_client_register_message_callback(mqtt_message_handler, NULL));
     ESP_ERROR_CHECK(mqtt_client_register_status_callback(mqtt_status_handler, NULL));
+    ESP_ERROR_CHECK(mqtt_client_register_frame_callback(mqtt_frame_handler, NULL));
+    smartlove_boot_mark(SMARTLOVE_BOOT_MQTT_INIT);
     ESP_LOGI(TAG, "MQTT client initialized (will start when WiFi connects)");
     
-    // Initialize LED controller
-    ESP_LOGI(TAG, "Initializing LED controller...");
-    ESP_ERROR_CHECK(led_controller_init());
-    ESP_LOGI(TAG, "LED controller initialized (GPIO %d, %d LEDs)", LED_GPIO_PIN, LED_STRIP_LENGTH);
-    
     // Initialize button handler
     ESP_LOGI(TAG, "Initializing button handler...");
     esp_err_t ret = button_handler_init();
@@ -0,0 +1,162 @@
+/**
+ * @file bench_led_color.c
+ * @brief Integer color kernels: round-trip accuracy, cost per pixel
+ *
+ * The reference is the textbook double-precision HSV -> RGB conversion on
+ * the same 1536-step hue circle.
+ */
+
+#include "host_test.h"
+#include "led_color.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define SPAN 1024
+
+static led_hsv_t s_hsv[SPAN];
+static led_rgb_t s_rgb[SPAN];
+
+/**
+ * @brief Double-precision HSV -> RGB, channels 0.0-255.0
+ */
+static void hsv_to_rgb_double(led_hsv_t hsv, double out[3])
+{
+    double h = (hsv.h % LED_HUE_MAX) / 256.0;
+    double v = hsv.v / 255.0;
+    double c = v * (hsv.s / 255.0);
+    double x = c * (1.0 - fabs(fmod(h, 2.0) - 1.0));
+    double m = v - c;
+    double r, g, b;
+
+    switch ((int)h) {
+        case 0: r = c; g = x; b = 0; break;
+        case 1: r = x; g = c; b = 0; break;
+        case 2: r = 0; g = c; b = x; break;
+        case 3: r = 0; g = x; b = c; break;
+        case 4: r = x; g = 0; b = c; break;
+        default: r = c; g = 0; b = x; break;
+    }
+    out[0] = (r + m) * 255.0;
+    out[1] = (g + m) * 255.0;
+    out[2] = (b + m) * 255.0;
+}
+
+static led_rgb_t hsv_to_rgb_reference(led_hsv_t hsv)
+{
+    double c[3];
+    hsv_to_rgb_double(hsv, c);
+    led_rgb_t rgb = { (uint8_t)lround(c[0]), (uint8_t)lround(c[1]), (uint8_t)lround(c[2]) };
+    return rgb;
+}
+
+static int channel_error(led_rgb_t a, led_rgb_t b)
+{
+    int e = abs(a.r - b.r);
+    if (abs(a.g - b.g) > e) {
+        e = abs(a.g - b.g);
+    }
+    if (abs(a.b - b.b) > e) {
+        e = abs(a.b - b.b);
+    }
+    return e;
+}
+
+static void test_hsv_against_reference(void)
+{
+    double max_error = 0;
+    for (uint32_t h = 0; h < LED_HUE_MAX; h += 3) {
+        for (uint32_t s = 0; s < 256; s += 5) {
+            for (uint32_t v = 0; v < 256; v += 5) {
+                led_hsv_t hsv = { (uint16_t)h, (uint8_t)s, (uint8_t)v };
+                led_rgb_t rgb = led_hsv_to_rgb(hsv);
+                double ref[3];
+                hsv_to_rgb_double(hsv, ref);
+                const uint8_t got[3] = { rgb.r, rgb.g, rgb.b };
+                for (int i = 0; i < 3; i++) {
+                    double e = fabs(got[i] - ref[i]);
+                    max_error = e > max_error ? e : max_error;
+                }
+            }
+        }
+    }
+    printf("hsv->rgb: max %.3f from the double result\n", max_error);
+    CHECK(max_error <= 0.5 + 1e-9);
+
+    // Primaries and wrap
+    led_rgb_t c = led_hsv_to_rgb((led_hsv_t){ LED_HUE_FROM_DEG(120), 255, 255 });
+    CHECK(c.r == 0 && c.g == 255 && c.b == 0);
+    c = led_hsv_to_rgb((led_hsv_t){ LED_HUE_MAX, 255, 255 });
+    CHECK(c.r == 255 && c.g == 0 && c.b == 0);
+}
+
+static void test_round_trips(void)
+{
+    // Every RGB color through HSV and HSL and back
+    int max_hsv = 0, max_hsl = 0;
+    long hsv_off = 0, hsl_off = 0;
+    for (uint32_t i = 0; i < (1u << 24); i++) {
+        led_rgb_t rgb = { (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i };
+        int e = channel_error(rgb, led_hsv_to_rgb(led_rgb_to_hsv(rgb)));
+        max_hsv = e > max_hsv ? e : max_hsv;
+        hsv_off += e != 0;
+        e = channel_error(rgb, led_hsl_to_rgb(led_rgb_to_hsl(rgb)));
+        max_hsl = e > max_hsl ? e : max_hsl;
+        hsl_off += e != 0;
+    }
+    printf("round trip over all 2^24 colors: hsv max %d (%ld off), hsl max %d (%ld off)\n",
+           max_hsv, hsv_off, max_hsl, hsl_off);
+    CHECK(max_hsv <= 1);
+    CHECK(max_hsl <= 1);
+
+    // Greys keep hue 0 and no saturation
+    led_hsv_t grey = led_rgb_to_hsv((led_rgb_t){ 77, 77, 77 });
+    CHECK(grey.h == 0 && grey.s == 0 && grey.v == 77);
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = host_test_iterations(argc, argv, 20);
+
+    test_hsv_against_reference();
+    test_round_trips();
+
+    uint32_t seed = 11;
+    for (int i = 0; i < SPAN; i++) {
+        seed = seed * 1103515245 + 12345;
+        s_hsv[i].h = (uint16_t)((seed >> 8) % LED_HUE_MAX);
+        s_hsv[i].s = (uint8_t)(seed >> 16);
+        s_hsv[i].v = (uint8_t)(seed >> 24);
+    }
+
+    int64_t t0 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        led_hsv_to_rgb_span(s_hsv, s_rgb, SPAN);
+        host_test_use(s_rgb);
+    }
+    int64_t t1 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        led_rgb_to_hsv_span(s_rgb, s_hsv, SPAN);
+        host_test_use(s_hsv);
+    }
+    int64_t t2 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        led_hue_gradient(s_rgb, SPAN, (uint16_t)n, (LED_HUE_MAX << 8) / SPAN, 255, 255);
+        host_test_use(s_rgb);
+    }
+    int64_t t3 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < SPAN; i++) {
+            s_rgb[i] = hsv_to_rgb_reference(s_hsv[i]);
+        }
+        host_test_use(s_rgb);
+    }
+    int64_t t4 = host_test_now_ns();
+
+    double per_pixel = 1.0 / ((double)iterations * SPAN);
+    printf("%d pixels x %ld: hsv->rgb %.2f ns/pixel, rgb->hsv %.2f ns/pixel, "
+           "hue gradient %.2f ns/pixel, double hsv->rgb %.2f ns/pixel\n",
+           SPAN, iterations, (t1 - t0) * per_pixel, (t2 - t1) * per_pixel,
+           (t3 - t2) * per_pixel, (t4 - t3) * per_pixel);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,152 @@
+/**
+ * @file bench_led_json.c
+ * @brief JSON tokenizer: typical commands, cost per command, no allocations
+ *
+ * Times what led_controller_process_json() does before applying a
+ * command: tokenize the message and look up all command fields of the
+ * root in one pass. malloc, calloc and realloc are wrapped at link time
+ * (-Wl,--wrap) to count calls made from the tokenizer.
+ */
+
+#include "host_test.h"
+#include "led_json.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 256
+
+static long s_allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    s_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    s_allocations++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    s_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// Root fields of the command schema (led_controller.c)
+static const char *const s_fields[] = {
+    "start_at", "intensity", "color", "range", "pixels", "start",
+    "show", "fade_ms", "easing", "timeline", "seek_ms", "player",
+};
+#define FIELD_COUNT (int)(sizeof(s_fields) / sizeof(s_fields[0]))
+
+static const struct {
+    const char *name;
+    const char *json;
+} s_commands[] = {
+    { "intensity+color",
+      "{\"intensity\": 255, \"color\": {\"r\": 255, \"g\": 0, \"b\": 0}}" },
+    { "fade (hsv, easing)",
+      "{\"show\": \"FADE\", \"color\": {\"hsv\": {\"h\": 240, \"s\": 100, \"v\": 100}}, "
+      "\"fade_ms\": 2000, \"easing\": \"ease-in-out\"}" },
+    { "timeline (3 kf)",
+      "{\"timeline\": {\"keyframes\": [[0, 255, 0, 0], [1000, 0, 255, 0], "
+      "[2000, 0, 0, 255]], \"loop\": true}, \"start_at\": 1700000000500}" },
+    { "pixels (20 LEDs)",
+      "{\"start\": 0, \"pixels\": [255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 0, "
+      "0, 255, 255, 255, 0, 255, 128, 128, 128, 255, 0, 0, 0, 255, 0, 0, 0, 255, "
+      "255, 255, 0, 0, 255, 255, 255, 0, 255, 128, 128, 128, 1, 2, 3, 4, 5, 6, "
+      "7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18]}" },
+};
+#define COMMAND_COUNT (sizeof(s_commands) / sizeof(s_commands[0]))
+
+static led_json_token_t s_tokens[MAX_TOKENS];
+
+static bool parse_command(const char *json, size_t len, int *fields, led_json_t *doc)
+{
+    if (!led_json_parse(doc, json, len, s_tokens, MAX_TOKENS)) {
+        return false;
+    }
+    led_json_get_members(doc, 0, s_fields, FIELD_COUNT, fields);
+    return true;
+}
+
+static void test_commands(void)
+{
+    led_json_t doc;
+    int fields[FIELD_COUNT];
+    int value;
+    double number;
+
+    const char *json = s_commands[0].json;
+    CHECK(parse_command(json, strlen(json), fields, &doc));
+    CHECK(led_json_get_int(&doc, fields[1], &value));
+    CHECK_EQ(value, 255);
+    CHECK_EQ(led_json_type(&doc, fields[2]), LED_JSON_OBJECT);
+    CHECK_EQ(fields[0], -1);
+
+    json = s_commands[1].json;
+    CHECK(parse_command(json, strlen(json), fields, &doc));
+    char name[32];
+    CHECK(led_json_get_string(&doc, fields[8], name, sizeof(name)));
+    CHECK(strcmp(name, "ease-in-out") == 0);
+    int hsv = led_json_find(&doc, fields[2], "hsv");
+    CHECK(led_json_get_int(&doc, led_json_find(&doc, hsv, "h"), &value));
+    CHECK_EQ(value, 240);
+
+    json = s_commands[2].json;
+    CHECK(parse_command(json, strlen(json), fields, &doc));
+    CHECK(led_json_get_number(&doc, fields[0], &number));
+    CHECK(number == 1700000000500.0);
+    CHECK_EQ(led_json_size(&doc, led_json_find(&doc, fields[9], "keyframes")), 3);
+
+    json = s_commands[3].json;
+    CHECK(parse_command(json, strlen(json), fields, &doc));
+    CHECK_EQ(led_json_size(&doc, fields[4]), 60);
+
+    // Only the length counts, no terminator needed
+    json = s_commands[0].json;
+    CHECK(parse_command(json, strlen(json) - 1, fields, &doc) == false);
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = host_test_iterations(argc, argv, 1000);
+
+    test_commands();
+
+    // The wrapper counts (an allocation here must show up)
+    s_allocations = 0;
+    void *p = malloc(16);
+    host_test_use(p);
+    free(p);
+    CHECK_EQ(s_allocations, 1);
+
+    printf("%-20s %5s %6s %12s %7s\n", "command", "bytes", "tokens", "ns/command", "allocs");
+    for (size_t c = 0; c < COMMAND_COUNT; c++) {
+        const char *json = s_commands[c].json;
+        size_t len = strlen(json);
+        led_json_t doc;
+        int fields[FIELD_COUNT];
+
+        s_allocations = 0;
+        int64_t t0 = host_test_now_ns();
+        for (long n = 0; n < iterations; n++) {
+            CHECK(parse_command(json, len, fields, &doc));
+            host_test_use(fields);
+        }
+        int64_t t1 = host_test_now_ns();
+
+        printf("%-20s %5u %6u %12.1f %7ld\n", s_commands[c].name, (unsigned int)len,
+               (unsigned int)doc.count, (double)(t1 - t0) / iterations, s_allocations);
+        CHECK_EQ(s_allocations, 0);
+    }
+
+    return HOST_TEST_RESULT();
+}
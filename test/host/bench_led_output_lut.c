@@ -0,0 +1,109 @@
+/**
+ * @file bench_led_output_lut.c
+ * @brief Output table: accuracy against the exact formula, cost per frame
+ *
+ * The divide path is the per-channel (c * intensity) / 255 the controller
+ * used before the table; the table path is one lookup per channel and
+ * additionally applies the brightness limit and gamma.
+ */
+
+#include "host_test.h"
+#include "led_color.h"
+#include <math.h>
+
+#define LED_COUNT 1000
+
+static uint8_t s_pixels[LED_COUNT * 3];
+static uint8_t s_out[LED_COUNT * 3];
+
+static void test_accuracy(void)
+{
+    uint8_t lut[256];
+    int off_by_one = 0;
+
+    for (int intensity = 0; intensity < 256; intensity++) {
+        led_output_lut(lut, (uint8_t)intensity, 255, true);
+        for (int v = 0; v < 256; v++) {
+            double x = (v / 255.0) * (intensity / 255.0);
+            int exact = (int)lround(255.0 * pow(x, 2.2));
+            int diff = lut[v] - exact;
+            CHECK(diff >= -1 && diff <= 1);
+            off_by_one += diff != 0;
+        }
+
+        // Never brighter for a brighter input
+        for (int v = 1; v < 256; v++) {
+            CHECK(lut[v] >= lut[v - 1]);
+        }
+    }
+    printf("gamma: %d of 65536 entries off by one from round(255 * x^2.2)\n", off_by_one);
+
+    // Ends and the documented low-end cutoff
+    led_output_lut(lut, 255, 255, true);
+    CHECK_EQ(lut[0], 0);
+    CHECK_EQ(lut[255], 255);
+    led_output_lut(lut, 14, 255, true);
+    CHECK_EQ(lut[255], 0);
+    led_output_lut(lut, 15, 255, true);
+    CHECK_EQ(lut[255], 1);
+
+    // Brightness limit scales like intensity
+    uint8_t limited[256];
+    led_output_lut(lut, 128, 255, true);
+    led_output_lut(limited, 255, 128, true);
+    for (int v = 0; v < 256; v++) {
+        CHECK_EQ(lut[v], limited[v]);
+    }
+
+    // Linear: round(v * intensity / 255)
+    led_output_lut(lut, 100, 255, false);
+    for (int v = 0; v < 256; v++) {
+        CHECK_EQ(lut[v], (v * 100 + 127) / 255);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = host_test_iterations(argc, argv, 200);
+
+    test_accuracy();
+
+    uint32_t seed = 7;
+    for (size_t i = 0; i < sizeof(s_pixels); i++) {
+        seed = seed * 1103515245 + 12345;
+        s_pixels[i] = (uint8_t)(seed >> 16);
+    }
+
+    // The intensity is read per frame so the compiler cannot fold the divide
+    volatile uint8_t intensity_src = 180;
+    uint8_t lut[256];
+
+    int64_t t0 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        uint32_t intensity = intensity_src;
+        for (size_t i = 0; i < sizeof(s_pixels); i++) {
+            s_out[i] = (uint8_t)((s_pixels[i] * intensity) / 255);
+        }
+        host_test_use(s_out);
+    }
+    int64_t t1 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        led_output_lut(lut, intensity_src, 255, true);
+        host_test_use(lut);
+    }
+    int64_t t2 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < sizeof(s_pixels); i++) {
+            s_out[i] = lut[s_pixels[i]];
+        }
+        host_test_use(s_out);
+    }
+    int64_t t3 = host_test_now_ns();
+
+    printf("%d LEDs x %ld: divide %.2f us/frame, table %.2f us/frame, "
+           "table rebuild %.2f us (per intensity change)\n",
+           LED_COUNT, iterations, (t1 - t0) / 1e3 / iterations,
+           (t3 - t2) / 1e3 / iterations, (t2 - t1) / 1e3 / iterations);
+
+    return HOST_TEST_RESULT();
+}
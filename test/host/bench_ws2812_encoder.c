@@ -0,0 +1,106 @@
+/**
+ * @file bench_ws2812_encoder.c
+ * @brief Encode cost per LED: table-driven encoder vs. the old per-bit loop
+ *
+ * The per-bit loop is the one ws2812_refresh() used before ws2812_encoder:
+ * one branch and a tick conversion per bit, written through rmt_item32_t
+ * bitfields. Both must produce the same waveform.
+ */
+
+#include "host_test.h"
+#include "ws2812_encoder.h"
+#include <string.h>
+
+#define LED_COUNT 1000
+#define BYTES (LED_COUNT * 3)
+
+/**
+ * @brief Same layout as rmt_item32_t
+ */
+typedef union {
+    struct {
+        uint32_t duration0 : 15;
+        uint32_t level0 : 1;
+        uint32_t duration1 : 15;
+        uint32_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_item32_t;
+
+static inline uint16_t ns_to_ticks(uint32_t ns)
+{
+    return (uint16_t)((ns + (WS2812_TICK_NS / 2)) / WS2812_TICK_NS);
+}
+
+static inline void ws2812_bit_to_rmt(uint8_t bit, rmt_item32_t *item)
+{
+    if (bit) {
+        item->level0 = 1;
+        item->duration0 = ns_to_ticks(WS2812_T1H_NS);
+        item->level1 = 0;
+        item->duration1 = ns_to_ticks(WS2812_T1L_NS);
+    } else {
+        item->level0 = 1;
+        item->duration0 = ns_to_ticks(WS2812_T0H_NS);
+        item->level1 = 0;
+        item->duration1 = ns_to_ticks(WS2812_T0L_NS);
+    }
+}
+
+static void encode_per_bit(const uint8_t *src, size_t len, rmt_item32_t *items)
+{
+    size_t item_index = 0;
+    for (size_t byte_index = 0; byte_index < len; byte_index++) {
+        uint8_t byte = src[byte_index];
+        for (int bit = 7; bit >= 0; bit--) {
+            ws2812_bit_to_rmt((byte >> bit) & 1, &items[item_index++]);
+        }
+    }
+}
+
+static uint8_t s_pixels[BYTES];
+static rmt_item32_t s_old[BYTES * WS2812_SYMBOLS_PER_BYTE];
+static uint32_t s_new[BYTES * WS2812_SYMBOLS_PER_BYTE];
+
+int main(int argc, char **argv)
+{
+    long iterations = host_test_iterations(argc, argv, 200);
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < BYTES; i++) {
+        seed = seed * 1103515245 + 12345;
+        s_pixels[i] = (uint8_t)(seed >> 16);
+    }
+
+    ws2812_encoder_t enc;
+    ws2812_encoder_init_default(&enc);
+
+    // Same waveform, symbol for symbol
+    encode_per_bit(s_pixels, BYTES, s_old);
+    ws2812_encode(&enc, s_pixels, BYTES, s_new);
+    for (size_t i = 0; i < BYTES * WS2812_SYMBOLS_PER_BYTE; i++) {
+        if (s_old[i].val != s_new[i]) {
+            CHECK_EQ(s_old[i].val, s_new[i]);
+            break;
+        }
+    }
+
+    int64_t t0 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        encode_per_bit(s_pixels, BYTES, s_old);
+        host_test_use(s_old);
+    }
+    int64_t t1 = host_test_now_ns();
+    for (long n = 0; n < iterations; n++) {
+        ws2812_encode(&enc, s_pixels, BYTES, s_new);
+        host_test_use(s_new);
+    }
+    int64_t t2 = host_test_now_ns();
+
+    double per_bit = (double)(t1 - t0) / iterations / LED_COUNT;
+    double table = (double)(t2 - t1) / iterations / LED_COUNT;
+    printf("encode %d LEDs x %ld: per-bit %.2f ns/LED, table %.2f ns/LED (%.1fx)\n",
+           LED_COUNT, iterations, per_bit, table, per_bit / table);
+
+    return HOST_TEST_RESULT();
+}
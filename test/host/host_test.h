@@ -0,0 +1,87 @@
+/**
+ * @file host_test.h
+ * @brief Check and timing helpers for the host tests and benchmarks
+ *
+ * Header only, no framework: a failed CHECK prints its location and the
+ * test returns HOST_TEST_RESULT() as exit code, which is what ctest looks at.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static int host_test_failures = 0;
+
+/**
+ * @brief Record a failure if cond is false, keep going
+ */
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                           \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Compare two integers, printing both on failure
+ */
+#define CHECK_EQ(a, b)                                                      \
+    do {                                                                    \
+        long long check_a_ = (long long)(a);                                \
+        long long check_b_ = (long long)(b);                                \
+        if (check_a_ != check_b_) {                                         \
+            printf("%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n",     \
+                   __FILE__, __LINE__, #a, #b, check_a_, check_b_);         \
+            host_test_failures++;                                           \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Exit code of a test: 0 if all checks passed
+ */
+#define HOST_TEST_RESULT()                                                  \
+    (host_test_failures == 0                                                \
+         ? (printf("OK\n"), 0)                                              \
+         : (printf("%d check(s) failed\n", host_test_failures), 1))
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static inline int64_t host_test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Benchmark iterations: argv[1] if given, otherwise def
+ *
+ * ctest runs the benchmarks with the small default as a smoke test; pass a
+ * larger count for stable numbers.
+ */
+static inline long host_test_iterations(int argc, char **argv, long def)
+{
+    if (argc > 1) {
+        long n = strtol(argv[1], NULL, 10);
+        if (n > 0) {
+            return n;
+        }
+    }
+    return def;
+}
+
+/**
+ * @brief Keep the compiler from optimizing a result away
+ */
+static inline void host_test_use(const void *p)
+{
+    __asm__ volatile("" : : "r"(p) : "memory");
+}
+
+#endif // HOST_TEST_H
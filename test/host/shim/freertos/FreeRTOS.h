@@ -0,0 +1,18 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host shim: the FreeRTOS basics used by the tested modules
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+#endif // FREERTOS_H
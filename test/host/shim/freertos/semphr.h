@@ -0,0 +1,48 @@
+/**
+ * @file semphr.h
+ * @brief Host shim: binary semaphores for single-threaded tests
+ *
+ * A take on an empty semaphore fails at once instead of waiting, which is
+ * what a timeout looks like to the caller.
+ */
+
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct {
+    int count;
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf)
+{
+    buf->count = 0;
+    return buf;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count != 0) {
+        return pdFALSE;
+    }
+    sem->count = 1;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count = 0;
+    return pdTRUE;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+}
+
+#endif // SEMPHR_H
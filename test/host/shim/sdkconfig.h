@@ -0,0 +1,6 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host shim: build as the IDF linux target
+ */
+
+#define CONFIG_IDF_TARGET_LINUX 1
@@ -0,0 +1,128 @@
+/**
+ * @file test_led_command.c
+ * @brief Command queue: order, capacity and concurrent producers
+ */
+
+#include "host_test.h"
+#include "led_command.h"
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define PRODUCERS 3
+#define PER_PRODUCER 20000
+
+static led_command_queue_t s_queue;
+
+static void test_order_and_capacity(void)
+{
+    led_command_queue_init(&s_queue);
+
+    led_command_t cmd = { .type = LED_CMD_INTENSITY };
+    for (uint32_t i = 0; i < LED_COMMAND_QUEUE_LEN; i++) {
+        cmd.intensity = (uint8_t)i;
+        CHECK(led_command_push(&s_queue, &cmd));
+    }
+
+    // Full: rejected and counted
+    CHECK(!led_command_push(&s_queue, &cmd));
+    CHECK_EQ(atomic_load(&s_queue.dropped), 1);
+
+    led_command_t out;
+    for (uint32_t i = 0; i < LED_COMMAND_QUEUE_LEN; i++) {
+        CHECK(led_command_pop(&s_queue, &out));
+        CHECK_EQ(out.intensity, i);
+    }
+    CHECK(!led_command_pop(&s_queue, &out));
+
+    // Wraps around
+    for (uint32_t i = 0; i < LED_COMMAND_QUEUE_LEN * 3; i++) {
+        cmd.intensity = (uint8_t)i;
+        CHECK(led_command_push(&s_queue, &cmd));
+        CHECK(led_command_pop(&s_queue, &out));
+        CHECK_EQ(out.intensity, (uint8_t)i);
+    }
+}
+
+static void test_range_valid(void)
+{
+    CHECK(led_command_range_valid(0, LED_STRIP_LENGTH));
+    CHECK(led_command_range_valid(LED_STRIP_LENGTH - 1, 1));
+    CHECK(led_command_range_valid(LED_STRIP_LENGTH, 0));
+    CHECK(!led_command_range_valid(0, LED_STRIP_LENGTH + 1));
+    CHECK(!led_command_range_valid(LED_STRIP_LENGTH, 1));
+    CHECK(!led_command_range_valid(-1, 1));
+    CHECK(!led_command_range_valid(0, -1));
+
+    // Sums that overflow int must not wrap into the strip
+    CHECK(!led_command_range_valid(1, INT_MAX));
+    CHECK(!led_command_range_valid(INT_MAX, 1));
+    CHECK(!led_command_range_valid(INT_MAX, INT_MAX));
+    CHECK(!led_command_range_valid(INT_MIN, INT_MAX));
+    CHECK(!led_command_range_valid(65535, 1));
+}
+
+static void *producer(void *arg)
+{
+    uint16_t id = (uint16_t)(uintptr_t)arg;
+    led_command_t cmd = { .type = LED_CMD_RANGE };
+    cmd.range.start = id;
+
+    for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+        cmd.range.count = (uint16_t)i;
+        cmd.meta.at_us = i;
+        while (!led_command_push(&s_queue, &cmd)) {
+            // Full: let the consumer catch up
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_producers(void)
+{
+    led_command_queue_init(&s_queue);
+
+    pthread_t threads[PRODUCERS];
+    for (uintptr_t p = 0; p < PRODUCERS; p++) {
+        pthread_create(&threads[p], NULL, producer, (void *)p);
+    }
+
+    // Every command arrives once, whole, and in order per producer
+    int64_t next[PRODUCERS] = { 0 };
+    uint32_t received = 0;
+    int torn = 0;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        led_command_t cmd;
+        if (!led_command_pop(&s_queue, &cmd)) {
+            sched_yield();
+            continue;
+        }
+        received++;
+        uint16_t id = cmd.range.start;
+        if (id >= PRODUCERS || cmd.type != LED_CMD_RANGE ||
+            cmd.range.count != (uint16_t)cmd.meta.at_us) {
+            torn++;
+            continue;
+        }
+        CHECK_EQ(cmd.meta.at_us, next[id]);
+        next[id] = cmd.meta.at_us + 1;
+    }
+
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        CHECK_EQ(next[p], PER_PRODUCER);
+    }
+    CHECK_EQ(torn, 0);
+
+    led_command_t cmd;
+    CHECK(!led_command_pop(&s_queue, &cmd));
+}
+
+int main(void)
+{
+    test_order_and_capacity();
+    test_range_valid();
+    test_concurrent_producers();
+    return HOST_TEST_RESULT();
+}
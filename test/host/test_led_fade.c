@@ -0,0 +1,130 @@
+/**
+ * @file test_led_fade.c
+ * @brief Fade engine: easing endpoints, monotonic output, long durations
+ */
+
+#include "host_test.h"
+#include "led_fade.h"
+
+static const led_easing_t s_easings[] = {
+    LED_EASE_LINEAR, LED_EASE_IN, LED_EASE_OUT, LED_EASE_IN_OUT, LED_EASE_EXPO,
+};
+#define EASING_COUNT (sizeof(s_easings) / sizeof(s_easings[0]))
+
+static void test_easing_endpoints_and_monotonic(void)
+{
+    for (size_t e = 0; e < EASING_COUNT; e++) {
+        CHECK_EQ(led_ease(s_easings[e], 0), 0);
+        CHECK_EQ(led_ease(s_easings[e], LED_FADE_ONE), LED_FADE_ONE);
+        CHECK_EQ(led_ease(s_easings[e], LED_FADE_ONE + 1000), LED_FADE_ONE);
+
+        uint32_t prev = 0;
+        for (uint32_t t = 0; t <= LED_FADE_ONE; t += 7) {
+            uint32_t k = led_ease(s_easings[e], t);
+            CHECK(k >= prev && k <= LED_FADE_ONE);
+            prev = k;
+        }
+    }
+
+    // The quadratic curves meet in the middle
+    CHECK_EQ(led_ease(LED_EASE_IN_OUT, LED_FADE_ONE / 2), LED_FADE_ONE / 2);
+    CHECK(led_ease(LED_EASE_IN, LED_FADE_ONE / 2) < LED_FADE_ONE / 2);
+    CHECK(led_ease(LED_EASE_OUT, LED_FADE_ONE / 2) > LED_FADE_ONE / 2);
+}
+
+static void test_mix(void)
+{
+    led_rgb_t from = { 0, 255, 100 };
+    led_rgb_t to = { 255, 0, 100 };
+
+    led_rgb_t c = led_fade_mix(from, to, 0);
+    CHECK(c.r == 0 && c.g == 255 && c.b == 100);
+    c = led_fade_mix(from, to, LED_FADE_ONE);
+    CHECK(c.r == 255 && c.g == 0 && c.b == 100);
+    c = led_fade_mix(from, to, LED_FADE_ONE / 2);
+    CHECK(c.r == 128 && c.g == 128 && c.b == 100);
+}
+
+/**
+ * @brief Sample a fade from before its start to after its end
+ */
+static void check_fade(uint32_t duration_ms, led_easing_t easing)
+{
+    const int64_t start_us = 1000000;
+    const uint64_t duration_us = (uint64_t)duration_ms * 1000;
+    led_rgb_t from = { 0, 0, 0 };
+    led_rgb_t to = { 255, 255, 255 };
+    led_fade_t fade;
+    led_rgb_t c;
+
+    led_fade_start(&fade, from, to, duration_ms, easing, start_us);
+    CHECK_EQ(fade.duration_us, duration_us);
+
+    // Not started yet: start color
+    CHECK(!led_fade_sample(&fade, start_us - 10, &c));
+    CHECK_EQ(c.r, 0);
+    CHECK(!led_fade_sample(&fade, start_us, &c));
+    CHECK_EQ(c.r, 0);
+
+    // Rising and not done until the full duration has passed
+    uint8_t prev = 0;
+    for (int i = 1; i < 64; i++) {
+        int64_t now = start_us + (int64_t)(duration_us * i / 64);
+        CHECK(!led_fade_sample(&fade, now, &c));
+        CHECK(c.r >= prev);
+        prev = c.r;
+    }
+    CHECK(!led_fade_sample(&fade, start_us + (int64_t)duration_us - 1, &c));
+
+    CHECK(led_fade_sample(&fade, start_us + (int64_t)duration_us, &c));
+    CHECK_EQ(c.r, 255);
+    CHECK(led_fade_sample(&fade, start_us + (int64_t)duration_us * 2, &c));
+    CHECK_EQ(c.r, 255);
+
+    // Linear: half way is half way
+    if (easing == LED_EASE_LINEAR) {
+        led_fade_sample(&fade, start_us + (int64_t)(duration_us / 2), &c);
+        CHECK(c.r >= 127 && c.r <= 128);
+    }
+}
+
+static void test_fades(void)
+{
+    for (size_t e = 0; e < EASING_COUNT; e++) {
+        check_fade(1000, s_easings[e]);
+    }
+
+    // Longer than 2^32 us (71.6 min): 2 h, 30 days and the largest duration
+    check_fade(2 * 3600 * 1000, LED_EASE_LINEAR);
+    check_fade(30u * 24 * 3600 * 1000, LED_EASE_LINEAR);
+    check_fade(UINT32_MAX, LED_EASE_LINEAR);
+    check_fade(UINT32_MAX, LED_EASE_EXPO);
+
+    // Zero duration jumps to the target
+    led_fade_t fade;
+    led_rgb_t c;
+    led_rgb_t from = { 1, 2, 3 };
+    led_rgb_t to = { 4, 5, 6 };
+    led_fade_start(&fade, from, to, 0, LED_EASE_LINEAR, 0);
+    CHECK(led_fade_sample(&fade, 0, &c));
+    CHECK_EQ(c.b, 6);
+}
+
+static void test_easing_names(void)
+{
+    led_easing_t easing = LED_EASE_LINEAR;
+    CHECK(led_easing_from_name("Ease-In-Out", &easing));
+    CHECK_EQ(easing, LED_EASE_IN_OUT);
+    CHECK(led_easing_from_name("exp", &easing));
+    CHECK_EQ(easing, LED_EASE_EXPO);
+    CHECK(!led_easing_from_name("bounce", &easing));
+}
+
+int main(void)
+{
+    test_easing_endpoints_and_monotonic();
+    test_mix();
+    test_fades();
+    test_easing_names();
+    return HOST_TEST_RESULT();
+}
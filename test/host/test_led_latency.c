@@ -0,0 +1,76 @@
+/**
+ * @file test_led_latency.c
+ * @brief Latency histograms: percentiles within one bucket of the truth
+ */
+
+#include "host_test.h"
+#include "led_latency.h"
+#include <string.h>
+
+static void test_empty(void)
+{
+    led_latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+
+    led_latency_summary_t summary;
+    led_latency_summarize(&hist, &summary);
+    CHECK_EQ(summary.samples, 0);
+    CHECK_EQ(summary.p50_us, 0);
+    CHECK_EQ(summary.p99_us, 0);
+}
+
+static void test_small_values_exact(void)
+{
+    led_latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+
+    for (uint32_t us = 0; us < 4; us++) {
+        led_latency_record(&hist, us);
+    }
+    CHECK_EQ(led_latency_percentile(&hist, 25), 0);
+    CHECK_EQ(led_latency_percentile(&hist, 50), 1);
+    CHECK_EQ(led_latency_percentile(&hist, 100), 3);
+}
+
+static void test_percentiles(void)
+{
+    led_latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+
+    // 1..10000 us, once each
+    for (uint32_t us = 1; us <= 10000; us++) {
+        led_latency_record(&hist, us);
+    }
+
+    led_latency_summary_t summary;
+    led_latency_summarize(&hist, &summary);
+    CHECK_EQ(summary.samples, 10000);
+    CHECK_EQ(summary.max_us, 10000);
+
+    // Upper bound of the bucket: never below, at most 25 % above
+    CHECK(summary.p50_us >= 5000 && summary.p50_us <= 5000 * 5 / 4);
+    CHECK(summary.p99_us >= 9900 && summary.p99_us <= 10000);
+    CHECK_EQ(led_latency_percentile(&hist, 100), 10000);
+}
+
+static void test_saturates(void)
+{
+    led_latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+
+    led_latency_record(&hist, UINT32_MAX);
+    CHECK_EQ(hist.samples, 1);
+    CHECK_EQ(hist.buckets[LED_LATENCY_BUCKETS - 1], 1);
+    // Reported as the top of the range (33 s)
+    CHECK_EQ(led_latency_percentile(&hist, 50), (1u << 25) - 1);
+}
+
+int main(void)
+{
+    test_empty();
+    test_small_values_exact();
+    test_percentiles();
+    test_saturates();
+    CHECK(strcmp(led_latency_stage_name(LED_LATENCY_TOTAL), "total") == 0);
+    return HOST_TEST_RESULT();
+}
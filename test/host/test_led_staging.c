@@ -0,0 +1,221 @@
+/**
+ * @file test_led_staging.c
+ * @brief Staging frames: exactly the drawn LEDs, in commit order, never torn
+ *
+ * Built with LED_STAGING_LENGTH 40, so gaps between drawn LEDs exist.
+ */
+
+#include "host_test.h"
+#include "led_staging.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define LEDS LED_STAGING_LENGTH
+#define FRAMES 20000
+
+static led_staging_t s_staging;
+static led_rgb_t s_framebuffer[LEDS];
+
+static const led_rgb_t RED = { 255, 0, 0 };
+
+static void fill(led_rgb_t color)
+{
+    for (int i = 0; i < LEDS; i++) {
+        s_framebuffer[i] = color;
+    }
+}
+
+static void draw(uint32_t led, uint8_t value)
+{
+    led_rgb_t *pixels = led_staging_buffer(&s_staging);
+    pixels[led].r = pixels[led].g = pixels[led].b = value;
+    led_staging_mark(&s_staging, led, led + 1);
+}
+
+static uint32_t publish(void)
+{
+    uint32_t frame = 0;
+    CHECK(led_staging_publish(&s_staging, &frame));
+    return frame;
+}
+
+static bool is_red(int led)
+{
+    return s_framebuffer[led].r == 255 && s_framebuffer[led].g == 0 && s_framebuffer[led].b == 0;
+}
+
+static void test_nothing_drawn(void)
+{
+    led_staging_init(&s_staging);
+    fill(RED);
+
+    CHECK_EQ(publish(), 0);
+    CHECK_EQ(led_staging_apply(&s_staging, 0, s_framebuffer), 0);
+    draw(3, 1);
+    CHECK_EQ(led_staging_apply(&s_staging, 1, s_framebuffer), 0);
+    CHECK(is_red(3));
+}
+
+static void test_gap_keeps_framebuffer(void)
+{
+    led_staging_init(&s_staging);
+    fill(RED);
+
+    // set_pixels(0), set_pixels(9) before the LED task runs
+    draw(0, 10);
+    uint32_t first = publish();
+    draw(9, 20);
+    uint32_t second = publish();
+    CHECK_EQ(led_staging_apply(&s_staging, first, s_framebuffer), 1);
+    CHECK_EQ(led_staging_apply(&s_staging, second, s_framebuffer), 1);
+
+    CHECK_EQ(s_framebuffer[0].r, 10);
+    CHECK_EQ(s_framebuffer[9].r, 20);
+    for (int i = 1; i < LEDS; i++) {
+        if (i != 9) {
+            CHECK(is_red(i));
+        }
+    }
+
+    // Runs across word boundaries
+    fill(RED);
+    led_rgb_t *pixels = led_staging_buffer(&s_staging);
+    memset(pixels, 7, LEDS * sizeof(led_rgb_t));
+    led_staging_mark(&s_staging, 5, 37);
+    CHECK_EQ(led_staging_apply(&s_staging, publish(), s_framebuffer), 1);
+    for (int i = 0; i < LEDS; i++) {
+        CHECK(i >= 5 && i < 37 ? s_framebuffer[i].g == 7 : is_red(i));
+    }
+}
+
+static void test_commands_between_commits(void)
+{
+    led_staging_init(&s_staging);
+    fill(RED);
+
+    // Queue order: set_pixels(0), set_color(red), set_pixels(9)
+    draw(0, 10);
+    uint32_t first = publish();
+    draw(9, 20);
+    uint32_t second = publish();
+
+    CHECK_EQ(led_staging_apply(&s_staging, first, s_framebuffer), 1);
+    CHECK_EQ(s_framebuffer[0].r, 10);
+    CHECK(is_red(9));
+    fill(RED);
+    CHECK_EQ(led_staging_apply(&s_staging, second, s_framebuffer), 1);
+    CHECK(is_red(0));
+    CHECK_EQ(s_framebuffer[9].r, 20);
+
+    // A commit that got lost: its frame goes first with the next one
+    draw(1, 30);
+    publish();
+    draw(1, 40);
+    draw(2, 50);
+    uint32_t fourth = publish();
+    CHECK_EQ(led_staging_apply(&s_staging, fourth, s_framebuffer), 2);
+    CHECK_EQ(s_framebuffer[1].r, 40);
+    CHECK_EQ(s_framebuffer[2].r, 50);
+    CHECK_EQ(led_staging_apply(&s_staging, fourth, s_framebuffer), 0);
+}
+
+static void test_full_and_partial(void)
+{
+    led_staging_init(&s_staging);
+    fill(RED);
+
+    uint32_t frame = 0;
+    for (int i = 0; i < LED_STAGING_FRAMES - 1; i++) {
+        draw((uint32_t)i, (uint8_t)(i + 1));
+        frame = publish();
+    }
+
+    // Every other slot waits: rejected, the drawing stays for the next one
+    draw(20, 99);
+    uint32_t rejected = 12345;
+    CHECK(!led_staging_publish(&s_staging, &rejected));
+    CHECK_EQ(rejected, 12345);
+
+    CHECK_EQ(led_staging_apply(&s_staging, frame, s_framebuffer), LED_STAGING_FRAMES - 1);
+    CHECK(is_red(20));
+    draw(21, 98);
+    CHECK_EQ(led_staging_apply(&s_staging, publish(), s_framebuffer), 1);
+    CHECK_EQ(s_framebuffer[20].r, 99);
+    CHECK_EQ(s_framebuffer[21].r, 98);
+
+    // One channel drawn: the rest of the pixel is what was drawn before
+    led_staging_buffer(&s_staging)[20].g = 5;
+    led_staging_mark(&s_staging, 20, 21);
+    CHECK_EQ(led_staging_apply(&s_staging, publish(), s_framebuffer), 1);
+    CHECK(s_framebuffer[20].r == 99 && s_framebuffer[20].g == 5 && s_framebuffer[20].b == 99);
+}
+
+static atomic_bool s_done;
+
+static void *producer(void *arg)
+{
+    for (uint32_t frame = 1; frame <= FRAMES; frame++) {
+        // Byte by byte, so a copy that overlaps the drawing shows up
+        uint8_t *bytes = (uint8_t *)led_staging_buffer(&s_staging);
+        for (size_t i = 0; i < LEDS * sizeof(led_rgb_t); i++) {
+            bytes[i] = (uint8_t)frame;
+            if ((i & 15) == 0) {
+                sched_yield();
+            }
+        }
+        led_staging_mark(&s_staging, 0, LEDS);
+
+        uint32_t published;
+        while (!led_staging_publish(&s_staging, &published)) {
+            // All slots wait: let the LED task catch up
+            sched_yield();
+        }
+        CHECK_EQ(published, frame);
+    }
+    atomic_store(&s_done, true);
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    led_staging_init(&s_staging);
+    atomic_store(&s_done, false);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, NULL);
+
+    // Every frame is applied whole and in order
+    uint32_t applied = 0;
+    int torn = 0;
+    for (;;) {
+        bool done = atomic_load(&s_done);
+        uint32_t n = led_staging_apply(&s_staging, applied + 1, s_framebuffer);
+        if (n > 0) {
+            CHECK_EQ(n, 1);
+            applied += n;
+            const uint8_t *bytes = (const uint8_t *)s_framebuffer;
+            for (size_t i = 0; i < LEDS * sizeof(led_rgb_t); i++) {
+                torn += bytes[i] != (uint8_t)applied;
+            }
+        } else if (done) {
+            break;
+        }
+        sched_yield();
+    }
+    pthread_join(thread, NULL);
+
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(applied, FRAMES);
+}
+
+int main(void)
+{
+    test_nothing_drawn();
+    test_gap_keeps_framebuffer();
+    test_commands_between_commits();
+    test_full_and_partial();
+    test_concurrent();
+    return HOST_TEST_RESULT();
+}
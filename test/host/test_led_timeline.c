@@ -0,0 +1,201 @@
+/**
+ * @file test_led_timeline.c
+ * @brief Timeline: sampling, loop wrap, player clock and validation
+ */
+
+#include "host_test.h"
+#include "led_timeline.h"
+
+#define MS(ms)      ((int64_t)(ms) * 1000)
+#define DAY_MS      (24LL * 3600 * 1000)
+
+static led_timeline_t s_timeline;
+
+#define CHECK_RGB(c, R, G, B) \
+    do { CHECK_EQ((c).r, (R)); CHECK_EQ((c).g, (G)); CHECK_EQ((c).b, (B)); } while (0)
+
+/**
+ * @brief Red, fade to blue at 1 s, step to green at 2 s, 3 s long
+ */
+static led_timeline_t *make_timeline(bool loop)
+{
+    led_timeline_t *t = &s_timeline;
+    *t = (led_timeline_t){
+        .keyframes = {
+            { .time_ms = 0, .color = { 255, 0, 0 }, .intensity = 255 },
+            { .time_ms = 1000, .color = { 0, 0, 255 }, .intensity = 255,
+              .easing = LED_EASE_LINEAR },
+            { .time_ms = 2000, .color = { 0, 255, 0 }, .intensity = 255, .step = true },
+        },
+        .count = 3,
+        .duration_ms = 3000,
+        .loop = loop,
+    };
+    return t;
+}
+
+static void test_sample(void)
+{
+    led_timeline_t *t = make_timeline(false);
+    led_rgb_t c;
+
+    CHECK(!led_timeline_sample(t, 0, &c));
+    CHECK_RGB(c, 255, 0, 0);
+    CHECK(!led_timeline_sample(t, 500, &c));
+    CHECK_RGB(c, 128, 0, 128);
+    CHECK(!led_timeline_sample(t, 1000, &c));
+    CHECK_RGB(c, 0, 0, 255);
+
+    // Step: the previous color holds until the keyframe
+    CHECK(!led_timeline_sample(t, 1999, &c));
+    CHECK_RGB(c, 0, 0, 255);
+    CHECK(!led_timeline_sample(t, 2000, &c));
+    CHECK_RGB(c, 0, 255, 0);
+
+    // The last color holds until the end, then the timeline is finished
+    CHECK(!led_timeline_sample(t, 2999, &c));
+    CHECK_RGB(c, 0, 255, 0);
+    CHECK(led_timeline_sample(t, 3000, &c));
+    CHECK_RGB(c, 0, 255, 0);
+    CHECK(led_timeline_sample(t, UINT32_MAX, &c));
+    CHECK_RGB(c, 0, 255, 0);
+
+    // Before the first keyframe its color holds
+    t->keyframes[0].time_ms = 400;
+    CHECK(!led_timeline_sample(t, 0, &c));
+    CHECK_RGB(c, 255, 0, 0);
+}
+
+static void test_ease_and_intensity(void)
+{
+    led_timeline_t *t = make_timeline(false);
+    led_rgb_t linear;
+    led_rgb_t eased;
+
+    led_timeline_sample(t, 500, &linear);
+    t->keyframes[1].easing = LED_EASE_IN;
+    led_timeline_sample(t, 500, &eased);
+    CHECK(eased.b < linear.b);
+    CHECK(eased.r > linear.r);
+
+    // Intensity fades along with the color
+    t = make_timeline(false);
+    t->keyframes[0].color = (led_rgb_t){ 255, 255, 255 };
+    t->keyframes[0].intensity = 0;
+    t->keyframes[1].color = (led_rgb_t){ 255, 255, 255 };
+    led_rgb_t c;
+    led_timeline_sample(t, 0, &c);
+    CHECK_RGB(c, 0, 0, 0);
+    led_timeline_sample(t, 500, &c);
+    CHECK(c.r >= 127 && c.r <= 128);
+    led_timeline_sample(t, 1000, &c);
+    CHECK_RGB(c, 255, 255, 255);
+}
+
+static void test_loop(void)
+{
+    led_timeline_t *t = make_timeline(true);
+    led_rgb_t c;
+
+    CHECK(!led_timeline_sample(t, 3000, &c));
+    CHECK_RGB(c, 255, 0, 0);
+    CHECK(!led_timeline_sample(t, 3500, &c));
+    CHECK_RGB(c, 128, 0, 128);
+    CHECK(!led_timeline_sample(t, 2 * 3000 + 2000, &c));
+    CHECK_RGB(c, 0, 255, 0);
+}
+
+static void test_clock(void)
+{
+    led_timeline_t *t = make_timeline(false);
+    led_timeline_clock_t clock;
+    const int64_t t0 = MS(5000);
+
+    led_timeline_play(&clock, t, t0);
+    CHECK_EQ(led_timeline_position(&clock, t0), 0);
+    CHECK_EQ(led_timeline_position(&clock, t0 - MS(10)), 0);
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(1500)), 1500);
+
+    // Paused the position stands still, then continues from there
+    led_timeline_pause(&clock, t0 + MS(2000));
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(10000)), 2000);
+    led_timeline_resume(&clock, t0 + MS(10000));
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(10500)), 2500);
+
+    // Seek while playing keeps playing, while paused stays paused
+    led_timeline_seek(&clock, 100, t0 + MS(11000));
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(11200)), 300);
+    led_timeline_pause(&clock, t0 + MS(11200));
+    led_timeline_seek(&clock, 50, t0 + MS(12000));
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(13000)), 50);
+    led_timeline_resume(&clock, t0 + MS(13000));
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(13100)), 150);
+
+    // Play starts over
+    led_timeline_play(&clock, t, t0 + MS(20000));
+    CHECK(!clock.paused);
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(20001)), 1);
+
+    // Without loop the position saturates
+    CHECK_EQ(led_timeline_position(&clock, t0 + MS(20000) + MS(60 * DAY_MS)), UINT32_MAX);
+}
+
+static void test_loop_clock(void)
+{
+    led_timeline_t *t = make_timeline(true);
+    led_timeline_clock_t clock;
+    led_rgb_t c;
+
+    led_timeline_play(&clock, t, 0);
+    CHECK_EQ(led_timeline_position(&clock, MS(3500)), 500);
+
+    // Past 2^32 ms (49.7 days) the loop keeps running instead of freezing
+    int64_t now = MS(60 * DAY_MS + 500);
+    CHECK_EQ(led_timeline_position(&clock, now), (60 * DAY_MS + 500) % 3000);
+    t->duration_ms = 1000;
+    t->count = 2;
+    led_timeline_play(&clock, t, 0);
+    CHECK_EQ(led_timeline_position(&clock, MS(50 * DAY_MS + 250)), 250);
+    CHECK_EQ(led_timeline_position(&clock, MS(50 * DAY_MS + 750)), 750);
+    led_timeline_sample(t, led_timeline_position(&clock, MS(50 * DAY_MS + 500)), &c);
+    CHECK_RGB(c, 128, 0, 128);
+
+    // Pausing there and seeking past the end stay within the loop
+    led_timeline_pause(&clock, MS(50 * DAY_MS + 250));
+    CHECK_EQ(led_timeline_position(&clock, MS(51 * DAY_MS)), 250);
+    led_timeline_seek(&clock, 4600, MS(51 * DAY_MS));
+    CHECK_EQ(led_timeline_position(&clock, MS(51 * DAY_MS)), 600);
+}
+
+static void test_is_valid(void)
+{
+    led_timeline_t *t = make_timeline(false);
+    CHECK(led_timeline_is_valid(t));
+
+    t->duration_ms = 2000;
+    CHECK(led_timeline_is_valid(t));
+    t->duration_ms = 1999;
+    CHECK(!led_timeline_is_valid(t));
+
+    t = make_timeline(false);
+    t->keyframes[2].time_ms = 999;
+    CHECK(!led_timeline_is_valid(t));
+    t->keyframes[2].time_ms = 1000;
+    CHECK(led_timeline_is_valid(t));
+
+    t->count = 0;
+    CHECK(!led_timeline_is_valid(t));
+    t->count = LED_TIMELINE_MAX_KEYFRAMES + 1;
+    CHECK(!led_timeline_is_valid(t));
+}
+
+int main(void)
+{
+    test_sample();
+    test_ease_and_intensity();
+    test_loop();
+    test_clock();
+    test_loop_clock();
+    test_is_valid();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,343 @@
+/**
+ * @file test_realtime_protocol.c
+ * @brief DDP and E1.31 parsing and sequence tracking, also over loopback UDP
+ */
+
+#include "host_test.h"
+#include "realtime_protocol.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define MAX_PACKET 1500
+
+/**
+ * @brief Build a DDP RGB packet for the display
+ */
+static size_t build_ddp(uint8_t *buf, uint8_t flags, uint8_t sequence, uint32_t offset,
+                        const uint8_t *data, uint16_t len)
+{
+    buf[0] = DDP_FLAG_VER1 | flags;
+    buf[1] = sequence;
+    buf[2] = DDP_TYPE_RGB24;
+    buf[3] = DDP_ID_DISPLAY;
+    buf[4] = (uint8_t)(offset >> 24);
+    buf[5] = (uint8_t)(offset >> 16);
+    buf[6] = (uint8_t)(offset >> 8);
+    buf[7] = (uint8_t)offset;
+    buf[8] = (uint8_t)(len >> 8);
+    buf[9] = (uint8_t)len;
+    size_t header_len = DDP_HEADER_LEN;
+    if (flags & DDP_FLAG_TIMECODE) {
+        memset(&buf[DDP_HEADER_LEN], 0xEE, DDP_TIMECODE_LEN);
+        header_len += DDP_TIMECODE_LEN;
+    }
+    memcpy(&buf[header_len], data, len);
+    return header_len + len;
+}
+
+/**
+ * @brief Build an E1.31 data packet with start code 0
+ */
+static size_t build_e131(uint8_t *buf, uint16_t universe, uint8_t sequence,
+                         const uint8_t *data, uint16_t channels)
+{
+    static const uint8_t acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+    memset(buf, 0, E131_DATA_OFFSET);
+    buf[1] = 0x10;                          // Preamble size
+    memcpy(&buf[4], acn_id, sizeof(acn_id));
+    buf[21] = 0x04;                         // Root vector: data
+    buf[43] = 0x02;                         // Framing vector: DMP
+    memcpy(&buf[44], "host test", 9);       // Source name
+    buf[108] = 100;                         // Priority
+    buf[111] = sequence;
+    buf[113] = (uint8_t)(universe >> 8);
+    buf[114] = (uint8_t)universe;
+    buf[117] = 0x02;                        // DMP vector: set property
+    buf[118] = 0xA1;                        // Address and data type
+    buf[122] = 1;                           // Address increment
+    buf[123] = (uint8_t)((channels + 1) >> 8);
+    buf[124] = (uint8_t)(channels + 1);
+    buf[125] = 0;                           // Start code: DMX levels
+    memcpy(&buf[E131_DATA_OFFSET], data, channels);
+    return E131_DATA_OFFSET + channels;
+}
+
+static void test_ddp_parse(void)
+{
+    uint8_t buf[MAX_PACKET];
+    uint8_t rgb[30];
+    ddp_packet_t pkt;
+
+    for (size_t i = 0; i < sizeof(rgb); i++) {
+        rgb[i] = (uint8_t)i;
+    }
+
+    size_t len = build_ddp(buf, DDP_FLAG_PUSH, 7, 300, rgb, sizeof(rgb));
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_OK);
+    CHECK_EQ(pkt.sequence, 7);
+    CHECK_EQ(pkt.offset, 300);
+    CHECK_EQ(pkt.length, sizeof(rgb));
+    CHECK(pkt.flags & DDP_FLAG_PUSH);
+    CHECK(memcmp(pkt.data, rgb, sizeof(rgb)) == 0);
+
+    // Timecode: data starts 4 bytes later
+    len = build_ddp(buf, DDP_FLAG_TIMECODE, 1, 0, rgb, sizeof(rgb));
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_OK);
+    CHECK(memcmp(pkt.data, rgb, sizeof(rgb)) == 0);
+
+    // Truncated header or data
+    len = build_ddp(buf, 0, 1, 0, rgb, sizeof(rgb));
+    CHECK_EQ(ddp_parse(buf, DDP_HEADER_LEN - 1, &pkt), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(ddp_parse(buf, len - 1, &pkt), ESP_ERR_INVALID_SIZE);
+
+    // Other protocol version
+    buf[0] = 0x80;
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_ERR_INVALID_VERSION);
+
+    // Valid, but no pixel data for the display
+    build_ddp(buf, DDP_FLAG_QUERY, 1, 0, rgb, sizeof(rgb));
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+    build_ddp(buf, DDP_FLAG_STORAGE, 1, 0, rgb, sizeof(rgb));
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+    build_ddp(buf, 0, 1, 0, rgb, sizeof(rgb));
+    buf[3] = 2;                             // Other output
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+    build_ddp(buf, 0, 1, 0, rgb, sizeof(rgb));
+    buf[2] = 0x1B;                          // RGB, 16 bits per channel
+    CHECK_EQ(ddp_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+}
+
+static void test_e131_parse(void)
+{
+    uint8_t buf[MAX_PACKET];
+    uint8_t dmx[E131_MAX_CHANNELS];
+    e131_packet_t pkt;
+
+    for (size_t i = 0; i < sizeof(dmx); i++) {
+        dmx[i] = (uint8_t)(i * 3);
+    }
+
+    size_t len = build_e131(buf, 2, 42, dmx, E131_MAX_CHANNELS);
+    CHECK_EQ(e131_parse(buf, len, &pkt), ESP_OK);
+    CHECK_EQ(pkt.universe, 2);
+    CHECK_EQ(pkt.sequence, 42);
+    CHECK_EQ(pkt.priority, 100);
+    CHECK_EQ(pkt.options, 0);
+    CHECK_EQ(pkt.channel_count, E131_MAX_CHANNELS);
+    CHECK(memcmp(pkt.data, dmx, E131_MAX_CHANNELS) == 0);
+
+    // Fewer channels than a full universe
+    len = build_e131(buf, 1, 0, dmx, 3);
+    CHECK_EQ(e131_parse(buf, len, &pkt), ESP_OK);
+    CHECK_EQ(pkt.channel_count, 3);
+
+    // Shorter than announced, shorter than the header, too many channels
+    CHECK_EQ(e131_parse(buf, len - 1, &pkt), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(e131_parse(buf, E131_DATA_OFFSET - 1, &pkt), ESP_ERR_INVALID_SIZE);
+    len = build_e131(buf, 1, 0, dmx, E131_MAX_CHANNELS);
+    buf[124]++;
+    CHECK_EQ(e131_parse(buf, len + 1, &pkt), ESP_ERR_INVALID_SIZE);
+
+    // Not an ACN packet
+    build_e131(buf, 1, 0, dmx, 3);
+    buf[4] = 'X';
+    CHECK_EQ(e131_parse(buf, len, &pkt), ESP_ERR_INVALID_RESPONSE);
+
+    // Synchronization packet, per-channel priority (start code 0xDD)
+    len = build_e131(buf, 1, 0, dmx, 3);
+    buf[21] = 0x08;
+    CHECK_EQ(e131_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+    build_e131(buf, 1, 0, dmx, 3);
+    buf[125] = 0xDD;
+    CHECK_EQ(e131_parse(buf, len, &pkt), ESP_ERR_NOT_SUPPORTED);
+}
+
+static void test_ddp_sequence(void)
+{
+    realtime_seq_t seq = { 0 };
+
+    // In order, unnumbered, wrap from 15 to 1
+    CHECK_EQ(realtime_seq_ddp(&seq, 14), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 15), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 0), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), 0);
+
+    // Gaps, also across the wrap
+    CHECK_EQ(realtime_seq_ddp(&seq, 4), 2);
+    CHECK_EQ(realtime_seq_ddp(&seq, 11), 6);
+    CHECK_EQ(realtime_seq_ddp(&seq, 2), 5);
+
+    // Repeated packet
+    CHECK_EQ(realtime_seq_ddp(&seq, 2), -1);
+
+    // One packet late: 4 arrives after 5. It is not 13 lost packets, and
+    // the stream goes on from 5.
+    CHECK_EQ(realtime_seq_ddp(&seq, 3), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 5), 1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 4), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 6), 0);
+
+    // Late across the wrap: 15 after 1
+    CHECK_EQ(realtime_seq_ddp(&seq, 13), 6);
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), 2);
+    CHECK_EQ(realtime_seq_ddp(&seq, 15), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 2), 0);
+}
+
+static void test_ddp_sequence_burst_loss(void)
+{
+    realtime_seq_t seq = { 0 };
+
+    // 10 packets lost after 1: 12, 13, 14 all look late. The third one
+    // restarts the count, and the stream is accepted from there on.
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 12), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 13), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 14), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 15), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), 0);
+
+    // An accepted packet in between clears the reject count
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 1), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 2), 0);
+    CHECK_EQ(realtime_seq_ddp(&seq, 2), -1);
+    CHECK_EQ(realtime_seq_ddp(&seq, 3), 0);
+}
+
+static void test_e131_sequence(void)
+{
+    realtime_seq_t seq = { 0 };
+
+    CHECK_EQ(realtime_seq_e131(&seq, 250), 0);
+    CHECK_EQ(realtime_seq_e131(&seq, 251), 0);
+    CHECK_EQ(realtime_seq_e131(&seq, 255), 3);
+    CHECK_EQ(realtime_seq_e131(&seq, 1), 1);
+
+    // Repeated and late by up to 19: ignored, the stream goes on
+    CHECK_EQ(realtime_seq_e131(&seq, 1), -1);
+    CHECK_EQ(realtime_seq_e131(&seq, 0), -1);
+    CHECK_EQ(realtime_seq_e131(&seq, 238), -1);
+    CHECK_EQ(realtime_seq_e131(&seq, 2), 0);
+
+    // 20 or more behind: the source restarted, accepted
+    CHECK_EQ(realtime_seq_e131(&seq, 238), 0);
+    CHECK_EQ(realtime_seq_e131(&seq, 239), 0);
+}
+
+/**
+ * @brief Open a UDP socket on 127.0.0.1 with a free port
+ */
+static int open_loopback(struct sockaddr_in *addr)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK(sock >= 0);
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr->sin_port = 0;
+    CHECK_EQ(bind(sock, (struct sockaddr *)addr, sizeof(*addr)), 0);
+
+    socklen_t addr_len = sizeof(*addr);
+    CHECK_EQ(getsockname(sock, (struct sockaddr *)addr, &addr_len), 0);
+
+    struct timeval timeout = { .tv_sec = 1 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return sock;
+}
+
+static void test_loopback(void)
+{
+    struct sockaddr_in addr;
+    int rx = open_loopback(&addr);
+    int tx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK(rx >= 0 && tx >= 0);
+
+    uint8_t buf[MAX_PACKET];
+    uint8_t rgb[480 * 3];
+    for (size_t i = 0; i < sizeof(rgb); i++) {
+        rgb[i] = (uint8_t)(i * 7);
+    }
+
+    // One DDP frame in three packets, the last two swapped on the way and a
+    // repeated first packet; then the next frame
+    static const struct { uint8_t seq; uint8_t part; } sends[] = {
+        { 1, 0 }, { 3, 2 }, { 2, 1 }, { 1, 0 }, { 4, 0 },
+    };
+    const uint16_t part_len = sizeof(rgb) / 3;
+    for (size_t i = 0; i < sizeof(sends) / sizeof(sends[0]); i++) {
+        uint32_t offset = sends[i].part * part_len;
+        uint8_t flags = sends[i].part == 2 ? DDP_FLAG_PUSH : 0;
+        size_t len = build_ddp(buf, flags, sends[i].seq, offset, &rgb[offset], part_len);
+        CHECK_EQ(sendto(tx, buf, len, 0, (struct sockaddr *)&addr, sizeof(addr)), (ssize_t)len);
+    }
+
+    realtime_seq_t seq = { 0 };
+    uint8_t frame[sizeof(rgb)];
+    int lost = 0, late = 0, pushed = 0;
+    memset(frame, 0, sizeof(frame));
+    for (size_t i = 0; i < sizeof(sends) / sizeof(sends[0]); i++) {
+        ssize_t len = recv(rx, buf, sizeof(buf), 0);
+        CHECK(len > 0);
+        if (len <= 0) {
+            break;
+        }
+
+        ddp_packet_t pkt;
+        CHECK_EQ(ddp_parse(buf, (size_t)len, &pkt), ESP_OK);
+        int n = realtime_seq_ddp(&seq, pkt.sequence);
+        if (n < 0) {
+            late++;
+            continue;
+        }
+        lost += n;
+        memcpy(&frame[pkt.offset], pkt.data, pkt.length);
+        pushed += (pkt.flags & DDP_FLAG_PUSH) != 0;
+    }
+    CHECK_EQ(lost, 1);
+    CHECK_EQ(late, 2);
+    CHECK_EQ(pushed, 1);
+    CHECK(memcmp(frame, rgb, part_len) == 0);
+    CHECK(memcmp(&frame[2 * part_len], &rgb[2 * part_len], part_len) == 0);
+
+    // E1.31: two universes of one frame
+    realtime_seq_t useq[2] = { 0 };
+    for (uint16_t u = 1; u <= 2; u++) {
+        size_t len = build_e131(buf, u, 10, &rgb[(u - 1) * 510], 510);
+        CHECK_EQ(sendto(tx, buf, len, 0, (struct sockaddr *)&addr, sizeof(addr)), (ssize_t)len);
+    }
+    for (int i = 0; i < 2; i++) {
+        ssize_t len = recv(rx, buf, sizeof(buf), 0);
+        CHECK(len > 0);
+        if (len <= 0) {
+            break;
+        }
+
+        e131_packet_t pkt;
+        CHECK_EQ(e131_parse(buf, (size_t)len, &pkt), ESP_OK);
+        CHECK(pkt.universe == 1 || pkt.universe == 2);
+        CHECK_EQ(realtime_seq_e131(&useq[pkt.universe - 1], pkt.sequence), 0);
+        CHECK_EQ(pkt.channel_count, 510);
+        CHECK(memcmp(pkt.data, &rgb[(pkt.universe - 1) * 510], 510) == 0);
+    }
+
+    close(tx);
+    close(rx);
+}
+
+int main(void)
+{
+    test_ddp_parse();
+    test_e131_parse();
+    test_ddp_sequence();
+    test_ddp_sequence_burst_loss();
+    test_e131_sequence();
+    test_loopback();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,162 @@
+/**
+ * @file test_ws2812_capture.c
+ * @brief Strip core through the capture backend: what is set is what goes out
+ */
+
+#include "host_test.h"
+#include "ws2812_rmt.h"
+#include "ws2812_capture.h"
+#include "ws2812_encoder.h"
+#include <string.h>
+
+#define LEDS 16
+
+/**
+ * @brief Decode the latest frame of a WS2812B strip to wire-order bytes
+ */
+static esp_err_t decode_latest(ws2812_handle_t strip, uint8_t *bytes, size_t len)
+{
+    ws2812_capture_frame_t frame;
+    esp_err_t ret = ws2812_capture_get_frame(strip, 0, &frame);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return ws2812_capture_decode(frame.symbols, frame.symbol_count, bytes, len);
+}
+
+static void test_frames_match_pixels(void)
+{
+    ws2812_handle_t strip = ws2812_init_with_backend(&ws2812_capture_backend, 0, LEDS, 0, NULL);
+    CHECK(strip != NULL);
+
+    for (uint16_t i = 0; i < LEDS; i++) {
+        ws2812_set_pixel(strip, i, (uint8_t)i, (uint8_t)(i * 2), (uint8_t)(255 - i));
+    }
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_frame_count(strip), 1);
+
+    // WS2812B sends GRB
+    uint8_t bytes[LEDS * 3];
+    CHECK_EQ(decode_latest(strip, bytes, sizeof(bytes)), ESP_OK);
+    for (uint16_t i = 0; i < LEDS; i++) {
+        CHECK_EQ(bytes[i * 3 + 0], i * 2);
+        CHECK_EQ(bytes[i * 3 + 1], i);
+        CHECK_EQ(bytes[i * 3 + 2], 255 - i);
+    }
+
+    // Frame length: 24 bits of 1.15 us (0) to 1.3 us (1) per LED plus the latch
+    ws2812_capture_frame_t frame;
+    CHECK_EQ(ws2812_capture_get_frame(strip, 0, &frame), ESP_OK);
+    CHECK_EQ(frame.sequence, 1);
+    CHECK(frame.duration_us >= LEDS * 24 * 115 / 100 + WS2812_RESET_US);
+    CHECK(frame.duration_us <= LEDS * 24 * 130 / 100 + WS2812_RESET_US);
+
+    // Unchanged: nothing is sent
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_frame_count(strip), 1);
+
+    // One pixel changed: the next frame carries it and keeps the rest
+    ws2812_set_pixel(strip, 5, 1, 2, 3);
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_frame_count(strip), 2);
+    CHECK_EQ(decode_latest(strip, bytes, sizeof(bytes)), ESP_OK);
+    CHECK_EQ(bytes[5 * 3 + 0], 2);
+    CHECK_EQ(bytes[5 * 3 + 1], 1);
+    CHECK_EQ(bytes[5 * 3 + 2], 3);
+    CHECK_EQ(bytes[6 * 3 + 1], 6);
+
+    // The previous frame is still in the history
+    uint8_t r, g, b;
+    CHECK_EQ(ws2812_capture_get_frame(strip, 1, &frame), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_pixel(&frame, 5, &r, &g, &b, NULL), ESP_OK);
+    CHECK_EQ(r, 5);
+
+    ws2812_stats_t stats;
+    CHECK_EQ(ws2812_get_stats(strip, &stats), ESP_OK);
+    CHECK_EQ(stats.frames_sent, 2);
+    CHECK_EQ(stats.frames_skipped, 1);
+
+    ws2812_deinit(strip);
+}
+
+static void test_rgbw_format(void)
+{
+    ws2812_handle_t strip = ws2812_init_with_backend(&ws2812_capture_backend, 0, LEDS, 0,
+                                                     &ws2812_format_sk6812_rgbw);
+    CHECK(strip != NULL);
+
+    // The common part of r, g, b goes to the white channel
+    ws2812_fill(strip, 40, 50, 60);
+    ws2812_set_pixel_rgbw(strip, 3, 1, 2, 3, 4);
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+
+    ws2812_capture_frame_t frame;
+    uint8_t r, g, b, w;
+    CHECK_EQ(ws2812_capture_get_frame(strip, 0, &frame), ESP_OK);
+    CHECK_EQ(frame.symbol_count, LEDS * 4 * WS2812_SYMBOLS_PER_BYTE);
+    CHECK_EQ(ws2812_capture_get_pixel(&frame, 0, &r, &g, &b, &w), ESP_OK);
+    CHECK_EQ(r, 0);
+    CHECK_EQ(g, 10);
+    CHECK_EQ(b, 20);
+    CHECK_EQ(w, 40);
+    CHECK_EQ(ws2812_capture_get_pixel(&frame, 3, &r, &g, &b, &w), ESP_OK);
+    CHECK_EQ(r, 1);
+    CHECK_EQ(g, 2);
+    CHECK_EQ(b, 3);
+    CHECK_EQ(w, 4);
+
+    ws2812_deinit(strip);
+}
+
+static void test_parallel_refresh(void)
+{
+    ws2812_handle_t strips[2];
+    strips[0] = ws2812_init_with_backend(&ws2812_capture_backend, 0, LEDS, 0, NULL);
+    strips[1] = ws2812_init_with_backend(&ws2812_capture_backend, 1, LEDS, 1, NULL);
+    CHECK(strips[0] != NULL && strips[1] != NULL);
+
+    CHECK_EQ(ws2812_refresh_multi(strips, 2), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_frame_count(strips[0]), 1);
+    CHECK_EQ(ws2812_capture_get_frame_count(strips[1]), 1);
+
+    // Only the strip that changed is sent
+    ws2812_set_pixel(strips[1], 0, 255, 0, 0);
+    CHECK_EQ(ws2812_refresh_multi(strips, 2), ESP_OK);
+    CHECK_EQ(ws2812_capture_get_frame_count(strips[0]), 1);
+    CHECK_EQ(ws2812_capture_get_frame_count(strips[1]), 2);
+
+    uint8_t bytes[LEDS * 3];
+    CHECK_EQ(decode_latest(strips[1], bytes, sizeof(bytes)), ESP_OK);
+    CHECK_EQ(bytes[0], 0);
+    CHECK_EQ(bytes[1], 255);
+
+    ws2812_deinit(strips[0]);
+    ws2812_deinit(strips[1]);
+}
+
+static void test_decode_rejects_bad_symbols(void)
+{
+    uint32_t symbols[WS2812_SYMBOLS_PER_BYTE];
+    uint8_t byte;
+    ws2812_encoder_t enc;
+    ws2812_encoder_init_default(&enc);
+
+    const uint8_t value = 0xA5;
+    ws2812_encode(&enc, &value, 1, symbols);
+    CHECK_EQ(ws2812_capture_decode(symbols, WS2812_SYMBOLS_PER_BYTE, &byte, 1), ESP_OK);
+    CHECK_EQ(byte, 0xA5);
+
+    // High time between T0H and T1H is neither bit
+    symbols[3] = WS2812_SYMBOL(1, 21, 0, 28);
+    CHECK_EQ(ws2812_capture_decode(symbols, WS2812_SYMBOLS_PER_BYTE, &byte, 1),
+             ESP_ERR_INVALID_RESPONSE);
+}
+
+int main(void)
+{
+    test_frames_match_pixels();
+    test_rgbw_format();
+    test_parallel_refresh();
+    test_decode_rejects_bad_symbols();
+    return HOST_TEST_RESULT();
+}
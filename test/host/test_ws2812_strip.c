@@ -0,0 +1,171 @@
+/**
+ * @file test_ws2812_strip.c
+ * @brief Strip core error paths: a frame that is not sent is not lost
+ */
+
+#include "host_test.h"
+#include "ws2812_rmt.h"
+#include "ws2812_backend.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define LEDS 8
+
+/**
+ * @brief Backend that keeps the last frame sent and fails on request
+ */
+typedef struct {
+    ws2812_handle_t strip;
+    bool fail_prepare;
+    bool fail_start;
+    uint32_t sent;
+    uint8_t frame[LEDS * 3];
+} flaky_ctx_t;
+
+static flaky_ctx_t s_ctx[2];
+static int s_attached;
+
+static esp_err_t flaky_attach(ws2812_handle_t strip, const ws2812_backend_config_t *config,
+                              void **ctx)
+{
+    flaky_ctx_t *c = &s_ctx[s_attached++];
+    memset(c, 0, sizeof(*c));
+    c->strip = strip;
+    *ctx = c;
+    return ESP_OK;
+}
+
+static void flaky_detach(void *ctx)
+{
+}
+
+static esp_err_t flaky_prepare(void *ctx, const uint8_t *frame, size_t len,
+                               size_t dirty_start, size_t dirty_len)
+{
+    return ((flaky_ctx_t *)ctx)->fail_prepare ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t flaky_start(void *ctx, const uint8_t *frame, size_t len)
+{
+    flaky_ctx_t *c = (flaky_ctx_t *)ctx;
+    if (c->fail_start) {
+        return ESP_FAIL;
+    }
+    memcpy(c->frame, frame, len);
+    c->sent++;
+    ws2812_backend_frame_done(c->strip);
+    return ESP_OK;
+}
+
+static const ws2812_backend_t s_flaky_backend = {
+    .name = "flaky",
+    .attach = flaky_attach,
+    .detach = flaky_detach,
+    .prepare = flaky_prepare,
+    .start = flaky_start,
+};
+
+static ws2812_handle_t create(void)
+{
+    ws2812_handle_t strip = ws2812_init_with_backend(&s_flaky_backend, 0, LEDS, 0, NULL);
+    CHECK(strip != NULL);
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    return strip;
+}
+
+static uint32_t frames_sent(ws2812_handle_t strip)
+{
+    ws2812_stats_t stats;
+    ws2812_get_stats(strip, &stats);
+    return stats.frames_sent;
+}
+
+static void test_start_failure_keeps_changes(void)
+{
+    s_attached = 0;
+    ws2812_handle_t strip = create();
+    flaky_ctx_t *ctx = &s_ctx[0];
+
+    ws2812_set_pixel(strip, 2, 10, 20, 30);
+    ctx->fail_start = true;
+    CHECK(ws2812_refresh(strip) != ESP_OK);
+    CHECK_EQ(frames_sent(strip), 1);
+
+    // Nothing new drawn: the failed change still goes out
+    ctx->fail_start = false;
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    CHECK_EQ(ctx->sent, 2);
+    CHECK_EQ(frames_sent(strip), 2);
+    CHECK_EQ(ctx->frame[2 * 3 + 0], 20);
+    CHECK_EQ(ctx->frame[2 * 3 + 1], 10);
+    CHECK_EQ(ctx->frame[2 * 3 + 2], 30);
+
+    ws2812_deinit(strip);
+}
+
+static void test_prepare_failure_keeps_changes(void)
+{
+    s_attached = 0;
+    ws2812_handle_t strip = create();
+    flaky_ctx_t *ctx = &s_ctx[0];
+
+    ws2812_set_pixel(strip, 7, 1, 2, 3);
+    ctx->fail_prepare = true;
+    CHECK(ws2812_refresh(strip) != ESP_OK);
+
+    ctx->fail_prepare = false;
+    CHECK_EQ(ws2812_refresh(strip), ESP_OK);
+    CHECK_EQ(ctx->sent, 2);
+    CHECK_EQ(ctx->frame[7 * 3 + 1], 1);
+
+    ws2812_deinit(strip);
+}
+
+static void test_multi_failure_keeps_changes(void)
+{
+    s_attached = 0;
+    ws2812_handle_t strips[2];
+    strips[0] = ws2812_init_with_backend(&s_flaky_backend, 0, LEDS, 0, NULL);
+    strips[1] = ws2812_init_with_backend(&s_flaky_backend, 1, LEDS, 1, NULL);
+    CHECK_EQ(ws2812_refresh_multi(strips, 2), ESP_OK);
+
+    // The second strip fails to prepare after the first one was prepared
+    ws2812_set_pixel(strips[0], 0, 255, 0, 0);
+    ws2812_set_pixel(strips[1], 1, 0, 255, 0);
+    s_ctx[1].fail_prepare = true;
+    CHECK(ws2812_refresh_multi(strips, 2) != ESP_OK);
+    CHECK_EQ(s_ctx[0].sent, 1);
+    CHECK_EQ(frames_sent(strips[0]), 1);
+
+    // Both changes go out with the next refresh, and are drawn on further
+    s_ctx[1].fail_prepare = false;
+    ws2812_set_pixel(strips[0], 3, 0, 0, 9);
+    CHECK_EQ(ws2812_refresh_multi(strips, 2), ESP_OK);
+    CHECK_EQ(s_ctx[0].sent, 2);
+    CHECK_EQ(s_ctx[1].sent, 2);
+    CHECK_EQ(s_ctx[0].frame[0 * 3 + 1], 255);
+    CHECK_EQ(s_ctx[0].frame[3 * 3 + 2], 9);
+    CHECK_EQ(s_ctx[1].frame[1 * 3 + 0], 255);
+
+    // The second strip fails to start
+    ws2812_set_pixel(strips[1], 4, 0, 0, 77);
+    s_ctx[1].fail_start = true;
+    CHECK(ws2812_refresh_multi(strips, 2) != ESP_OK);
+    CHECK_EQ(frames_sent(strips[1]), 2);
+    s_ctx[1].fail_start = false;
+    CHECK_EQ(ws2812_refresh_multi(strips, 2), ESP_OK);
+    CHECK_EQ(s_ctx[0].sent, 2);
+    CHECK_EQ(s_ctx[1].sent, 3);
+    CHECK_EQ(s_ctx[1].frame[4 * 3 + 2], 77);
+
+    ws2812_deinit(strips[0]);
+    ws2812_deinit(strips[1]);
+}
+
+int main(void)
+{
+    test_start_failure_keeps_changes();
+    test_prepare_failure_keeps_changes();
+    test_multi_failure_keeps_changes();
+    return HOST_TEST_RESULT();
+}